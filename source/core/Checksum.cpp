@@ -0,0 +1,72 @@
+#include "Checksum.h"
+
+#include <cstring>
+
+namespace HAYDEN
+{
+    // 64-bit MurmurHash2 (MurmurHash64A), used for ResourceFileEntry::DataCheckSum
+    uint64_t murmurHash64A(const void* data, const uint64_t size, const uint64_t seed)
+    {
+        const uint64_t m = 0xC6A4A7935BD1E995;
+        const int r = 47;
+
+        const uint8_t* bytes = (const uint8_t*)data;
+        const uint64_t numBlocks = size / 8;
+        uint64_t hash = seed ^ (size * m);
+
+        // Mixing each block doesn't depend on the hash, so it's done for a batch of blocks at a time where the compiler can vectorize it.
+        // Only folding the mixed blocks into the hash has to stay serial.
+        const uint64_t batchSize = 32;
+        uint64_t mixedBlocks[batchSize];
+
+        uint64_t i = 0;
+        for (; i + batchSize <= numBlocks; i += batchSize)
+        {
+            std::memcpy(mixedBlocks, bytes + (i * 8), sizeof(mixedBlocks));
+
+            for (uint64_t j = 0; j < batchSize; j++)
+            {
+                uint64_t k = mixedBlocks[j] * m;
+                k ^= k >> r;
+                mixedBlocks[j] = k * m;
+            }
+
+            for (uint64_t j = 0; j < batchSize; j++)
+            {
+                hash ^= mixedBlocks[j];
+                hash *= m;
+            }
+        }
+
+        for (; i < numBlocks; i++)
+        {
+            uint64_t k;
+            std::memcpy(&k, bytes + (i * 8), sizeof(uint64_t));
+
+            k *= m;
+            k ^= k >> r;
+            k *= m;
+
+            hash ^= k;
+            hash *= m;
+        }
+
+        const uint8_t* tail = bytes + (numBlocks * 8);
+        switch (size & 7)
+        {
+            case 7: hash ^= (uint64_t)tail[6] << 48; [[fallthrough]];
+            case 6: hash ^= (uint64_t)tail[5] << 40; [[fallthrough]];
+            case 5: hash ^= (uint64_t)tail[4] << 32; [[fallthrough]];
+            case 4: hash ^= (uint64_t)tail[3] << 24; [[fallthrough]];
+            case 3: hash ^= (uint64_t)tail[2] << 16; [[fallthrough]];
+            case 2: hash ^= (uint64_t)tail[1] << 8;  [[fallthrough]];
+            case 1: hash ^= (uint64_t)tail[0];
+                    hash *= m;
+        }
+
+        hash ^= hash >> r;
+        hash *= m;
+        hash ^= hash >> r;
+        return hash;
+    }
+}
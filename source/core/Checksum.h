@@ -0,0 +1,12 @@
+#pragma once
+
+#include <cstdint>
+
+namespace HAYDEN
+{
+    // Seed used for ResourceFileEntry::DataCheckSum
+    const uint64_t RESOURCE_CHECKSUM_SEED = 0;
+
+    // 64-bit MurmurHash2 (MurmurHash64A), used for ResourceFileEntry::DataCheckSum
+    uint64_t murmurHash64A(const void* data, const uint64_t size, const uint64_t seed = RESOURCE_CHECKSUM_SEED);
+}
@@ -0,0 +1,166 @@
+#include "CompressionStage.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <numeric>
+#include <thread>
+
+#include "ResourceCodec.h"
+
+namespace HAYDEN
+{
+    // What auto mode tries, cheapest first. Each is expected to take about twice as long as the one before it.
+    static const OodleSettings AUTO_CANDIDATES[] = {
+        { OodleCodec::Mermaid, 4 },
+        { OodleCodec::Kraken, 4 },
+        { OodleCodec::Kraken, 6 },
+        { OodleCodec::Leviathan, 4 },
+        { OodleCodec::Leviathan, 6 },
+        { OodleCodec::Leviathan, 8 }
+    };
+
+    size_t CompressionStage::AddStream(const std::string& name, std::vector<uint8_t> data)
+    {
+        CompressionStream stream;
+        stream.Name = name;
+        stream.Data = std::move(data);
+        _Streams.push_back(std::move(stream));
+        return _Streams.size() - 1;
+    }
+
+    // output is the worker's own buffer, kept between streams so it's only grown, never reallocated per call
+    void CompressionStage::CompressStream(CompressionStream& stream, std::vector<uint8_t>& output)
+    {
+        if (isStandInResourceCodecInUse())
+        {
+            stream.Output = stream.Data;
+            stream.IsStored = 1;
+            return;
+        }
+
+        output.resize(std::max<uint64_t>(output.size(), oodleCompressBound(stream.Data.size())));
+
+        auto compress = [&](const OodleSettings& settings) -> bool
+        {
+            auto compressStart = std::chrono::steady_clock::now();
+            uint64_t compressedSize = oodleCompress(stream.Data.data(), stream.Data.size(), output.data(), output.size(), settings);
+            std::chrono::duration<double, std::milli> compressTime = std::chrono::steady_clock::now() - compressStart;
+
+            stream.TotalMilliseconds += compressTime.count();
+            stream.NumTried++;
+
+            if (compressedSize == 0 || (!stream.Output.empty() && compressedSize >= stream.Output.size()))
+                return false;
+
+            stream.Output.assign(output.begin(), output.begin() + compressedSize);
+            stream.Settings = settings;
+            stream.Milliseconds = compressTime.count();
+            return true;
+        };
+
+        if (!_Options.IsAuto)
+        {
+            compress(_Options.Settings);
+            return;
+        }
+
+        // The first candidate always runs. After that, stop before one that's likely to go over the budget.
+        const double budget = _Options.AutoMillisecondsPerMB * std::max(stream.Data.size() / (1024.0 * 1024.0), 1.0 / 1024.0);
+        double lastMilliseconds = 0;
+
+        for (const OodleSettings& candidate : AUTO_CANDIDATES)
+        {
+            if (stream.NumTried > 0 && stream.TotalMilliseconds + lastMilliseconds * 2 > budget)
+                break;
+
+            double before = stream.TotalMilliseconds;
+            compress(candidate);
+            lastMilliseconds = stream.TotalMilliseconds - before;
+        }
+    }
+
+    // Compresses every stream. Returns false if any of them failed.
+    bool CompressionStage::Run()
+    {
+        auto stageStart = std::chrono::steady_clock::now();
+
+        std::vector<size_t> compressOrder(_Streams.size());
+        std::iota(compressOrder.begin(), compressOrder.end(), 0);
+        std::stable_sort(compressOrder.begin(), compressOrder.end(), [this](size_t a, size_t b) {
+            return _Streams[a].Data.size() > _Streams[b].Data.size();
+        });
+
+        // Each worker takes the next stream until there are none left
+        std::atomic<size_t> nextStream(0);
+        auto compressWorker = [&]()
+        {
+            std::vector<uint8_t> output;
+            for (size_t i = nextStream++; i < compressOrder.size(); i = nextStream++)
+                CompressStream(_Streams[compressOrder[i]], output);
+        };
+
+        uint32_t numThreads = _Options.NumThreads;
+        if (numThreads == 0)
+            numThreads = std::max(1u, std::thread::hardware_concurrency());
+        numThreads = std::max(1u, std::min<uint32_t>(numThreads, (uint32_t)_Streams.size()));
+
+        std::vector<std::thread> workers;
+        for (uint32_t i = 1; i < numThreads; i++)
+            workers.emplace_back(compressWorker);
+
+        compressWorker();
+        for (auto& worker : workers)
+            worker.join();
+
+        std::chrono::duration<double> stageTime = std::chrono::steady_clock::now() - stageStart;
+        _Seconds = stageTime.count();
+
+        for (const CompressionStream& stream : _Streams)
+            if (stream.Output.empty())
+                return false;
+
+        return true;
+    }
+
+    // One line per stream: sizes, ratio, MB/s and the settings used, then totals
+    void CompressionStage::PrintReport(FILE* f) const
+    {
+        fprintf(f, "%-48s %12s %12s %7s %9s %-10s %5s %6s\n", "Stream", "Input", "Output", "Ratio", "MB/s", "Codec", "Level", "Tried");
+
+        uint64_t totalInput = 0;
+        uint64_t totalOutput = 0;
+
+        for (const CompressionStream& stream : _Streams)
+        {
+            // Long names keep their end, that's the part that tells models apart
+            std::string name = stream.Name.size() > 48 ? "..." + stream.Name.substr(stream.Name.size() - 45) : stream.Name;
+
+            if (stream.Output.empty())
+            {
+                fprintf(f, "%-48s %12llu %12s\n", name.c_str(), (unsigned long long)stream.Data.size(), "FAILED");
+                continue;
+            }
+
+            if (stream.IsStored)
+            {
+                fprintf(f, "%-48s %12llu %12llu %7.2f %9s %s\n", name.c_str(),
+                    (unsigned long long)stream.Data.size(), (unsigned long long)stream.Output.size(), stream.Ratio(), "", "Stored");
+            }
+            else
+            {
+                fprintf(f, "%-48s %12llu %12llu %7.2f %9.1f %-10s %5d %6u\n", name.c_str(),
+                    (unsigned long long)stream.Data.size(), (unsigned long long)stream.Output.size(), stream.Ratio(), stream.MegabytesPerSecond(),
+                    getOodleCodecName(stream.Settings.Codec), stream.Settings.Level, stream.NumTried);
+            }
+
+            totalInput += stream.Data.size();
+            totalOutput += stream.Output.size();
+        }
+
+        double totalRatio = totalOutput > 0 ? (double)totalInput / totalOutput : 0;
+        double totalMegabytesPerSecond = _Seconds > 0 ? (totalInput / (1024.0 * 1024.0)) / _Seconds : 0;
+        fprintf(f, "%-48s %12llu %12llu %7.2f %9.1f (%.2f s wall clock)\n", "Total",
+            (unsigned long long)totalInput, (unsigned long long)totalOutput, totalRatio, totalMegabytesPerSecond, _Seconds);
+    }
+}
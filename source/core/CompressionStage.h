@@ -0,0 +1,64 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdio>
+
+#include "Oodle.h"
+
+namespace HAYDEN
+{
+    struct CompressionOptions
+    {
+        OodleSettings Settings;                 // used for every stream, unless IsAuto
+        bool IsAuto = 0;                        // try several settings per stream, keep the smallest output found within the budget
+        double AutoMillisecondsPerMB = 250;     // time auto mode may spend on one stream, per MB of input
+        uint32_t NumThreads = 0;                // 0 = one per core
+    };
+
+    // One stream to compress, and what came out of it
+    struct CompressionStream
+    {
+        std::string Name;                       // shown in the report
+        std::vector<uint8_t> Data;
+        std::vector<uint8_t> Output;            // empty if compression failed
+        OodleSettings Settings;                 // the settings Output was made with
+        bool IsStored = 0;                      // Output is Data as-is, see CompressionStage
+        double Milliseconds = 0;                // time for those settings alone
+        double TotalMilliseconds = 0;           // time for every setting tried
+        uint32_t NumTried = 0;
+
+        double Ratio() const { return Output.empty() ? 0 : (double)Data.size() / Output.size(); }
+        double MegabytesPerSecond() const { return Milliseconds > 0 ? (Data.size() / (1024.0 * 1024.0)) / (Milliseconds / 1000.0) : 0; }
+    };
+
+    // Compresses many independent streams at once, e.g. every LOD of every model in an import batch.
+    // Streams are handed to workers largest first, so one big stream doesn't end up last on its own.
+    // While the stand-in codec is in use streams are stored instead, it couldn't read Oodle output back.
+    class CompressionStage
+    {
+        public:
+
+            CompressionStage(const CompressionOptions& options) : _Options(options) {}
+
+            // Returns the stream's index, for GetStream after Run
+            size_t AddStream(const std::string& name, std::vector<uint8_t> data);
+
+            // Compresses every stream. Returns false if any of them failed.
+            bool Run();
+
+            size_t NumStreams() const { return _Streams.size(); }
+            const CompressionStream& GetStream(size_t i) const { return _Streams[i]; }
+            double GetSeconds() const { return _Seconds; }
+
+            // One line per stream: sizes, ratio, MB/s and the settings used, then totals
+            void PrintReport(FILE* f) const;
+
+        private:
+            CompressionOptions _Options;
+            std::vector<CompressionStream> _Streams;
+            double _Seconds = 0;
+
+            void CompressStream(CompressionStream& stream, std::vector<uint8_t>& output);
+    };
+}
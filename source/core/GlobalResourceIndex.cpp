@@ -0,0 +1,179 @@
+#include "GlobalResourceIndex.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+namespace HAYDEN
+{
+    // Finds every .resources and .resources.backup file under basePath, sorted by path
+    std::vector<fs::path> GlobalResourceIndex::FindArchives(const fs::path& basePath)
+    {
+        std::vector<fs::path> archives;
+        std::error_code ec;
+
+        for (fs::recursive_directory_iterator it(basePath, fs::directory_options::skip_permission_denied, ec), end; it != end; it.increment(ec))
+        {
+            if (ec)
+                break;
+
+            if (!it->is_regular_file(ec))
+                continue;
+
+            std::string fileName = it->path().filename().string();
+            if (fileName.size() > 10 && fileName.compare(fileName.size() - 10, 10, ".resources") == 0)
+                archives.push_back(it->path());
+            else if (fileName.size() > 17 && fileName.compare(fileName.size() - 17, 17, ".resources.backup") == 0)
+                archives.push_back(it->path());
+        }
+
+        std::sort(archives.begin(), archives.end());
+        return archives;
+    }
+
+    void GlobalResourceIndex::Clear()
+    {
+        _Archives.clear();
+        _Entries.clear();
+        _ChainByName.clear();
+        _NextSameName.clear();
+        _LoadTimings.clear();
+        _TotalMilliseconds = 0;
+    }
+
+    // Parses all archives under basePath on numThreads workers (0 = one per core). Returns false if none were loaded.
+    bool GlobalResourceIndex::Build(const fs::path& basePath, uint32_t numThreads, ResourceLoadProgress* progress)
+    {
+        Clear();
+        auto buildStart = std::chrono::steady_clock::now();
+
+        std::vector<fs::path> archivePaths = FindArchives(basePath);
+        if (archivePaths.empty())
+            return false;
+
+        std::vector<std::shared_ptr<ResourceFileReader>> readers(archivePaths.size());
+        std::vector<ArchiveLoadTiming> timings(archivePaths.size());
+
+        // Hand out the largest archives first, so one big archive doesn't start last and hold up the rest
+        std::vector<uint32_t> parseOrder(archivePaths.size());
+        for (uint32_t i = 0; i < parseOrder.size(); i++)
+        {
+            std::error_code ec;
+            readers[i] = std::make_shared<ResourceFileReader>(archivePaths[i]);
+            timings[i].ArchivePath = archivePaths[i];
+            timings[i].ArchiveSize = fs::file_size(archivePaths[i], ec);
+            parseOrder[i] = i;
+        }
+
+        std::stable_sort(parseOrder.begin(), parseOrder.end(), [&timings](uint32_t a, uint32_t b) {
+            return timings[a].ArchiveSize > timings[b].ArchiveSize;
+        });
+
+        // Each worker takes the next unparsed archive until there are none left
+        std::atomic<uint32_t> nextArchive(0);
+        std::atomic<uint32_t> archivesDone(0);
+        auto parseWorker = [&]()
+        {
+            for (uint32_t i = nextArchive++; i < parseOrder.size(); i = nextArchive++)
+            {
+                if (progress != NULL && progress->IsCancelled())
+                    break;
+
+                uint32_t archiveIndex = parseOrder[i];
+                auto parseStart = std::chrono::steady_clock::now();
+
+                const ResourceTable& resourceTable = readers[archiveIndex]->ParseResourceFile();
+
+                std::chrono::duration<double, std::milli> parseTime = std::chrono::steady_clock::now() - parseStart;
+                timings[archiveIndex].ParseMilliseconds = parseTime.count();
+                timings[archiveIndex].NumEntries = resourceTable.Size();
+                timings[archiveIndex].IsLoaded = !resourceTable.Empty();
+
+                // Parsed tables are never modified again, so they can be handed out as they are
+                if (progress != NULL && progress->OnBatch)
+                    progress->OnBatch(archivePaths[archiveIndex], readers[archiveIndex]->GetResourceTable(), ++archivesDone, (uint32_t)parseOrder.size());
+            }
+        };
+
+        if (numThreads == 0)
+            numThreads = std::max(1u, std::thread::hardware_concurrency());
+        numThreads = std::min<uint32_t>(numThreads, (uint32_t)parseOrder.size());
+
+        std::vector<std::thread> workers;
+        for (uint32_t i = 1; i < numThreads; i++)
+            workers.emplace_back(parseWorker);
+
+        parseWorker();
+        for (auto& worker : workers)
+            worker.join();
+
+        if (progress != NULL && progress->IsCancelled())
+            return false;
+
+        // Merge every loaded archive into one index, in path order
+        for (uint32_t i = 0; i < readers.size(); i++)
+        {
+            if (!timings[i].IsLoaded)
+                continue;
+
+            uint32_t archiveIndex = (uint32_t)_Archives.size();
+            _Archives.push_back(std::move(readers[i]));
+
+            const ResourceTable& resourceTable = _Archives[archiveIndex]->ParseResourceFile();
+            for (uint32_t j = 0; j < resourceTable.Size(); j++)
+            {
+                uint32_t refIndex = (uint32_t)_Entries.size();
+                _Entries.push_back({ archiveIndex, j });
+                _NextSameName.push_back(END_OF_CHAIN);
+
+                // Keep chains in archive order: the new entry goes on the end
+                auto chain = _ChainByName.emplace(resourceTable.GetName(j), SameNameChain{ refIndex, refIndex });
+                if (!chain.second)
+                {
+                    _NextSameName[chain.first->second.Last] = refIndex;
+                    chain.first->second.Last = refIndex;
+                }
+            }
+        }
+
+        std::chrono::duration<double, std::milli> buildTime = std::chrono::steady_clock::now() - buildStart;
+        _TotalMilliseconds = buildTime.count();
+
+        std::sort(timings.begin(), timings.end(), [](const ArchiveLoadTiming& a, const ArchiveLoadTiming& b) {
+            return a.ParseMilliseconds > b.ParseMilliseconds;
+        });
+        _LoadTimings = std::move(timings);
+
+        return !_Archives.empty();
+    }
+
+    // Every archive containing an entry with this name, in archive order. Empty if not found.
+    std::vector<ArchiveEntryRef> GlobalResourceIndex::FindEntry(std::string_view name) const
+    {
+        std::vector<ArchiveEntryRef> matches;
+
+        auto chain = _ChainByName.find(name);
+        if (chain == _ChainByName.end())
+            return matches;
+
+        for (uint32_t i = chain->second.First; i != END_OF_CHAIN; i = _NextSameName[i])
+            matches.push_back(_Entries[i]);
+
+        return matches;
+    }
+
+    void GlobalResourceIndex::PrintLoadTimings(FILE* f) const
+    {
+        fprintf(f, "Loaded %u archives, %llu entries in %.1f ms\n", GetNumArchives(), (unsigned long long)GetNumEntries(), _TotalMilliseconds);
+        for (const ArchiveLoadTiming& timing : _LoadTimings)
+        {
+            fprintf(f, "%10.1f ms  %8llu entries  %8.1f MB  %s%s\n",
+                timing.ParseMilliseconds,
+                (unsigned long long)timing.NumEntries,
+                timing.ArchiveSize / (1024.0 * 1024.0),
+                timing.ArchivePath.string().c_str(),
+                timing.IsLoaded ? "" : "  (failed)");
+        }
+    }
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <filesystem>
+
+#include "ResourceFileReader.h"
+
+namespace fs = std::filesystem;
+
+namespace HAYDEN
+{
+    // A single entry in a specific archive
+    struct ArchiveEntryRef
+    {
+        uint32_t ArchiveIndex = 0;
+        uint32_t EntryIndex = 0;
+    };
+
+    // How long a single archive took to load
+    struct ArchiveLoadTiming
+    {
+        fs::path ArchivePath;
+        uint64_t ArchiveSize = 0;
+        uint64_t NumEntries = 0;
+        double ParseMilliseconds = 0;
+        bool IsLoaded = 0;
+    };
+
+    // Index over every .resources / .resources.backup file under the game's "base" directory.
+    // Archives are parsed in parallel, then merged so any entry can be found without knowing which archive it's in.
+    class GlobalResourceIndex
+    {
+        public:
+
+            // Finds every .resources and .resources.backup file under basePath, sorted by path
+            static std::vector<fs::path> FindArchives(const fs::path& basePath);
+
+            // Parses all archives under basePath on numThreads workers (0 = one per core). Returns false if none were loaded.
+            // Each archive's table is published through progress as soon as it's parsed, from whichever worker parsed it.
+            // Cancellation is checked before each archive, a cancelled build leaves the index empty and returns false.
+            bool Build(const fs::path& basePath, uint32_t numThreads = 0, ResourceLoadProgress* progress = NULL);
+            void Clear();
+
+            uint32_t GetNumArchives() const { return (uint32_t)_Archives.size(); }
+            uint64_t GetNumEntries() const { return _Entries.size(); }
+            ResourceFileReader& GetArchive(uint32_t archiveIndex) const { return *_Archives[archiveIndex]; }
+            std::shared_ptr<ResourceFileReader> ShareArchive(uint32_t archiveIndex) const { return _Archives[archiveIndex]; }
+            const fs::path& GetArchivePath(uint32_t archiveIndex) const { return _Archives[archiveIndex]->ResourceFilePath; }
+            ResourceEntry GetEntry(ArchiveEntryRef ref) const { return _Archives[ref.ArchiveIndex]->ParseResourceFile().GetEntry(ref.EntryIndex); }
+
+            // Every entry in every archive, grouped by archive
+            const std::vector<ArchiveEntryRef>& GetAllEntries() const { return _Entries; }
+
+            // Every archive containing an entry with this name, in archive order. Empty if not found.
+            std::vector<ArchiveEntryRef> FindEntry(std::string_view name) const;
+
+            // Per-archive parse times, slowest first
+            const std::vector<ArchiveLoadTiming>& GetLoadTimings() const { return _LoadTimings; }
+            double GetTotalMilliseconds() const { return _TotalMilliseconds; }
+            void PrintLoadTimings(FILE* f = stdout) const;
+
+        private:
+            std::vector<std::shared_ptr<ResourceFileReader>> _Archives;
+            std::vector<ArchiveEntryRef> _Entries;
+
+            // First and last entry of a chain, the last one so appending doesn't walk the chain
+            struct SameNameChain
+            {
+                uint32_t First = 0;
+                uint32_t Last = 0;
+            };
+
+            // Names are views into each reader's resource table. Entries with the same name are chained through _NextSameName.
+            std::unordered_map<std::string_view, SameNameChain> _ChainByName;
+            std::vector<uint32_t> _NextSameName;
+
+            std::vector<ArchiveLoadTiming> _LoadTimings;
+            double _TotalMilliseconds = 0;
+
+            static constexpr uint32_t END_OF_CHAIN = 0xFFFFFFFF;
+    };
+}
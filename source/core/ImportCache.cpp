@@ -0,0 +1,178 @@
+#include "ImportCache.h"
+
+#include <cstring>
+
+#include "Checksum.h"
+#include "Utilities.h"
+
+namespace HAYDEN
+{
+    // The next stage's key: the previous key and this stage's settings, seeded with the stage
+    template <typename Settings>
+    static uint64_t getStageKey(ImportStage stage, uint64_t previousKey, const Settings& settings)
+    {
+        struct
+        {
+            uint64_t PreviousKey;
+            Settings StageSettings;
+        } keyData;
+
+        memset(&keyData, 0, sizeof(keyData));
+        keyData.PreviousKey = previousKey;
+        keyData.StageSettings = settings;
+        return murmurHash64A(&keyData, sizeof(keyData), (uint64_t)stage);
+    }
+
+    bool ImportCache::GetKeys(const fs::path& objPath, bool useYOrientation, const CompressionOptions& compression, ImportCacheKeys& keys)
+    {
+        FILE* f = fopen(objPath.string().c_str(), "rb");
+        if (f == NULL)
+            return false;
+
+        std::error_code ec;
+        std::vector<uint8_t> objData(fs::file_size(objPath, ec));
+        bool isRead = !ec && readFileAt(f, objData.data(), objData.size(), 0) == objData.size();
+        fclose(f);
+
+        if (!isRead)
+            return false;
+
+        // Auto mode's choice depends on its budget, fixed settings only on codec and level
+        struct
+        {
+            int32_t Codec;
+            int32_t Level;
+            int32_t IsAuto;
+            double AutoMillisecondsPerMB;
+        } compressionSettings;
+
+        memset(&compressionSettings, 0, sizeof(compressionSettings));
+        compressionSettings.IsAuto = compression.IsAuto;
+        if (compression.IsAuto)
+        {
+            compressionSettings.AutoMillisecondsPerMB = compression.AutoMillisecondsPerMB;
+        }
+        else
+        {
+            compressionSettings.Codec = (int32_t)compression.Settings.Codec;
+            compressionSettings.Level = compression.Settings.Level;
+        }
+
+        keys.Parsed = murmurHash64A(objData.data(), objData.size(), (uint64_t)ImportStage::Parsed);
+        keys.Welded = getStageKey(ImportStage::Welded, keys.Parsed, (uint64_t)0);
+        keys.Packed = getStageKey(ImportStage::Packed, keys.Welded, (uint64_t)useYOrientation);
+        keys.Compressed = getStageKey(ImportStage::Compressed, keys.Packed, compressionSettings);
+        return true;
+    }
+
+    fs::path ImportCache::GetCachePath(ImportStage stage, uint64_t key)
+    {
+        static const char* stageNames[] = { "", "parsed", "welded", "packed", "compressed" };
+        return fs::current_path() / "cache" / "import" / stageNames[(uint32_t)stage] / (intToHex(key) + ".bin");
+    }
+
+    bool ImportCache::Load(ImportStage stage, uint64_t key, std::vector<uint8_t>& data, ImportedGeometry* geometry)
+    {
+        FILE* f = fopen(GetCachePath(stage, key).string().c_str(), "rb");
+        if (f == NULL)
+            return false;
+
+        ImportCacheFileHeader header;
+        bool isValid = fread(&header, 1, sizeof(ImportCacheFileHeader), f) == sizeof(ImportCacheFileHeader);
+        isValid = isValid && header.Magic == IMPORT_CACHE_MAGIC && header.FormatVersion == IMPORT_CACHE_VERSION;
+        isValid = isValid && header.Stage == (uint32_t)stage && header.Key == key && header.HasGeometry == (geometry != NULL);
+
+        ImportCacheGeometry cacheGeometry;
+        if (isValid && geometry != NULL)
+            isValid = fread(&cacheGeometry, 1, sizeof(ImportCacheGeometry), f) == sizeof(ImportCacheGeometry);
+
+        if (isValid)
+        {
+            data.resize(header.DataSize);
+            isValid = fread(data.data(), 1, data.size(), f) == data.size();
+        }
+
+        fclose(f);
+
+        if (!isValid)
+        {
+            data.clear();
+            return false;
+        }
+
+        if (geometry != NULL)
+        {
+            geometry->DataSize = cacheGeometry.DataSize;
+            geometry->NumVertices = cacheGeometry.NumVertices;
+            geometry->NumFaces = cacheGeometry.NumFaces;
+            for (int i = 0; i < 3; i++)
+            {
+                geometry->MinBounds[i] = cacheGeometry.MinBounds[i];
+                geometry->MaxBounds[i] = cacheGeometry.MaxBounds[i];
+            }
+            geometry->MinU = cacheGeometry.MinU;
+            geometry->MinV = cacheGeometry.MinV;
+            geometry->Scale = cacheGeometry.Scale;
+        }
+
+        return true;
+    }
+
+    // Writes to a temporary file first, then renames it, so a reader never sees half an entry
+    bool ImportCache::Save(ImportStage stage, uint64_t key, const std::vector<uint8_t>& data, const ImportedGeometry* geometry)
+    {
+        fs::path cachePath = GetCachePath(stage, key);
+        fs::path tmpCachePath = cachePath;
+        tmpCachePath += ".tmp";
+
+        if (!fs::exists(cachePath.parent_path()))
+            if (!mkpath(cachePath.parent_path()))
+                return false;
+
+        FILE* f = openLongFilePath(tmpCachePath); //wb
+        if (f == NULL)
+            return false;
+
+        ImportCacheFileHeader header;
+        header.Stage = (uint32_t)stage;
+        header.HasGeometry = geometry != NULL;
+        header.Key = key;
+        header.DataSize = data.size();
+
+        bool writeFailed = fwrite(&header, 1, sizeof(ImportCacheFileHeader), f) != sizeof(ImportCacheFileHeader);
+
+        if (geometry != NULL)
+        {
+            ImportCacheGeometry cacheGeometry;
+            cacheGeometry.NumVertices = geometry->NumVertices;
+            cacheGeometry.NumFaces = geometry->NumFaces;
+            cacheGeometry.DataSize = geometry->DataSize;
+            for (int i = 0; i < 3; i++)
+            {
+                cacheGeometry.MinBounds[i] = geometry->MinBounds[i];
+                cacheGeometry.MaxBounds[i] = geometry->MaxBounds[i];
+            }
+            cacheGeometry.MinU = geometry->MinU;
+            cacheGeometry.MinV = geometry->MinV;
+            cacheGeometry.Scale = geometry->Scale;
+
+            writeFailed = writeFailed || fwrite(&cacheGeometry, 1, sizeof(ImportCacheGeometry), f) != sizeof(ImportCacheGeometry);
+        }
+
+        writeFailed = writeFailed || fwrite(data.data(), 1, data.size(), f) != data.size();
+        writeFailed = writeFailed || ferror(f) != 0;
+        fclose(f);
+
+        std::error_code ec;
+        if (!writeFailed)
+            fs::rename(tmpCachePath, cachePath, ec);
+
+        if (writeFailed || ec)
+        {
+            fs::remove(tmpCachePath, ec);
+            return false;
+        }
+
+        return true;
+    }
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+
+#include "CompressionStage.h"
+
+namespace fs = std::filesystem;
+
+namespace HAYDEN
+{
+    /**
+    *   Notes on the import cache:
+    *
+    *   Importing an OBJ goes through four stages, and each stage's output is kept in cache/import/<stage>/<key>.bin:
+    *     (a) Parsed      the sanitized OBJ text
+    *     (b) Welded      the OBJ after vendor/obj has reindexed it
+    *     (c) Packed      the geometry stream in game format, with its bounds and counts
+    *     (d) Compressed  that stream compressed, with the same bounds and counts
+    *
+    *   A stage's key is a hash of the previous stage's key and its own settings, and the first key is a hash
+    *   of the OBJ file's contents, so a changed OBJ or changed setting never reuses stale output.
+    *   Material and patching only affect the .lwo header, so a re-import that only changes those starts at the header.
+    *
+    *   The format is:
+    *     (a) an ImportCacheFileHeader, followed by
+    *     (b) an ImportCacheGeometry, for the Packed and Compressed stages, followed by
+    *     (c) DataSize bytes of stage output
+    */
+
+    const uint32_t IMPORT_CACHE_MAGIC = 0x43504D49;   // "IMPC"
+    const uint32_t IMPORT_CACHE_VERSION = 2;          // bump this whenever a stage's output changes
+
+    enum class ImportStage : uint32_t
+    {
+        Parsed = 1,
+        Welded = 2,
+        Packed = 3,
+        Compressed = 4
+    };
+
+#pragma pack(push)  // Not portable, sorry.
+#pragma pack(1)     // Works on my machine (TM).
+
+    struct ImportCacheFileHeader // 0x20 bytes
+    {
+        /* 0x00 */ uint32_t Magic = IMPORT_CACHE_MAGIC;
+        /* 0x04 */ uint32_t FormatVersion = IMPORT_CACHE_VERSION;
+        /* 0x08 */ uint32_t Stage = 0;
+        /* 0x0C */ uint32_t HasGeometry = 0;
+        /* 0x10 */ uint64_t Key = 0;
+        /* 0x18 */ uint64_t DataSize = 0;
+    };
+
+    struct ImportCacheGeometry // 0x3C bytes
+    {
+        /* 0x00 */ uint64_t NumVertices = 0;
+        /* 0x08 */ uint64_t NumFaces = 0;
+        /* 0x10 */ uint64_t DataSize = 0;
+        /* 0x18 */ float MinBounds[3] = { 0, 0, 0 };
+        /* 0x24 */ float MaxBounds[3] = { 0, 0, 0 };
+        /* 0x30 */ float MinU = 0;
+        /* 0x34 */ float MinV = 0;
+        /* 0x38 */ float Scale = 0;
+    };
+
+#pragma pack(pop)
+
+    // An OBJ's geometry, packed and ready to compress, with what the .lwo header needs to know about it
+    struct ImportedGeometry
+    {
+        std::vector<uint8_t> Data;
+        uint64_t DataSize = 0;                  // size of Data when packed, still set once Data has been handed on
+        uint64_t NumVertices = 0;
+        uint64_t NumFaces = 0;
+        float_t MinBounds[3] = { 0, 0, 0 };
+        float_t MaxBounds[3] = { 0, 0, 0 };
+        float_t MinU = 0;
+        float_t MinV = 0;
+        float_t Scale = 0;
+    };
+
+    // Keys for every stage of one import
+    struct ImportCacheKeys
+    {
+        uint64_t Parsed = 0;
+        uint64_t Welded = 0;
+        uint64_t Packed = 0;
+        uint64_t Compressed = 0;
+    };
+
+    class ImportCache
+    {
+        public:
+
+            // Reads and hashes the OBJ. Returns false if it can't be read.
+            static bool GetKeys(const fs::path& objPath, bool useYOrientation, const CompressionOptions& compression, ImportCacheKeys& keys);
+
+            static fs::path GetCachePath(ImportStage stage, uint64_t key);
+
+            // A missing or stale file returns false. geometry gets the bounds and counts saved with the stage, its Data is left alone.
+            static bool Load(ImportStage stage, uint64_t key, std::vector<uint8_t>& data, ImportedGeometry* geometry = NULL);
+            static bool Save(ImportStage stage, uint64_t key, const std::vector<uint8_t>& data, const ImportedGeometry* geometry = NULL);
+    };
+}
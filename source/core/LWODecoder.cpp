@@ -0,0 +1,296 @@
+#include "LWODecoder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "ResourceCodec.h"
+#include "ResourceFileReader.h"
+#include "Utilities.h"
+
+// SSE2 is always there on x64. Anything else uses the scalar loops.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define HAYDEN_USE_SSE2
+#endif
+
+namespace HAYDEN
+{
+    // Scalar versions of the kernels, one element at a time. Also used for whatever the SSE2 loops leave over.
+    static void dequantizePosition(const LWO_VERTEX_PACKED& packed, const float offset[3], float step, bool useYOrientation, float* position)
+    {
+        float x = packed.x * step + offset[0];
+        float y = packed.y * step + offset[1];
+        float z = packed.z * step + offset[2];
+
+        position[0] = x;
+        position[1] = useYOrientation ? z : y;
+        position[2] = useYOrientation ? -y : z;
+    }
+
+    static void dequantizeNormal(const LWO_NORMAL_PACKED& packed, bool useYOrientation, float* normal)
+    {
+        const float step = 2.0f / 255.0f;
+        float x = packed.xn * step - 1.0f;
+        float y = packed.yn * step - 1.0f;
+        float z = packed.zn * step - 1.0f;
+
+        // 8 bits per axis is rarely unit length, renormalize
+        float length = std::sqrt(std::max(x * x + y * y + z * z, 1e-12f));
+        normal[0] = x / length;
+        normal[1] = (useYOrientation ? z : y) / length;
+        normal[2] = (useYOrientation ? -y : z) / length;
+    }
+
+    static void dequantizeUV(const LWO_UV_PACKED& packed, float offsetU, float offsetV, float step, float* uv)
+    {
+        uv[0] = packed.u * step + offsetU;
+        uv[1] = packed.v * step + offsetV;
+    }
+
+    // Positions are stored as 16 bits per axis, relative to the mesh's bounding box: offset + packed / 65535 * scale
+    void dequantizePositions(const LWO_VERTEX_PACKED* packed, uint64_t count, const float offset[3], float scale, bool useYOrientation, float* positions)
+    {
+        const float step = scale / 65535.0f;
+        uint64_t i = 0;
+
+#ifdef HAYDEN_USE_SSE2
+        // Two vertices per iteration. Each store is 4 floats wide, the 4th lands on the next vertex's x and gets overwritten by it,
+        // so stop while there's still a vertex after the pair. For Y up, lanes are shuffled to x, z, y and y's scale and offset negated.
+        const __m128i zero = _mm_setzero_si128();
+        const __m128 stepV = useYOrientation ? _mm_setr_ps(step, step, -step, 0) : _mm_setr_ps(step, step, step, 0);
+        const __m128 offsetV = useYOrientation ? _mm_setr_ps(offset[0], offset[2], -offset[1], 0) : _mm_setr_ps(offset[0], offset[1], offset[2], 0);
+
+        for (; i + 3 <= count; i += 2)
+        {
+            __m128i pair = _mm_loadu_si128((const __m128i*)(packed + i));
+            __m128i first = _mm_unpacklo_epi16(pair, zero);
+            __m128i second = _mm_unpackhi_epi16(pair, zero);
+
+            if (useYOrientation)
+            {
+                first = _mm_shuffle_epi32(first, _MM_SHUFFLE(3, 1, 2, 0));
+                second = _mm_shuffle_epi32(second, _MM_SHUFFLE(3, 1, 2, 0));
+            }
+
+            _mm_storeu_ps(positions + i * 3, _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(first), stepV), offsetV));
+            _mm_storeu_ps(positions + (i + 1) * 3, _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(second), stepV), offsetV));
+        }
+#endif
+
+        for (; i < count; i++)
+            dequantizePosition(packed[i], offset, step, useYOrientation, positions + i * 3);
+    }
+
+    // Normals are stored as 8 bits per axis, mapped from -1..1 to 0..255. The tangent in the other 4 bytes is ignored.
+    void dequantizeNormals(const LWO_NORMAL_PACKED* packed, uint64_t count, bool useYOrientation, float* normals)
+    {
+        uint64_t i = 0;
+
+#ifdef HAYDEN_USE_SSE2
+        // Two normals per iteration, stored like the positions above. The 4th lane (always0) is zeroed by the scale so it doesn't add to the length.
+        const float step = 2.0f / 255.0f;
+        const __m128i zero = _mm_setzero_si128();
+        const __m128 stepV = useYOrientation ? _mm_setr_ps(step, step, -step, 0) : _mm_setr_ps(step, step, step, 0);
+        const __m128 offsetV = useYOrientation ? _mm_setr_ps(-1.0f, -1.0f, 1.0f, 0) : _mm_setr_ps(-1.0f, -1.0f, -1.0f, 0);
+        const __m128 minLengthSquared = _mm_set1_ps(1e-12f);
+
+        auto normalize = [&](__m128i words) -> __m128
+        {
+            __m128i lanes = _mm_unpacklo_epi16(words, zero);
+            if (useYOrientation)
+                lanes = _mm_shuffle_epi32(lanes, _MM_SHUFFLE(3, 1, 2, 0));
+
+            __m128 normal = _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(lanes), stepV), offsetV);
+
+            // Horizontal sum, added in the same order as the scalar version
+            __m128 squared = _mm_mul_ps(normal, normal);
+            __m128 sum = _mm_add_ps(squared, _mm_shuffle_ps(squared, squared, _MM_SHUFFLE(2, 3, 0, 1)));
+            sum = _mm_add_ps(sum, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(1, 0, 3, 2)));
+
+            return _mm_div_ps(normal, _mm_sqrt_ps(_mm_max_ps(sum, minLengthSquared)));
+        };
+
+        for (; i + 3 <= count; i += 2)
+        {
+            __m128i pair = _mm_loadu_si128((const __m128i*)(packed + i));
+            _mm_storeu_ps(normals + i * 3, normalize(_mm_unpacklo_epi8(pair, zero)));
+            _mm_storeu_ps(normals + (i + 1) * 3, normalize(_mm_unpackhi_epi8(pair, zero)));
+        }
+#endif
+
+        for (; i < count; i++)
+            dequantizeNormal(packed[i], useYOrientation, normals + i * 3);
+    }
+
+    // UVs are stored as 16 bits per axis: offset + packed / 65535 * scale. V is already flipped, origin is top left.
+    void dequantizeUVs(const LWO_UV_PACKED* packed, uint64_t count, float offsetU, float offsetV, float scale, float* uvs)
+    {
+        const float step = scale / 65535.0f;
+        uint64_t i = 0;
+
+#ifdef HAYDEN_USE_SSE2
+        // Four UVs per iteration, 16 bytes in and 32 bytes out, no overlap
+        const __m128i zero = _mm_setzero_si128();
+        const __m128 stepV = _mm_set1_ps(step);
+        const __m128 offsetUV = _mm_setr_ps(offsetU, offsetV, offsetU, offsetV);
+
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128i quad = _mm_loadu_si128((const __m128i*)(packed + i));
+            _mm_storeu_ps(uvs + i * 2, _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(quad, zero)), stepV), offsetUV));
+            _mm_storeu_ps(uvs + (i + 2) * 2, _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(quad, zero)), stepV), offsetUV));
+        }
+#endif
+
+        for (; i < count; i++)
+            dequantizeUV(packed[i], offsetU, offsetV, step, uvs + i * 2);
+    }
+
+    // True if [offset, offset + size) lies within the stream
+    static bool isInStream(uint64_t offset, uint64_t size, uint64_t streamSize)
+    {
+        return offset <= streamSize && size <= streamSize - offset;
+    }
+
+    // Every mesh of one LOD. Returns false if the stream is shorter than the headers say, or a face points past its mesh's vertices.
+    bool decodeLWOGeometry(const LWO& lwo, uint32_t lod, const uint8_t* geometry, uint64_t geometrySize, bool useYOrientation, std::vector<LWOMeshGeometry>& meshes)
+    {
+        meshes.clear();
+        if (lod >= lwo.LWOStreamDBData.size())
+            return 0;
+
+        const LWO_STREAMDB_DATA& streamData = lwo.LWOStreamDBData[lod];
+
+        // Meshes follow each other within every section
+        uint64_t firstVertex = 0;
+        uint64_t firstIndex = 0;
+
+        meshes.resize(lwo.MeshData.size());
+        for (size_t i = 0; i < lwo.MeshData.size(); i++)
+        {
+            if (lod >= lwo.MeshData[i].BMLHeaders.size())
+                return 0;
+
+            const LWO_BML_HEADER& bmlHeader = lwo.MeshData[i].BMLHeaders[lod];
+            uint64_t numVertices = bmlHeader.NumVertices;
+            uint64_t numIndices = bmlHeader.NumFacesX3;
+
+            uint64_t vertexOffset = firstVertex * sizeof(LWO_VERTEX_PACKED);
+            uint64_t normalOffset = streamData.LOD_NormalStartOffset + firstVertex * sizeof(LWO_NORMAL_PACKED);
+            uint64_t uvOffset = streamData.LOD_UVStartOffset + firstVertex * sizeof(LWO_UV_PACKED);
+            uint64_t faceOffset = streamData.LOD_FacesStartOffset + firstIndex * sizeof(uint16_t);
+
+            if (numIndices % 3 != 0
+                || !isInStream(vertexOffset, numVertices * sizeof(LWO_VERTEX_PACKED), geometrySize)
+                || !isInStream(normalOffset, numVertices * sizeof(LWO_NORMAL_PACKED), geometrySize)
+                || !isInStream(uvOffset, numVertices * sizeof(LWO_UV_PACKED), geometrySize)
+                || !isInStream(faceOffset, numIndices * sizeof(uint16_t), geometrySize))
+                return 0;
+
+            LWOMeshGeometry& mesh = meshes[i];
+            mesh.MaterialDeclName = lwo.MeshData[i].MaterialDeclName;
+            mesh.Positions.resize(numVertices * 3);
+            mesh.Normals.resize(numVertices * 3);
+            mesh.UVs.resize(numVertices * 2);
+            mesh.Indices.resize(numIndices);
+
+            const float vertexOffsets[3] = { bmlHeader.VertexOffsetX, bmlHeader.VertexOffsetY, bmlHeader.VertexOffsetZ };
+            dequantizePositions((const LWO_VERTEX_PACKED*)(geometry + vertexOffset), numVertices, vertexOffsets, bmlHeader.VertexScale, useYOrientation, mesh.Positions.data());
+            dequantizeNormals((const LWO_NORMAL_PACKED*)(geometry + normalOffset), numVertices, useYOrientation, mesh.Normals.data());
+            dequantizeUVs((const LWO_UV_PACKED*)(geometry + uvOffset), numVertices, bmlHeader.UVMapOffsetU, bmlHeader.UVMapOffsetV, bmlHeader.UVScale, mesh.UVs.data());
+
+            // The game winds faces the other way, see LWO_GEO_UNPACKED
+            const LWO_FACE_GROUP* faces = (const LWO_FACE_GROUP*)(geometry + faceOffset);
+            for (uint64_t j = 0; j < numIndices / 3; j++)
+            {
+                LWO_FACE_GROUP face = faces[j];
+                if (face.f1 >= numVertices || face.f2 >= numVertices || face.f3 >= numVertices)
+                    return 0;
+
+                mesh.Indices[j * 3 + 0] = face.f1;
+                mesh.Indices[j * 3 + 1] = face.f3;
+                mesh.Indices[j * 3 + 2] = face.f2;
+            }
+
+            firstVertex += numVertices;
+            firstIndex += numIndices;
+        }
+
+        return 1;
+    }
+
+    // The .streamdb identifier holding every LOD of a model, from its entry's StreamResourceHash
+    uint64_t getLWOStreamDBIdentifier(uint64_t streamResourceHash)
+    {
+        uint64_t streamDBIdentifier = streamResourceHash;
+        endianSwap(streamDBIdentifier);
+        streamDBIdentifier = ResourceFileReader::CalculateStreamDBIndex(streamDBIdentifier, -6);
+        endianSwap(streamDBIdentifier);
+        return streamDBIdentifier;
+    }
+
+    // Header and stream info. NumMeshes is checked first, Serialize trusts it.
+    static bool readLWOHeader(const uint8_t* data, uint64_t size, LWO& lwo)
+    {
+        LWO_HEADER header;
+        if (size < sizeof(LWO_HEADER))
+            return 0;
+
+        std::memcpy(&header, data, sizeof(LWO_HEADER));
+        if (header.NumMeshes > size / sizeof(LWO_MESH_HEADER))
+            return 0;
+
+        std::vector<uint8_t> headerData(data, data + size);
+        lwo.Serialize(headerData);
+        return lwo.SerializeStreamInfo(headerData);
+    }
+
+    // Reads a decompressed .lwo header, finds the model's geometry in streamDBs (first match wins), then decompresses and decodes one LOD
+    LWODecodeResult decodeLWOModel(const uint8_t* header, uint64_t headerSize, uint64_t streamDBIdentifier, const std::vector<std::shared_ptr<const StreamDBFile>>& streamDBs,
+        uint32_t lod, bool useYOrientation, std::vector<LWOMeshGeometry>& meshes)
+    {
+        LWO lwo;
+        if (!readLWOHeader(header, headerSize, lwo) || lod >= lwo.LWOGeoStreamDiskLayout.size())
+            return LWODecodeResult::Unsupported;
+
+        ArrayView<uint8_t> streamData;
+        for (const auto& streamDB : streamDBs)
+        {
+            streamData = streamDB->GetData(streamDBIdentifier);
+            if (!streamData.Empty())
+                break;
+        }
+
+        const LWO_GEOMETRY_STREAMDISK_LAYOUT& layout = lwo.LWOGeoStreamDiskLayout[lod];
+        if (layout.StreamCompressionType != STREAM_COMPRESSION_KRAKEN_MODEL && layout.StreamCompressionType != STREAM_COMPRESSION_NONE_MODEL)
+            return LWODecodeResult::Unsupported;
+
+        if (streamData.Empty())
+            return LWODecodeResult::NotFound;
+
+        // All LODs are in the one entry, back to back
+        uint64_t lodOffset = layout.cumulativeStreamDBCompSize;
+        if (lodOffset > streamData.Size() || layout.compressedSize > streamData.Size() - lodOffset)
+            return LWODecodeResult::Failed;
+
+        const uint8_t* geometry = streamData.Data() + lodOffset;
+        uint64_t geometrySize = layout.compressedSize;
+        std::vector<uint8_t> decompressedGeometry;
+
+        if (layout.StreamCompressionType == STREAM_COMPRESSION_KRAKEN_MODEL)
+        {
+            decompressedGeometry.resize(layout.decompressedSize + SAFE_SPACE);
+            if (decompressResource((uint16_t)ResourceCompressionMode::Kraken, geometry, layout.compressedSize, decompressedGeometry.data(), layout.decompressedSize) != layout.decompressedSize)
+                return LWODecodeResult::Failed;
+
+            geometry = decompressedGeometry.data();
+            geometrySize = layout.decompressedSize;
+        }
+
+        if (!decodeLWOGeometry(lwo, lod, geometry, geometrySize, useYOrientation, meshes))
+            return LWODecodeResult::Failed;
+
+        return LWODecodeResult::Decoded;
+    }
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+
+#include "types/LWO.h"
+#include "types/StreamDBFile.h"
+
+namespace HAYDEN
+{
+    /**
+    *   Notes on .lwo geometry streams:
+    *
+    *   The .lwo embedded in a .resources file is only a header. The geometry itself lives in a .streamdb file,
+    *   under the identifier calculated from the entry's StreamResourceHash with mipCount -6 (see ModelConverter::ConvertOBJtoLWO).
+    *   All LODs are stored back to back in that one entry, at LWO_GEOMETRY_STREAMDISK_LAYOUT::cumulativeStreamDBCompSize.
+    *
+    *   Once decompressed, a LOD is laid out as:
+    *     (a) LWO_VERTEX_PACKED for every vertex, starting at 0
+    *     (b) LWO_NORMAL_PACKED for every vertex, starting at LOD_NormalStartOffset
+    *     (c) LWO_UV_PACKED for every vertex, starting at LOD_UVStartOffset
+    *     (d) LWO_COLORS for every vertex, starting at LOD_ColorStartOffset
+    *     (e) LWO_FACE_GROUP for every triangle, starting at LOD_FacesStartOffset
+    *
+    *   With several meshes, each section holds the meshes one after another, in the order of LWO::MeshData.
+    *   Face indices are relative to the mesh's first vertex.
+    */
+
+    // One mesh of one LOD, dequantized
+    struct LWOMeshGeometry
+    {
+        std::string MaterialDeclName;
+        std::vector<float> Positions;           // x, y, z per vertex
+        std::vector<float> Normals;             // x, y, z per vertex, unit length
+        std::vector<float> UVs;                 // u, v per vertex, origin top left
+        std::vector<uint32_t> Indices;          // 3 per triangle, counter-clockwise
+
+        uint64_t NumVertices() const { return Positions.size() / 3; }
+        uint64_t NumTriangles() const { return Indices.size() / 3; }
+    };
+
+    // Dequantization kernels, SSE2 where available. Output has 3 floats per vertex (2 for UVs).
+    // useYOrientation turns the game's Z up into Y up, the inverse of what ConvertOBJtoLWO does on import.
+    void dequantizePositions(const LWO_VERTEX_PACKED* packed, uint64_t count, const float offset[3], float scale, bool useYOrientation, float* positions);
+    void dequantizeNormals(const LWO_NORMAL_PACKED* packed, uint64_t count, bool useYOrientation, float* normals);
+    void dequantizeUVs(const LWO_UV_PACKED* packed, uint64_t count, float offsetU, float offsetV, float scale, float* uvs);
+
+    // Every mesh of one LOD. geometry is that LOD's decompressed stream; lwo must have been read with SerializeStreamInfo.
+    // Returns false if the stream is shorter than the headers say, or a face points past its mesh's vertices.
+    bool decodeLWOGeometry(const LWO& lwo, uint32_t lod, const uint8_t* geometry, uint64_t geometrySize, bool useYOrientation, std::vector<LWOMeshGeometry>& meshes);
+
+    enum class LWODecodeResult
+    {
+        Decoded,
+        Unsupported,                            // a header layout or stream compression we can't read
+        NotFound,                               // geometry that isn't in any of the .streamdb files given
+        Failed                                  // geometry found, but it couldn't be decompressed or doesn't match the header
+    };
+
+    // The .streamdb identifier holding every LOD of a model, from its entry's StreamResourceHash
+    uint64_t getLWOStreamDBIdentifier(uint64_t streamResourceHash);
+
+    // Reads a decompressed .lwo header, finds the model's geometry in streamDBs (first match wins), then decompresses and decodes one LOD
+    LWODecodeResult decodeLWOModel(const uint8_t* header, uint64_t headerSize, uint64_t streamDBIdentifier, const std::vector<std::shared_ptr<const StreamDBFile>>& streamDBs,
+        uint32_t lod, bool useYOrientation, std::vector<LWOMeshGeometry>& meshes);
+}
@@ -0,0 +1,347 @@
+#include "LWOExporter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+#include "Utilities.h"
+
+namespace HAYDEN
+{
+    // Appends a space and the value. OBJ readers don't agree on nan or inf, so those are written as 0.
+    // A float needs at most 47 characters without an exponent, so the buffer always holds the whole number.
+    static void appendOBJNumber(std::string& output, float value)
+    {
+        char number[64];
+        int length = snprintf(number, sizeof(number), " %.6f", std::isfinite(value) ? value : 0.0f);
+        output.append(number, std::min<size_t>(length, sizeof(number) - 1));
+    }
+
+    // OBJ indices are 1 based and count across every object in the file.
+    // Numbers are never written with an exponent, so exported models can be imported again as they are.
+    void buildOBJ(const std::vector<LWOMeshGeometry>& meshes, std::string& output)
+    {
+        output.clear();
+        char line[256];
+        uint64_t firstVertex = 1;
+
+        for (size_t i = 0; i < meshes.size(); i++)
+        {
+            const LWOMeshGeometry& mesh = meshes[i];
+            output += "o mesh_" + std::to_string(i) + "\n";
+
+            if (!mesh.MaterialDeclName.empty())
+                output += "usemtl " + mesh.MaterialDeclName + "\n";
+
+            for (uint64_t j = 0; j < mesh.NumVertices(); j++)
+            {
+                output += "v";
+                appendOBJNumber(output, mesh.Positions[j * 3]);
+                appendOBJNumber(output, mesh.Positions[j * 3 + 1]);
+                appendOBJNumber(output, mesh.Positions[j * 3 + 2]);
+                output += "\n";
+            }
+
+            // OBJ puts the UV origin bottom left
+            for (uint64_t j = 0; j < mesh.NumVertices(); j++)
+            {
+                output += "vt";
+                appendOBJNumber(output, mesh.UVs[j * 2]);
+                appendOBJNumber(output, 1.0f - mesh.UVs[j * 2 + 1]);
+                output += "\n";
+            }
+
+            for (uint64_t j = 0; j < mesh.NumVertices(); j++)
+            {
+                output += "vn";
+                appendOBJNumber(output, mesh.Normals[j * 3]);
+                appendOBJNumber(output, mesh.Normals[j * 3 + 1]);
+                appendOBJNumber(output, mesh.Normals[j * 3 + 2]);
+                output += "\n";
+            }
+
+            for (uint64_t j = 0; j < mesh.NumTriangles(); j++)
+            {
+                unsigned long long a = firstVertex + mesh.Indices[j * 3];
+                unsigned long long b = firstVertex + mesh.Indices[j * 3 + 1];
+                unsigned long long c = firstVertex + mesh.Indices[j * 3 + 2];
+                int length = snprintf(line, sizeof(line), "f %llu/%llu/%llu %llu/%llu/%llu %llu/%llu/%llu\n", a, a, a, b, b, b, c, c, c);
+                output.append(line, std::min<size_t>(length, sizeof(line) - 1));
+            }
+
+            firstVertex += mesh.NumVertices();
+        }
+    }
+
+    // Appends text as a JSON string, quoted and escaped
+    static void appendJSONString(std::string& json, const std::string& text)
+    {
+        json += '"';
+        for (char c : text)
+        {
+            if (c == '"' || c == '\\')
+            {
+                json += '\\';
+                json += c;
+            }
+            else if ((uint8_t)c < 0x20)
+            {
+                char escaped[8];
+                snprintf(escaped, sizeof(escaped), "\\u%04x", (uint8_t)c);
+                json += escaped;
+            }
+            else
+            {
+                json += c;
+            }
+        }
+        json += '"';
+    }
+
+    // Binary glTF: a 12 byte header, then a JSON chunk describing the scene, then a BIN chunk with every buffer back to back.
+    // Each mesh gets one node and one primitive, with one material named after its decl.
+    void buildGLB(const std::vector<LWOMeshGeometry>& meshes, std::string& output)
+    {
+        const uint32_t GLB_MAGIC = 0x46546C67;          // "glTF"
+        const uint32_t GLB_CHUNK_JSON = 0x4E4F534A;     // "JSON"
+        const uint32_t GLB_CHUNK_BIN = 0x004E4942;      // "BIN\0"
+        const uint32_t GL_ARRAY_BUFFER = 34962;
+        const uint32_t GL_ELEMENT_ARRAY_BUFFER = 34963;
+        const uint32_t GL_UNSIGNED_INT = 5125;
+        const uint32_t GL_FLOAT = 5126;
+
+        std::string bin;
+        std::string nodes, gltfMeshes, materials, accessors, bufferViews;
+        uint32_t numBufferViews = 0;
+        uint32_t numAccessors = 0;
+        uint32_t numMeshes = 0;
+        char number[160];
+
+        // Every view starts 4 byte aligned, which is all the component types here need
+        auto addBufferView = [&](const void* data, uint64_t size, uint32_t target) -> uint32_t
+        {
+            snprintf(number, sizeof(number), "%s{\"buffer\":0,\"byteOffset\":%llu,\"byteLength\":%llu,\"target\":%u}",
+                numBufferViews > 0 ? "," : "", (unsigned long long)bin.size(), (unsigned long long)size, target);
+            bufferViews += number;
+
+            bin.append((const char*)data, size);
+            bin.resize((bin.size() + 3) & ~3ull, '\0');
+            return numBufferViews++;
+        };
+
+        auto addAccessor = [&](uint32_t bufferView, uint32_t componentType, uint64_t count, const char* type, const std::string& bounds) -> uint32_t
+        {
+            snprintf(number, sizeof(number), "%s{\"bufferView\":%u,\"componentType\":%u,\"count\":%llu,\"type\":\"%s\"",
+                numAccessors > 0 ? "," : "", bufferView, componentType, (unsigned long long)count, type);
+            accessors += number;
+            accessors += bounds;
+            accessors += "}";
+            return numAccessors++;
+        };
+
+        for (const LWOMeshGeometry& mesh : meshes)
+        {
+            // glTF doesn't allow empty accessors
+            if (mesh.NumVertices() == 0 || mesh.NumTriangles() == 0)
+                continue;
+
+            // POSITION must have exact bounds
+            float minBounds[3] = { mesh.Positions[0], mesh.Positions[1], mesh.Positions[2] };
+            float maxBounds[3] = { mesh.Positions[0], mesh.Positions[1], mesh.Positions[2] };
+            for (uint64_t i = 0; i < mesh.Positions.size(); i++)
+            {
+                minBounds[i % 3] = std::min(minBounds[i % 3], mesh.Positions[i]);
+                maxBounds[i % 3] = std::max(maxBounds[i % 3], mesh.Positions[i]);
+            }
+
+            snprintf(number, sizeof(number), ",\"min\":[%.9g,%.9g,%.9g],\"max\":[%.9g,%.9g,%.9g]",
+                minBounds[0], minBounds[1], minBounds[2], maxBounds[0], maxBounds[1], maxBounds[2]);
+            std::string positionBounds = number;
+
+            uint32_t positions = addAccessor(addBufferView(mesh.Positions.data(), mesh.Positions.size() * sizeof(float), GL_ARRAY_BUFFER), GL_FLOAT, mesh.NumVertices(), "VEC3", positionBounds);
+            uint32_t normals = addAccessor(addBufferView(mesh.Normals.data(), mesh.Normals.size() * sizeof(float), GL_ARRAY_BUFFER), GL_FLOAT, mesh.NumVertices(), "VEC3", "");
+            uint32_t uvs = addAccessor(addBufferView(mesh.UVs.data(), mesh.UVs.size() * sizeof(float), GL_ARRAY_BUFFER), GL_FLOAT, mesh.NumVertices(), "VEC2", "");
+            uint32_t indices = addAccessor(addBufferView(mesh.Indices.data(), mesh.Indices.size() * sizeof(uint32_t), GL_ELEMENT_ARRAY_BUFFER), GL_UNSIGNED_INT, mesh.Indices.size(), "SCALAR", "");
+
+            std::string meshName;
+            appendJSONString(meshName, mesh.MaterialDeclName.empty() ? "mesh_" + std::to_string(numMeshes) : mesh.MaterialDeclName);
+
+            snprintf(number, sizeof(number), "%s{\"mesh\":%u,\"name\":", numMeshes > 0 ? "," : "", numMeshes);
+            nodes += number + meshName + "}";
+
+            snprintf(number, sizeof(number), "%s{\"primitives\":[{\"attributes\":{\"POSITION\":%u,\"NORMAL\":%u,\"TEXCOORD_0\":%u},\"indices\":%u,\"material\":%u}],\"name\":",
+                numMeshes > 0 ? "," : "", positions, normals, uvs, indices, numMeshes);
+            gltfMeshes += number + meshName + "}";
+
+            materials += std::string(numMeshes > 0 ? "," : "") + "{\"name\":" + meshName + "}";
+            numMeshes++;
+        }
+
+        std::string json = "{\"asset\":{\"version\":\"2.0\",\"generator\":\"DOOM Eternal Model Importer\"},\"scene\":0,\"scenes\":[{\"nodes\":[";
+        for (uint32_t i = 0; i < numMeshes; i++)
+            json += (i > 0 ? "," : "") + std::to_string(i);
+        json += "]}]";
+
+        if (numMeshes > 0)
+        {
+            json += ",\"nodes\":[" + nodes + "],\"meshes\":[" + gltfMeshes + "],\"materials\":[" + materials + "]";
+            json += ",\"accessors\":[" + accessors + "],\"bufferViews\":[" + bufferViews + "]";
+            json += ",\"buffers\":[{\"byteLength\":" + std::to_string(bin.size()) + "}]";
+        }
+        json += "}";
+        json.resize((json.size() + 3) & ~3ull, ' ');
+
+        uint32_t header[3] = { GLB_MAGIC, 2, (uint32_t)(12 + 8 + json.size() + (bin.empty() ? 0 : 8 + bin.size())) };
+        uint32_t jsonChunk[2] = { (uint32_t)json.size(), GLB_CHUNK_JSON };
+        uint32_t binChunk[2] = { (uint32_t)bin.size(), GLB_CHUNK_BIN };
+
+        output.clear();
+        output.reserve(header[2]);
+        output.append((const char*)header, sizeof(header));
+        output.append((const char*)jsonChunk, sizeof(jsonChunk));
+        output += json;
+
+        if (!bin.empty())
+        {
+            output.append((const char*)binChunk, sizeof(binChunk));
+            output += bin;
+        }
+    }
+
+    enum class ModelExportResult : uint8_t
+    {
+        Exported,
+        Skipped,
+        Failed
+    };
+
+    // Result of one model, handed from the workers to the writer
+    struct ExportedModel
+    {
+        ModelExportResult Result = ModelExportResult::Failed;
+        std::string FileData;
+        uint64_t NumVertices = 0;
+        uint64_t NumTriangles = 0;
+    };
+
+    // Exports every .lwo entry matching filter to outputPath/<entry name>.obj or .glb. numThreads = 0 uses one worker per core.
+    ModelExportStats LWOExporter::Export(const fs::path& outputPath, ModelExportFormat format, const ResourceFilter& filter, uint32_t lod, uint32_t numThreads)
+    {
+        ModelExportStats stats;
+        auto exportStart = std::chrono::steady_clock::now();
+        fs::path absoluteOutputPath = fs::absolute(outputPath);
+
+        // .lwo headers only
+        ResourceFilter modelFilter = filter;
+        if (modelFilter.Version == -1)
+            modelFilter.Version = 67;
+
+        std::vector<ResourceEntry> selectedEntries = modelFilter.SelectEntries(_ResourceReader);
+
+        // All LODs of a model are in one .streamdb entry
+        std::vector<uint64_t> streamDBIdentifiers(selectedEntries.size());
+        for (size_t i = 0; i < selectedEntries.size(); i++)
+            streamDBIdentifiers[i] = getLWOStreamDBIdentifier(selectedEntries[i].StreamResourceHash);
+
+        std::vector<ExportedModel> exportedModels(selectedEntries.size());
+        const char* extension = format == ModelExportFormat::GLB ? ".glb" : ".obj";
+        bool useYOrientation = format == ModelExportFormat::GLB || UseYOrientation;
+
+        // Everything but writing happens on the workers
+        ResourcePipeline pipeline;
+        pipeline.ProcessJob = [&](ResourceJob& job)
+        {
+            ExportedModel& exportedModel = exportedModels[job.Sequence];
+            exportedModel.Result = ModelExportResult::Skipped;
+
+            std::vector<LWOMeshGeometry> meshes;
+            LWODecodeResult decodeResult = decodeLWOModel(job.Output, job.Entry.DataSizeUncompressed, streamDBIdentifiers[job.Sequence], _StreamDBs, lod, useYOrientation, meshes);
+
+            if (decodeResult == LWODecodeResult::Unsupported || decodeResult == LWODecodeResult::NotFound)
+                return;
+
+            exportedModel.Result = ModelExportResult::Failed;
+            if (decodeResult == LWODecodeResult::Failed)
+                return;
+
+            for (const LWOMeshGeometry& mesh : meshes)
+            {
+                exportedModel.NumVertices += mesh.NumVertices();
+                exportedModel.NumTriangles += mesh.NumTriangles();
+            }
+
+            if (format == ModelExportFormat::GLB)
+                buildGLB(meshes, exportedModel.FileData);
+            else
+                buildOBJ(meshes, exportedModel.FileData);
+
+            exportedModel.Result = ModelExportResult::Exported;
+        };
+
+        // Files are written on this thread, in archive order
+        pipeline.FinishJob = [&](ResourceJob& job)
+        {
+            ExportedModel& exportedModel = exportedModels[job.Sequence];
+
+            if (!job.Failed && exportedModel.Result == ModelExportResult::Skipped)
+            {
+                stats.NumSkipped++;
+                return;
+            }
+
+            bool writeFailed = job.Failed || exportedModel.Result == ModelExportResult::Failed;
+
+            fs::path filePath;
+            if (!writeFailed && !getEntryOutputPath(absoluteOutputPath, std::string(job.Entry.Name), filePath))
+                writeFailed = 1;
+
+            if (!writeFailed)
+            {
+                // "x.lwo" becomes "x.obj", names with a suffix after the extension keep it
+                if (filePath.extension() == ".lwo")
+                    filePath.replace_extension(extension);
+                else
+                    filePath += extension;
+
+                filePath.make_preferred();
+
+                if (!fs::exists(filePath.parent_path()))
+                    mkpath(filePath.parent_path());
+
+                FILE* f = openLongFilePath(filePath); //wb
+                if (f != NULL)
+                {
+                    writeFailed = fwrite(exportedModel.FileData.data(), 1, exportedModel.FileData.size(), f) != exportedModel.FileData.size();
+                    fclose(f);
+                }
+                else
+                {
+                    writeFailed = 1;
+                }
+            }
+
+            if (writeFailed)
+            {
+                fprintf(stderr, "ERROR : LWOExporter : Failed to export %s\n", std::string(job.Entry.Name).c_str());
+                stats.NumFailed++;
+            }
+            else
+            {
+                stats.NumModels++;
+                stats.NumVertices += exportedModel.NumVertices;
+                stats.NumTriangles += exportedModel.NumTriangles;
+                stats.BytesWritten += exportedModel.FileData.size();
+            }
+
+            // Only jobs still in the pipeline hold output
+            exportedModel.FileData = std::string();
+        };
+
+        pipeline.Run(_ResourceReader.ResourceFilePath, selectedEntries, numThreads);
+
+        std::chrono::duration<double> exportTime = std::chrono::steady_clock::now() - exportStart;
+        stats.Seconds = exportTime.count();
+        return stats;
+    }
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <filesystem>
+
+#include "types/LWO.h"
+#include "types/StreamDBFile.h"
+
+#include "LWODecoder.h"
+#include "ResourceFileReader.h"
+#include "ResourcePipeline.h"
+
+namespace fs = std::filesystem;
+
+namespace HAYDEN
+{
+    enum class ModelExportFormat
+    {
+        OBJ,                                    // text, one object per mesh, Y up unless told otherwise
+        GLB                                     // binary glTF 2.0, always Y up
+    };
+
+    struct ModelExportStats
+    {
+        uint64_t NumModels = 0;                 // models written successfully
+        uint64_t NumFailed = 0;                 // models that couldn't be read, decoded or written
+        uint64_t NumSkipped = 0;                // headers we can't read, or geometry that isn't in any .streamdb
+        uint64_t NumVertices = 0;
+        uint64_t NumTriangles = 0;
+        uint64_t BytesWritten = 0;
+        double Seconds = 0;
+
+        double ModelsPerSecond() const { return Seconds > 0 ? NumModels / Seconds : 0; }
+    };
+
+    // Output files, built in memory
+    void buildOBJ(const std::vector<LWOMeshGeometry>& meshes, std::string& output);
+    void buildGLB(const std::vector<LWOMeshGeometry>& meshes, std::string& output);
+
+    // Bulk export of .lwo models from a single .resources file, with their geometry taken from .streamdb files.
+    // Headers go through a ResourcePipeline. Geometry is decompressed, decoded and formatted on the workers; files are written in archive order.
+    class LWOExporter
+    {
+        public:
+
+            bool UseYOrientation = 1;           // OBJ only, glTF is always Y up
+
+            // Exports every .lwo entry matching filter to outputPath/<entry name>.obj or .glb. numThreads = 0 uses one worker per core.
+            ModelExportStats Export(const fs::path& outputPath, ModelExportFormat format, const ResourceFilter& filter, uint32_t lod = 0, uint32_t numThreads = 0);
+
+            // streamDBs are searched in order, the first one holding a model's geometry wins
+            LWOExporter(ResourceFileReader& resourceReader, std::vector<std::shared_ptr<const StreamDBFile>> streamDBs) : _ResourceReader(resourceReader), _StreamDBs(std::move(streamDBs)) {}
+
+        private:
+            ResourceFileReader& _ResourceReader;
+            std::vector<std::shared_ptr<const StreamDBFile>> _StreamDBs;
+    };
+}
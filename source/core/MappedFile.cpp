@@ -0,0 +1,101 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace HAYDEN
+{
+    // Maps the whole file read-only. Returns false if the file can't be opened or is empty.
+    bool MappedFile::Open(const fs::path& filePath)
+    {
+        Close();
+
+#ifdef _WIN32
+        // "\\?\" alongside the wide string functions is used to bypass PATH_MAX
+        std::wstring wPath = L"\\\\?\\" + fs::absolute(filePath).wstring();
+        HANDLE fileHandle = CreateFileW(wPath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (fileHandle == INVALID_HANDLE_VALUE)
+            return false;
+
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0)
+        {
+            CloseHandle(fileHandle);
+            return false;
+        }
+
+        HANDLE mappingHandle = CreateFileMappingW(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mappingHandle == NULL)
+        {
+            CloseHandle(fileHandle);
+            return false;
+        }
+
+        void* view = MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+        if (view == NULL)
+        {
+            CloseHandle(mappingHandle);
+            CloseHandle(fileHandle);
+            return false;
+        }
+
+        _FileHandle = fileHandle;
+        _MappingHandle = mappingHandle;
+        _Data = (const uint8_t*)view;
+        _Size = fileSize.QuadPart;
+#else
+        int fd = open(filePath.c_str(), O_RDONLY);
+        if (fd == -1)
+            return false;
+
+        struct stat fileStat;
+        if (fstat(fd, &fileStat) != 0 || fileStat.st_size == 0)
+        {
+            close(fd);
+            return false;
+        }
+
+        void* view = mmap(NULL, fileStat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (view == MAP_FAILED)
+        {
+            close(fd);
+            return false;
+        }
+
+        _FileDescriptor = fd;
+        _Data = (const uint8_t*)view;
+        _Size = fileStat.st_size;
+#endif
+        return true;
+    }
+
+    void MappedFile::Close()
+    {
+#ifdef _WIN32
+        if (_Data != NULL)
+            UnmapViewOfFile(_Data);
+        if (_MappingHandle != NULL)
+            CloseHandle(_MappingHandle);
+        if (_FileHandle != NULL)
+            CloseHandle(_FileHandle);
+
+        _FileHandle = NULL;
+        _MappingHandle = NULL;
+#else
+        if (_Data != NULL)
+            munmap((void*)_Data, _Size);
+        if (_FileDescriptor != -1)
+            close(_FileDescriptor);
+
+        _FileDescriptor = -1;
+#endif
+        _Data = NULL;
+        _Size = 0;
+    }
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <string>
+#include <cstring>
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+namespace HAYDEN
+{
+    // Read-only typed view over a packed array of T (in a mapped file or buffer)
+    // Elements are copied out with memcpy, so unaligned arrays are safe to read.
+    template <typename T>
+    class ArrayView
+    {
+        public:
+            const T* Data() const { return _Data; }
+            uint64_t Size() const { return _Count; }
+            bool Empty() const { return _Count == 0; }
+
+            T operator[](uint64_t i) const
+            {
+                T value;
+                std::memcpy(&value, _Data + i, sizeof(T));
+                return value;
+            }
+
+            ArrayView() {}
+            ArrayView(const uint8_t* data, uint64_t count) : _Data(reinterpret_cast<const T*>(data)), _Count(count) {}
+
+        private:
+            const T* _Data = NULL;
+            uint64_t _Count = 0;
+    };
+
+    // Read-only memory mapping of an entire file
+    class MappedFile
+    {
+        public:
+            bool Open(const fs::path& filePath);
+            void Close();
+
+            bool IsOpen() const { return _Data != NULL; }
+            const uint8_t* Data() const { return _Data; }
+            uint64_t Size() const { return _Size; }
+
+            // Returns true if [offset, offset + size) lies inside the mapping
+            bool Contains(uint64_t offset, uint64_t size) const { return offset <= _Size && size <= _Size - offset; }
+
+            MappedFile() {}
+            MappedFile(const MappedFile&) = delete;
+            MappedFile& operator=(const MappedFile&) = delete;
+            ~MappedFile() { Close(); }
+
+        private:
+            const uint8_t* _Data = NULL;
+            uint64_t _Size = 0;
+
+#ifdef _WIN32
+            void* _FileHandle = NULL;
+            void* _MappingHandle = NULL;
+#else
+            int _FileDescriptor = -1;
+#endif
+    };
+}
@@ -0,0 +1,249 @@
+#include "MaterialDeclIndex.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+#include "GlobalResourceIndex.h"
+#include "MappedFile.h"
+#include "ResourceFileReader.h"
+#include "ResourceIndex.h"
+#include "Utilities.h"
+
+namespace HAYDEN
+{
+    // One cache file per game install
+    fs::path MaterialDeclIndex::getCachePath(const fs::path& basePath)
+    {
+        std::error_code ec;
+        fs::path absolutePath = fs::absolute(basePath, ec);
+        std::string pathHash = intToHex(hashResourceName(absolutePath.generic_string()));
+
+        return fs::current_path() / "cache" / ("material2_" + pathHash + ".idx");
+    }
+
+    // Changes whenever an archive is added, removed or modified
+    uint64_t MaterialDeclIndex::getArchiveSetHash(const std::vector<fs::path>& archivePaths)
+    {
+        std::string archiveSet;
+        for (const fs::path& archivePath : archivePaths)
+        {
+            std::error_code ec;
+            archiveSet += archivePath.generic_string();
+            archiveSet += "|" + std::to_string(fs::file_size(archivePath, ec));
+            archiveSet += "|" + std::to_string(fs::last_write_time(archivePath, ec).time_since_epoch().count());
+            archiveSet += "\n";
+        }
+        return hashResourceName(archiveSet);
+    }
+
+    bool MaterialDeclIndex::loadCache(const fs::path& basePath, uint64_t archiveSetHash)
+    {
+        MappedFile cacheFile;
+        if (!cacheFile.Open(getCachePath(basePath)) || !cacheFile.Contains(0, sizeof(MaterialIndexCacheHeader)))
+            return false;
+
+        MaterialIndexCacheHeader header;
+        std::memcpy(&header, cacheFile.Data(), sizeof(MaterialIndexCacheHeader));
+
+        if (header.Magic != MATERIAL_INDEX_MAGIC || header.FormatVersion != MATERIAL_INDEX_VERSION || header.ArchiveSetHash != archiveSetHash)
+            return false;
+
+        if (header.NumNames >= cacheFile.Size() / sizeof(uint32_t) || !cacheFile.Contains(sizeof(MaterialIndexCacheHeader), (header.NumNames + 1) * sizeof(uint32_t)))
+            return false;
+
+        if (header.SizeStrings > UINT32_MAX || !cacheFile.Contains(header.AddrStrings, header.SizeStrings))
+            return false;
+
+        std::vector<uint32_t> nameOffsets(header.NumNames + 1);
+        std::memcpy(nameOffsets.data(), cacheFile.Data() + sizeof(MaterialIndexCacheHeader), nameOffsets.size() * sizeof(uint32_t));
+
+        // Offsets must start at 0, never go backwards, and end at the end of the blob
+        if (nameOffsets.front() != 0 || nameOffsets.back() != header.SizeStrings || !std::is_sorted(nameOffsets.begin(), nameOffsets.end()))
+            return false;
+
+        const char* strings = (const char*)cacheFile.Data() + header.AddrStrings;
+        _NameData.assign(strings, strings + header.SizeStrings);
+        _NameOffsets = std::move(nameOffsets);
+        return true;
+    }
+
+    bool MaterialDeclIndex::saveCache(const fs::path& basePath, uint64_t archiveSetHash) const
+    {
+        MaterialIndexCacheHeader header;
+        header.ArchiveSetHash = archiveSetHash;
+        header.NumNames = Size();
+        header.AddrStrings = sizeof(MaterialIndexCacheHeader) + (_NameOffsets.size() * sizeof(uint32_t));
+        header.SizeStrings = _NameData.size();
+
+        // Write to a temporary file first, so an interrupted write never leaves a half-written index behind
+        fs::path cachePath = getCachePath(basePath);
+        fs::path tmpCachePath = cachePath;
+        tmpCachePath.replace_extension(".idx.tmp");
+
+        if (!fs::exists(cachePath.parent_path()))
+            if (!mkpath(cachePath.parent_path()))
+                return false;
+
+        FILE* f = openLongFilePath(tmpCachePath); //wb
+        if (f == NULL)
+            return false;
+
+        fwrite(&header, sizeof(MaterialIndexCacheHeader), 1, f);
+        fwrite(_NameOffsets.data(), sizeof(uint32_t), _NameOffsets.size(), f);
+        fwrite(_NameData.data(), 1, _NameData.size(), f);
+
+        bool writeFailed = ferror(f) != 0;
+        fclose(f);
+
+        std::error_code ec;
+        if (!writeFailed)
+            fs::rename(tmpCachePath, cachePath, ec);
+
+        if (writeFailed || ec)
+        {
+            fprintf(stderr, "ERROR : MaterialDeclIndex : Failed to write %s\n", cachePath.string().c_str());
+            fs::remove(tmpCachePath, ec);
+            return false;
+        }
+
+        return true;
+    }
+
+    void MaterialDeclIndex::Clear()
+    {
+        _NameData.clear();
+        _NameOffsets.assign(1, 0);
+        _IsFromCache = 0;
+    }
+
+    // Loads the index from cache, or parses the material2 entries of every archive on numThreads workers (0 = one per core)
+    bool MaterialDeclIndex::Build(const fs::path& basePath, uint32_t numThreads)
+    {
+        Clear();
+
+        std::vector<fs::path> archivePaths = GlobalResourceIndex::FindArchives(basePath);
+        if (archivePaths.empty())
+            return false;
+
+        uint64_t archiveSetHash = getArchiveSetHash(archivePaths);
+        if (loadCache(basePath, archiveSetHash))
+        {
+            _IsFromCache = 1;
+            return true;
+        }
+
+        // Only material2 entries are parsed. Archives with a TOC sidecar are read from that instead.
+        std::vector<std::shared_ptr<const ResourceTable>> materialTables(archivePaths.size());
+        std::atomic<uint32_t> nextArchive(0);
+        auto parseWorker = [&]()
+        {
+            for (uint32_t i = nextArchive++; i < archivePaths.size(); i = nextArchive++)
+            {
+                ResourceFileReader reader(archivePaths[i]);
+                materialTables[i] = reader.ParseResourceFile([](uint32_t, std::string_view type) { return type == "material2"; });
+            }
+        };
+
+        if (numThreads == 0)
+            numThreads = std::max(1u, std::thread::hardware_concurrency());
+        numThreads = std::min<uint32_t>(numThreads, (uint32_t)archivePaths.size());
+
+        std::vector<std::thread> workers;
+        for (uint32_t i = 1; i < numThreads; i++)
+            workers.emplace_back(parseWorker);
+
+        parseWorker();
+        for (auto& worker : workers)
+            worker.join();
+
+        // Most decls appear in several archives, only keep each name once
+        std::vector<std::string_view> names;
+        for (const auto& materialTable : materialTables)
+        {
+            for (uint32_t i = 0; i < materialTable->Size(); i++)
+            {
+                if (!materialTable->GetName(i).empty())
+                    names.push_back(materialTable->GetName(i));
+            }
+        }
+
+        std::sort(names.begin(), names.end());
+        names.erase(std::unique(names.begin(), names.end()), names.end());
+
+        _NameOffsets.reserve(names.size() + 1);
+        for (std::string_view name : names)
+        {
+            _NameData.insert(_NameData.end(), name.begin(), name.end());
+            _NameOffsets.push_back((uint32_t)_NameData.size());
+        }
+
+        saveCache(basePath, archiveSetHash);
+        return true;
+    }
+
+    // Rows of names starting with prefix, in sorted order. maxResults = 0 returns every match.
+    std::vector<uint32_t> MaterialDeclIndex::FindByPrefix(std::string_view prefix, uint32_t maxResults) const
+    {
+        std::vector<uint32_t> rows;
+
+        // Names are sorted, so every match is in one run starting at the first name >= prefix
+        uint32_t low = 0;
+        uint32_t high = (uint32_t)Size();
+        while (low < high)
+        {
+            uint32_t mid = low + (high - low) / 2;
+            if (GetName(mid) < prefix)
+                low = mid + 1;
+            else
+                high = mid;
+        }
+
+        for (uint32_t i = low; i < Size() && GetName(i).substr(0, prefix.size()) == prefix; i++)
+        {
+            if (maxResults != 0 && rows.size() == maxResults)
+                break;
+
+            rows.push_back(i);
+        }
+
+        return rows;
+    }
+
+    // Rows of names containing text, in sorted order. maxResults = 0 returns every match.
+    std::vector<uint32_t> MaterialDeclIndex::FindBySubstring(std::string_view text, uint32_t maxResults) const
+    {
+        std::vector<uint32_t> rows;
+        for (uint32_t i = 0; i < Size(); i++)
+        {
+            if (maxResults != 0 && rows.size() == maxResults)
+                break;
+
+            if (GetName(i).find(text) != std::string_view::npos)
+                rows.push_back(i);
+        }
+
+        return rows;
+    }
+
+    // Prefix matches first, then the remaining substring matches
+    std::vector<uint32_t> MaterialDeclIndex::Search(std::string_view text, uint32_t maxResults) const
+    {
+        std::vector<uint32_t> rows = FindByPrefix(text, maxResults);
+        if (maxResults != 0 && rows.size() == maxResults)
+            return rows;
+
+        for (uint32_t i = 0; i < Size(); i++)
+        {
+            if (maxResults != 0 && rows.size() == maxResults)
+                break;
+
+            std::string_view name = GetName(i);
+            size_t position = name.find(text);
+            if (position != std::string_view::npos && position != 0)
+                rows.push_back(i);
+        }
+
+        return rows;
+    }
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+namespace HAYDEN
+{
+    /**
+    *   Notes on the material index cache format:
+    *
+    *   After the index is built, it's written to cache/material2_<hash of base path>.idx.
+    *   It's used as long as the set of archives under base/ (paths, sizes and modified times) hasn't changed.
+    *
+    *   The format is:
+    *     (a) a MaterialIndexCacheHeader, followed by
+    *     (b) NumNames + 1 name offsets (uint32_t), relative to AddrStrings, followed by
+    *     (c) a blob with all names, sorted and not null-terminated
+    */
+
+    const uint32_t MATERIAL_INDEX_MAGIC = 0x4C43444D;   // "MDCL"
+    const uint32_t MATERIAL_INDEX_VERSION = 1;          // bump this whenever the format changes
+
+#pragma pack(push)
+#pragma pack(1)
+
+    struct MaterialIndexCacheHeader // 0x28 bytes
+    {
+        /* 0x00 */ uint32_t Magic = MATERIAL_INDEX_MAGIC;
+        /* 0x04 */ uint32_t FormatVersion = MATERIAL_INDEX_VERSION;
+        /* 0x08 */ uint64_t ArchiveSetHash = 0;         // must match the archives found under base/
+        /* 0x10 */ uint64_t NumNames = 0;
+        /* 0x18 */ uint64_t AddrStrings = 0;
+        /* 0x20 */ uint64_t SizeStrings = 0;
+    };
+
+#pragma pack(pop)
+
+    // Every distinct material2 decl name in every archive under the game's "base" directory, sorted.
+    // Names are stored back to back in one buffer. Prefix searches are a binary search, substring searches a single scan.
+    class MaterialDeclIndex
+    {
+        public:
+
+            // Loads the index from cache, or parses the material2 entries of every archive on numThreads workers (0 = one per core).
+            // Returns false if no archives were found.
+            bool Build(const fs::path& basePath, uint32_t numThreads = 0);
+            void Clear();
+
+            uint64_t Size() const { return _NameOffsets.size() - 1; }
+            bool Empty() const { return Size() == 0; }
+            std::string_view GetName(uint32_t i) const { return std::string_view(_NameData.data() + _NameOffsets[i], _NameOffsets[i + 1] - _NameOffsets[i]); }
+
+            // Rows of matching names, in sorted order. maxResults = 0 returns every match.
+            std::vector<uint32_t> FindByPrefix(std::string_view prefix, uint32_t maxResults = 0) const;
+            std::vector<uint32_t> FindBySubstring(std::string_view text, uint32_t maxResults = 0) const;
+
+            // Prefix matches first, then the remaining substring matches
+            std::vector<uint32_t> Search(std::string_view text, uint32_t maxResults = 0) const;
+
+            bool IsFromCache() const { return _IsFromCache; }
+
+        private:
+            std::vector<char> _NameData;
+            std::vector<uint32_t> _NameOffsets = { 0 };
+            bool _IsFromCache = 0;
+
+            static fs::path getCachePath(const fs::path& basePath);
+            static uint64_t getArchiveSetHash(const std::vector<fs::path>& archivePaths);
+            bool loadCache(const fs::path& basePath, uint64_t archiveSetHash);
+            bool saveCache(const fs::path& basePath, uint64_t archiveSetHash) const;
+    };
+}
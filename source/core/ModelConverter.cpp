@@ -4,6 +4,12 @@ using namespace HAYDEN;
 
 namespace HAYDEN
 {
+    static void appendData(std::vector<uint8_t>& buffer, const void* data, const size_t size)
+    {
+        const uint8_t* bytes = (const uint8_t*)data;
+        buffer.insert(buffer.end(), bytes, bytes + size);
+    }
+
     void ModelConverter::ThrowError(bool isFatal, std::string errorMessage, std::string errorDetail)
     {
         _LastErrorMessage = errorMessage;
@@ -17,7 +23,7 @@ namespace HAYDEN
         return;
     }
 
-    bool ModelConverter::LoadResource(const std::string resourcePath)
+    bool ModelConverter::LoadResource(const std::string resourcePath, ResourceLoadProgress* progress)
     {
         // Get base path from resource path
         auto baseIndex = resourcePath.find("base");
@@ -32,8 +38,8 @@ namespace HAYDEN
         }
         _BasePath = resourcePath.substr(0, baseIndex + 4);
 
-        // Make sure we have Oodle DLL available
-        if (!oodleInit(_BasePath))
+        // Make sure we have Oodle DLL available, or a stand-in for it
+        if (!oodleInit(_BasePath) && !isStandInResourceCodecInUse())
         {
             ThrowError(1,
                 "Failed to load the oodle dll.",
@@ -55,9 +61,21 @@ namespace HAYDEN
                 return 0;
             }
 
-            // load .resources file data
-            ResourceFileReader reader(_ResourcePath);
-            _ResourceData = reader.ParseResourceFile();
+            // load .lwo entries only, everything else is parsed the first time it's needed
+            _GlobalIndex.reset();
+            _ResourceReader = ResourceSession::Get().GetReader(_ResourcePath);
+            _ModelTable = _ResourceReader->ParseResourceFile([](uint32_t version, std::string_view) { return version == 67; }, progress);
+
+            // cancelled loads leave nothing behind
+            if (progress != NULL && progress->IsCancelled())
+            {
+                _ResourceReader.reset();
+                _ModelTable.reset();
+                return 0;
+            }
+
+            // selecting and converting a model later only needs these entries, whichever converter does it
+            ResourceSession::Get().AddPartialTable(_ResourcePath, _ModelTable);
         }
         catch (...)
         {
@@ -69,61 +87,157 @@ namespace HAYDEN
         return 1;
     }
 
-    fs::path ModelConverter::ExtractLWOHeader(fs::path lwoPath, fs::path resourcePath, bool temporaryExtraction, std::string streamDBIndexStr = "")
+    bool ModelConverter::LoadAllResources(const std::string basePath, ResourceLoadProgress* progress)
     {
-        // parse resource file
-        ResourceFileReader resourceReader(resourcePath);
-        std::vector<ResourceEntry> resourceEntries = resourceReader.ParseResourceFile();
+        // Accept either the game directory or its "base" directory
+        fs::path baseDir = fs::path(basePath).lexically_normal();
+        if (!baseDir.has_filename())
+            baseDir = baseDir.parent_path();
 
-        // find the modelFullName we're looking for
-        ResourceEntry targetEntry;
-        for (int i = 0; i < resourceEntries.size(); i++)
+        if (baseDir.filename() != "base" && fs::is_directory(baseDir / "base"))
+            baseDir /= "base";
+
+        if (baseDir.filename() != "base" || !fs::is_directory(baseDir))
         {
-            if (resourceEntries[i].Name != lwoPath)
-                continue;
+            ThrowError(1,
+                "Failed to load .resource files.",
+                "Please select your Doom Eternal directory or its \"base\" directory."
+            );
+            _HasResourceLoadError = 1;
+            return 0;
+        }
+        _BasePath = baseDir.string();
 
-            // found, stop looking
-            targetEntry = resourceEntries[i];
-            break;
+        // Make sure we have Oodle DLL available, or a stand-in for it
+        if (!oodleInit(_BasePath) && !isStandInResourceCodecInUse())
+        {
+            ThrowError(1,
+                "Failed to load the oodle dll.",
+                "Make sure the oo2core_8_win64.dll file is present in your game directory."
+            );
+            _HasResourceLoadError = 1;
+            return 0;
         }
 
-        // extract the header
-        std::vector<uint8_t> targetData;
-        FILE* f = fopen(resourcePath.string().c_str(), "rb");
+        // Parse every archive under base/ in parallel
+        _HasResourceLoadError = 0;
+        _ResourceReader.reset();
+        _ModelTable.reset();
+        _GlobalIndex = std::make_unique<GlobalResourceIndex>();
 
-        if (f != NULL)
+        if (!_GlobalIndex->Build(baseDir, 0, progress))
         {
-            targetData = resourceReader.GetEmbeddedFileHeader(f, targetEntry.DataOffset, targetEntry.DataSize, targetEntry.DataSizeUncompressed);
-            fclose(f);
+            _GlobalIndex.reset();
+
+            // cancelled loads leave nothing behind
+            if (progress != NULL && progress->IsCancelled())
+                return 0;
+
+            ThrowError(0, "Failed to read .resources files.", "No .resources or .resources.backup files were found in " + _BasePath + ".");
+            _HasResourceLoadError = 1;
+            return 0;
         }
 
-        fs::path lwoFile = lwoPath.filename();
-        fs::path modelHeader = lwoFile;
+        // every archive is parsed now, later lookups in any of them go through the session
+        for (uint32_t i = 0; i < _GlobalIndex->GetNumArchives(); i++)
+            ResourceSession::Get().AddReader(_GlobalIndex->ShareArchive(i));
 
-        // create resource directory for file export
-        if (!temporaryExtraction)
+        _GlobalIndex->PrintLoadTimings();
+        return 1;
+    }
+
+    ResourceFileReader& ModelConverter::GetResourceReader(const fs::path& resourcePath)
+    {
+        if (!_ResourceReader || _ResourceReader->ResourceFilePath != resourcePath)
+            _ResourceReader = ResourceSession::Get().GetReader(resourcePath);
+
+        return *_ResourceReader;
+    }
+
+    ExtractionStats ModelConverter::ExtractResources(fs::path outputPath, const ResourceFilter& filter, uint32_t numThreads)
+    {
+        if (!_ResourceReader)
+            return ExtractionStats();
+
+        ResourceExtractor extractor(*_ResourceReader);
+        return extractor.Extract(outputPath, filter, numThreads);
+    }
+
+    VerificationStats ModelConverter::VerifyResources(const ResourceFilter& filter, uint32_t numThreads)
+    {
+        if (!_ResourceReader)
+            return VerificationStats();
+
+        ResourceVerifier verifier(*_ResourceReader);
+        return verifier.Verify(filter, numThreads);
+    }
+
+    // Compares the loaded .resources file against originalPath, usually its .resources.backup
+    DiffStats ModelConverter::DiffResources(fs::path originalPath, const ResourceFilter& filter, uint32_t numThreads)
+    {
+        if (!_ResourceReader)
+            return DiffStats();
+
+        std::shared_ptr<ResourceFileReader> originalReader = ResourceSession::Get().GetReader(originalPath);
+        ResourceDiff diff(*originalReader, *_ResourceReader);
+        return diff.Compare(filter, numThreads);
+    }
+
+    // Exports the .lwo models of the loaded .resources file. Without streamDBPaths, every .streamdb under base is searched, newest patch first.
+    ModelExportStats ModelConverter::ExportModels(fs::path outputPath, ModelExportFormat format, const ResourceFilter& filter, uint32_t lod, uint32_t numThreads, std::vector<fs::path> streamDBPaths)
+    {
+        if (!_ResourceReader)
+            return ModelExportStats();
+
+        if (streamDBPaths.empty())
+            streamDBPaths = StreamDBFile::FindStreamDBs(_BasePath);
+
+        std::vector<std::shared_ptr<const StreamDBFile>> streamDBs;
+        for (const fs::path& streamDBPath : streamDBPaths)
         {
-            // create import and streamdb folders
-            fs::path importPath = "imports";
-            std::string lwoFileNameForImportPath = lwoPath.filename().replace_extension("").string();
-            fs::path thisImportPath = importPath / fs::path(lwoFileNameForImportPath + "_id#" + streamDBIndexStr);
-            fs::path resourceName = resourcePath.filename().replace_extension("").replace_extension("");    // twice in case of resources.backup
-            fs::path resourceImportPath = thisImportPath / resourceName;
+            auto streamDB = std::make_shared<const StreamDBFile>(streamDBPath);
+            if (streamDB->IsLoaded())
+                streamDBs.push_back(streamDB);
+        }
 
-            if (!fs::exists(resourceImportPath))
-                if (!mkpath(resourceImportPath))
-                    fprintf(stderr, "Error: Failed to create directories for file: %s \n", resourceImportPath.string().c_str());
+        LWOExporter exporter(*_ResourceReader, streamDBs);
+        return exporter.Export(outputPath, format, filter, lod, numThreads);
+    }
 
+    // imports/<model>_id#<streamdb index>/<resource name>/<lwo path>, where an imported header is written. Nothing is created here.
+    fs::path ModelConverter::GetLWOHeaderImportPath(fs::path lwoPath, fs::path resourcePath, std::string streamDBIndexStr)
+    {
+        fs::path importPath = "imports";
+        std::string lwoFileNameForImportPath = lwoPath.filename().replace_extension("").string();
+        fs::path thisImportPath = importPath / fs::path(lwoFileNameForImportPath + "_id#" + streamDBIndexStr);
+        fs::path resourceName = resourcePath.filename().replace_extension("").replace_extension("");    // twice in case of resources.backup
 
-            // create model path within resource directory
-            fs::path modelPath = resourceImportPath / lwoPath.remove_filename();
-            modelPath.make_preferred();
+        fs::path modelHeader = thisImportPath / resourceName / lwoPath;
+        modelHeader.make_preferred();
+        return modelHeader;
+    }
 
-            if (!fs::exists(modelPath))
-                if (!mkpath(modelPath))
-                    fprintf(stderr, "Error: Failed to create directories for file: %s \n", modelPath.string().c_str());
+    fs::path ModelConverter::ExtractLWOHeader(fs::path lwoPath, fs::path resourcePath, bool temporaryExtraction, std::string streamDBIndexStr = "")
+    {
+        // extract the header - the session only reads and decompresses it the first time
+        std::shared_ptr<const std::vector<uint8_t>> targetData = ResourceSession::Get().GetEmbeddedFile(resourcePath, lwoPath.generic_string());
+        if (!targetData)
+        {
+            fprintf(stderr, "Error: Failed to find %s in %s \n", lwoPath.string().c_str(), resourcePath.string().c_str());
+            targetData = std::make_shared<const std::vector<uint8_t>>();
+        }
 
-            modelHeader = modelPath / lwoFile;
+        fs::path lwoFile = lwoPath.filename();
+        fs::path modelHeader = lwoFile;
+
+        // create resource directory for file export
+        if (!temporaryExtraction)
+        {
+            modelHeader = GetLWOHeaderImportPath(lwoPath, resourcePath, streamDBIndexStr);
+
+            if (!fs::exists(modelHeader.parent_path()))
+                if (!mkpath(modelHeader.parent_path()))
+                    fprintf(stderr, "Error: Failed to create directories for file: %s \n", modelHeader.parent_path().string().c_str());
         }
         else
         {
@@ -137,7 +251,7 @@ namespace HAYDEN
         FILE* wf = openLongFilePath(modelHeaderPathWideStr); //wb
         if (wf != NULL)
         {
-            fwrite(targetData.data(), 1, targetData.size(), wf);
+            fwrite(targetData->data(), 1, targetData->size(), wf);
             fclose(wf);
         }
 
@@ -149,28 +263,17 @@ namespace HAYDEN
         OBJFile objFile(objPath);
         std::vector<std::string> meshInfo;
 
+        // Nothing if the file can't be read, or has a line that doesn't parse.
+        // Exponent notation ("1.5e+02") parses fine, it doesn't need to be rejected here.
+        if (!objFile.IsLoaded())
+            return meshInfo;
+
         // Read mesh data into vector
         for (int i = 0; i < objFile.Objects.size(); i++)
         {
             meshInfo.push_back(objFile.Objects[i].ObjectName);
         }
 
-        // Return early if too many meshes
-        if (meshInfo.size() > 1)
-        {
-            return meshInfo;
-        }
-
-        // Make sure vertex data is readable
-        for (int i = 0; i < objFile.Objects[0].Vertices.size(); i++)
-        {
-            if (objFile.Objects[0].Vertices[i].rfind("e+") != -1)
-            {
-                meshInfo.resize(0);
-                return meshInfo;
-            }
-        }
-
         return meshInfo;
     }
 
@@ -179,16 +282,16 @@ namespace HAYDEN
         LWO LWOHeader;
         std::vector<std::string> meshInfo;
 
-        // Extract and serialize .lwo header file
-        fs::path localLWOPath = ExtractLWOHeader(lwoPath, resourcePath, 1);
-        LWOHeader.Serialize(localLWOPath);
+        // Serialize .lwo header straight from the session, nothing is written to disk
+        std::shared_ptr<const std::vector<uint8_t>> lwoHeaderData = ResourceSession::Get().GetEmbeddedFile(resourcePath, lwoPath.generic_string());
+        if (!lwoHeaderData)
+            return meshInfo;
 
-        // Remove temporary extracted file
-        fs::remove(localLWOPath);
+        LWOHeader.Serialize(*lwoHeaderData);
 
         // This checks for a parse error - if our decl strlen is too long or < 0 we know it messed up somewhere. Abort.
         int64_t lastIndex = LWOHeader.MeshData.size();
-        if (LWOHeader.MeshData[lastIndex - 1].MeshHeader.DeclStrlen < 0 || LWOHeader.MeshData[lastIndex - 1].MeshHeader.DeclStrlen > 1024)
+        if (lastIndex == 0 || LWOHeader.MeshData[lastIndex - 1].MeshHeader.DeclStrlen < 0 || LWOHeader.MeshData[lastIndex - 1].MeshHeader.DeclStrlen > 1024)
         {
             return meshInfo;
         }
@@ -202,16 +305,12 @@ namespace HAYDEN
         return meshInfo;
     }
 
-    int ModelConverter::ConvertOBJtoLWO(fs::path gamePath, fs::path inputOBJ, fs::path targetLWO, fs::path resourcePath, std::string material2decl, bool useYOrientation)
+    // Reads an OBJ and packs its geometry the way the game stores it, ready to compress.
+    // With UseImportCache, each stage starts from the cached output of the one before it where there is one.
+    bool ModelConverter::BuildImportGeometry(const fs::path& inputOBJ, bool useYOrientation, const ImportCacheKeys& keys, ImportedGeometry& geometry)
     {
-        fs::path basePath = gamePath / "base";
-
-        // Make sure we have Oodle DLL available
-        if (!oodleInit(basePath.string()))
-            return 0;
-
-        // Load the original OBJ data into memory
-        OBJFile inputOBJData(inputOBJ);
+        if (UseImportCache && ImportCache::Load(ImportStage::Packed, keys.Packed, geometry.Data, &geometry))
+            return true;
 
         // Use temporary files to avoid overwriting originals
         fs::path tmpOBJFile = inputOBJ;
@@ -219,27 +318,53 @@ namespace HAYDEN
         tmpOBJFile.replace_extension(".obj.tmp");
         tmpMTLFile.replace_extension(".mtl.tmp");
 
-        // Write the original OBJ data to our temporary file
-        // We aren't using fs::copy_file because we *do not* want an identical copy.
-        // Our OBJ constructor also sanitizes the file. We need this sanitized version to avoid assertion errors in vendor/obj.
-        std::ofstream outfile(tmpOBJFile);
-        if (outfile.is_open())
+        std::vector<uint8_t> weldedOBJ;
+        if (UseImportCache && ImportCache::Load(ImportStage::Welded, keys.Welded, weldedOBJ))
         {
-            for (int i = 0; i < inputOBJData.Lines.size(); i++)
+            std::ofstream outfile(tmpOBJFile, std::ios::binary);
+            outfile.write((const char*)weldedOBJ.data(), weldedOBJ.size());
+        }
+        else
+        {
+            // The original OBJ data, sanitized
+            // We aren't using fs::copy_file because we *do not* want an identical copy.
+            // We need this sanitized version to avoid assertion errors in vendor/obj.
+            std::vector<uint8_t> parsedOBJ;
+            if (!UseImportCache || !ImportCache::Load(ImportStage::Parsed, keys.Parsed, parsedOBJ))
             {
-                std::string line = inputOBJData.Lines[i].lineData;
-                outfile << line << "\n";
+                if (!OBJFile::ReadSanitized(inputOBJ, parsedOBJ))
+                    return 0;
+
+                if (UseImportCache)
+                    ImportCache::Save(ImportStage::Parsed, keys.Parsed, parsedOBJ);
             }
-        }
-        outfile.close();
 
-        // Now use vendor/obj tool on our "sanitized" OBJ file
-        // This tool will reindex the OBJ file verts/faces to make it OpenGL/Vulkan compatible
-        obj* objFile = obj_create(tmpOBJFile.string().c_str());
-        obj_write(objFile, tmpOBJFile.string().c_str(), tmpMTLFile.string().c_str(), 8); // precision 8
+            // Write the sanitized OBJ data to our temporary file
+            std::ofstream outfile(tmpOBJFile, std::ios::binary);
+            outfile.write((const char*)parsedOBJ.data(), parsedOBJ.size());
+            outfile.close();
+
+            // Now use vendor/obj tool on our "sanitized" OBJ file
+            // This tool will reindex the OBJ file verts/faces to make it OpenGL/Vulkan compatible
+            obj* objFile = obj_create(tmpOBJFile.string().c_str());
+            obj_write(objFile, tmpOBJFile.string().c_str(), tmpMTLFile.string().c_str(), 8); // precision 8
+
+            if (UseImportCache)
+            {
+                std::ifstream weldedFile(tmpOBJFile, std::ios::binary);
+                weldedOBJ.assign(std::istreambuf_iterator<char>(weldedFile), std::istreambuf_iterator<char>());
+                ImportCache::Save(ImportStage::Welded, keys.Welded, weldedOBJ);
+            }
+        }
 
         // Read the Vulkan compatible OBJ back into memory
         OBJFile objVulkan(tmpOBJFile);
+        if (!objVulkan.IsLoaded())
+        {
+            fs::remove(tmpOBJFile);
+            fs::remove(tmpMTLFile);
+            return 0;
+        }
 
         // Construct LWO geometry from our OBJ data
         // This is an intermediate format for ease of use, still needs to be processed & packed into game format
@@ -305,81 +430,149 @@ namespace HAYDEN
         LWO_GEO_PACKED lwoGeoPacked;
         lwoGeoPacked.PackGeometry(lwoGeo, minX, minY, minZ, minU, minV, scale);
 
+        // Geometry stream: vertices, normals, UVs, colors, then faces
+        appendData(geometry.Data, lwoGeoPacked.Vertices.data(), lwoGeoPacked.Vertices.size() * sizeof(LWO_VERTEX_PACKED));
+        appendData(geometry.Data, lwoGeoPacked.Normals.data(), lwoGeoPacked.Normals.size() * sizeof(LWO_NORMAL_PACKED));
+        appendData(geometry.Data, lwoGeoPacked.UVs.data(), lwoGeoPacked.UVs.size() * sizeof(LWO_UV_PACKED));
+        appendData(geometry.Data, lwoGeoPacked.Colors.data(), lwoGeoPacked.Colors.size() * sizeof(LWO_COLORS));
+        appendData(geometry.Data, lwoGeoPacked.Faces.data(), lwoGeoPacked.Faces.size() * sizeof(LWO_FACE_GROUP));
+
+        geometry.DataSize = geometry.Data.size();
+        geometry.NumVertices = lwoGeoPacked.Vertices.size();
+        geometry.NumFaces = lwoGeoPacked.Faces.size();
+        geometry.MinBounds[0] = minX;
+        geometry.MinBounds[1] = minY;
+        geometry.MinBounds[2] = minZ;
+        geometry.MaxBounds[0] = maxX;
+        geometry.MaxBounds[1] = maxY;
+        geometry.MaxBounds[2] = maxZ;
+        geometry.MinU = minU;
+        geometry.MinV = minV;
+        geometry.Scale = scale;
+
+        // Remove the temporary OBJ/MTL files
+        fs::remove(tmpOBJFile);
+        fs::remove(tmpMTLFile);
+
+        if (UseImportCache)
+            ImportCache::Save(ImportStage::Packed, keys.Packed, geometry.Data, &geometry);
+
+        return true;
+    }
+
+    // Points the .lwo header at the compressed geometry, then writes it (and the loose geometry file, or adds it to streamDBWriter).
+    // headerPatch, if given, gets the header so the caller can patch it into the .resources file once the geometry is on disk.
+    int ModelConverter::WriteImportedModel(fs::path targetLWO, fs::path resourcePath, std::string material2decl, const ImportedGeometry& geometry, const std::vector<uint8_t>& compressedGeometry, StreamDBWriter* streamDBWriter, ResourcePatch* headerPatch)
+    {
+        float_t minX = geometry.MinBounds[0];
+        float_t minY = geometry.MinBounds[1];
+        float_t minZ = geometry.MinBounds[2];
+        float_t maxX = geometry.MaxBounds[0];
+        float_t maxY = geometry.MaxBounds[1];
+        float_t maxZ = geometry.MaxBounds[2];
+        float_t minU = geometry.MinU;
+        float_t minV = geometry.MinV;
+        float_t scale = geometry.Scale;
+
         // Get the hashID for this file in .streamdb
-        ResourceFileReader resourceFileReader(resourcePath);
-        uint64_t resourceIndex = resourceFileReader.GetResourceIndex(targetLWO);
+        ResourceFileReader& resourceFileReader = GetResourceReader(resourcePath);
+        std::optional<ResourceEntry> targetEntry = ResourceSession::Get().FindEntry(resourcePath, targetLWO.generic_string());
+        uint64_t resourceIndex = targetEntry ? targetEntry->StreamResourceHash : 0;
         endianSwap(resourceIndex);
         uint64_t streamDBIndex = resourceFileReader.CalculateStreamDBIndex(resourceIndex, -6);
         endianSwap(streamDBIndex);
 
-        // create import and streamdb folders
+        // import folder, named after the streamdb index
         fs::path importPath = "imports";
 
         std::string lwoFileNameForImportPath = targetLWO.filename().replace_extension("").string();
         std::string indexStringForImportPath = std::to_string(streamDBIndex);
 
-        fs::path thisImportPath = importPath / fs::path(lwoFileNameForImportPath + "_id#" + indexStringForImportPath);
-        fs::path streamdbPath =  thisImportPath / fs::path("streamdb");
-
-        if (!fs::exists(streamdbPath))
-            if (!mkpath(streamdbPath))
-                fprintf(stderr, "Error: Failed to create directories for file: %s \n", streamdbPath.string().c_str());
+        // Compressed already, either path below writes it as-is. Kraken output is never exactly the input size,
+        // so geometry that is stored (with the stand-in codec) is told apart by its size.
+        uint64_t decompressedSize = geometry.DataSize;
+        int compressedSize = (int)compressedGeometry.size();
+        bool isStored = (uint64_t)compressedSize == decompressedSize;
 
-        // create model path within streamdb directory
-        fs::path lwoPathNoFilename = targetLWO;
-        fs::path modelPath = streamdbPath / lwoPathNoFilename.remove_filename();
-        modelPath.make_preferred();
+        if (compressedSize > 0 && streamDBWriter != NULL)
+        {
+            // Straight into the .streamdb container. The header below points LODs 0-2 at the same stream one after another,
+            // so the entry holds three copies of it.
+            std::vector<uint8_t> streamDBData;
+            streamDBData.reserve(compressedGeometry.size() * 3);
+            for (int i = 0; i < 3; i++)
+                streamDBData.insert(streamDBData.end(), compressedGeometry.begin(), compressedGeometry.end());
+
+            streamDBWriter->AddEntry(streamDBIndex, std::move(streamDBData));
+        }
+        else if (compressedSize > 0)
+        {
+            fs::path thisImportPath = importPath / fs::path(lwoFileNameForImportPath + "_id#" + indexStringForImportPath);
+            fs::path streamdbPath =  thisImportPath / fs::path("streamdb");
 
-        if (!fs::exists(modelPath))
-            if (!mkpath(modelPath))
-                fprintf(stderr, "Error: Failed to create directories for file: %s \n", modelPath.string().c_str());
+            if (!fs::exists(streamdbPath))
+                if (!mkpath(streamdbPath))
+                    fprintf(stderr, "Error: Failed to create directories for file: %s \n", streamdbPath.string().c_str());
 
-        // Write to .lwo binary file
-        fs::path modelBody = targetLWO.filename().replace_extension("");
-        modelBody = modelPath / modelBody;
-        std::string modelBodyStr = modelBody.string() + "_id#" + std::to_string(streamDBIndex) + ".lwo";
+            // create model path within streamdb directory
+            fs::path lwoPathNoFilename = targetLWO;
+            fs::path modelPath = streamdbPath / lwoPathNoFilename.remove_filename();
+            modelPath.make_preferred();
 
-        uint64_t decompressedSize = 0;
-        fs::path modelBodyPathWideStr = fs::current_path() / fs::path(modelBodyStr);
+            if (!fs::exists(modelPath))
+                if (!mkpath(modelPath))
+                    fprintf(stderr, "Error: Failed to create directories for file: %s \n", modelPath.string().c_str());
 
-        FILE* f = openLongFilePath(modelBodyPathWideStr); //wb
+            // Write to .lwo binary file
+            fs::path modelBody = targetLWO.filename().replace_extension("");
+            modelBody = modelPath / modelBody;
+            std::string modelBodyStr = modelBody.string() + "_id#" + std::to_string(streamDBIndex) + ".lwo";
 
-        if (f != NULL)
-        {
-            for (int i = 0; i < lwoGeoPacked.Vertices.size(); i++)
-                fwrite(&lwoGeoPacked.Vertices[i], sizeof(LWO_VERTEX_PACKED), 1, f);
+            fs::path modelBodyPathWideStr = fs::current_path() / fs::path(modelBodyStr);
 
-            for (int i = 0; i < lwoGeoPacked.Normals.size(); i++)
-                fwrite(&lwoGeoPacked.Normals[i], sizeof(LWO_NORMAL_PACKED), 1, f);
+            // Loose geometry file: streamdb magic, then 3 LODs all pointing at the one compressed stream after the header
+            std::vector<uint8_t> modelBodyData;
+            uint64_t streamDBMagic = 4775026447650804819;
+            uint32_t lodCount = 3;
+            uint32_t lodDataOffset = 36;
+            uint32_t lodDataLength = compressedSize;
 
-            for (int i = 0; i < lwoGeoPacked.UVs.size(); i++)
-                fwrite(&lwoGeoPacked.UVs[i], sizeof(LWO_UV_PACKED), 1, f);
+            appendData(modelBodyData, &streamDBMagic, sizeof(streamDBMagic));
+            appendData(modelBodyData, &lodCount, sizeof(lodCount));
+            for (uint32_t i = 0; i < lodCount; i++)
+            {
+                appendData(modelBodyData, &lodDataOffset, sizeof(lodDataOffset));
+                appendData(modelBodyData, &lodDataLength, sizeof(lodDataLength));
+            }
+            appendData(modelBodyData, compressedGeometry.data(), compressedGeometry.size());
 
-            for (int i = 0; i < lwoGeoPacked.Colors.size(); i++)
-                fwrite(&lwoGeoPacked.Colors[i], sizeof(LWO_COLORS), 1, f);
+            FILE* f = openLongFilePath(modelBodyPathWideStr); //wb
 
-            for (int i = 0; i < lwoGeoPacked.Faces.size(); i++)
-                fwrite(&lwoGeoPacked.Faces[i], sizeof(LWO_FACE_GROUP), 1, f);
+            if (f == NULL || fwrite(modelBodyData.data(), 1, modelBodyData.size(), f) != modelBodyData.size())
+            {
+                fprintf(stderr, "Error: Failed to write %s \n", modelBodyStr.c_str());
+                compressedSize = 0;
+            }
 
-            decompressedSize = ftell(f);
-            fclose(f);
+            if (f != NULL)
+                fclose(f);
         }
 
-        // Compress our geometry file for injection
-        std::string compressedGeometry = modelBodyStr;
-        int compressedSize = oodleCompress(modelBodyStr, compressedGeometry);
-
         if (compressedSize <= 0)
         {
             fprintf(stderr, "Error: failed to compress with Oodle DLL.\n");
             return 0;
         }
 
-        // Open up the .lwo header and modify it
-        fs::path localLWOPath = ExtractLWOHeader(targetLWO, resourcePath, 0, indexStringForImportPath);
+        // Open up the .lwo header and modify it. Only the modified header is written, once it's done.
+        fs::path localLWOPath = GetLWOHeaderImportPath(targetLWO, resourcePath, indexStringForImportPath);
 
         LWO LWOHeader;
-        LWOHeader.Serialize(localLWOPath);
+        std::shared_ptr<const std::vector<uint8_t>> originalHeaderData = ResourceSession::Get().GetEmbeddedFile(resourcePath, targetLWO.generic_string());
+        if (!originalHeaderData)
+            return 0;
+
+        LWOHeader.Serialize(*originalHeaderData);
 
         // Set lod0 header decompressed size (can we remove this?)
         LWOHeader.LWOStreamDBHeaders[0].decompressedSize = decompressedSize;
@@ -424,8 +617,8 @@ namespace HAYDEN
         {
             LWO_BML_HEADER& BMLHeader = LWOHeader.MeshData[0].BMLHeaders[i];
 
-            BMLHeader.NumVertices = lwoGeoPacked.Vertices.size();
-            BMLHeader.NumFacesX3 = lwoGeoPacked.Faces.size() * 3;
+            BMLHeader.NumVertices = geometry.NumVertices;
+            BMLHeader.NumFacesX3 = geometry.NumFaces * 3;
 
             BMLHeader.NegBoundsX = minX;
             BMLHeader.NegBoundsY = minY;
@@ -477,11 +670,11 @@ namespace HAYDEN
         // Make first 3 streamdb data identical since we are duplicating the highest LOD, last 2 aren't used.
         for (int i = 0; i < 3; i++)
         {
-            LWOHeader.LWOStreamDBData[i].LOD_NormalStartOffset = lwoGeoPacked.Vertices.size() * 8;
-            LWOHeader.LWOStreamDBData[i].LOD_UVStartOffset = lwoGeoPacked.Vertices.size() * 16;
-            LWOHeader.LWOStreamDBData[i].LOD_ColorStartOffset = lwoGeoPacked.Vertices.size() * 20;
-            LWOHeader.LWOStreamDBData[i].LOD_FacesStartOffset = lwoGeoPacked.Vertices.size() * 24;
-            LWOHeader.LWOGeoStreamDiskLayout[i].StreamCompressionType = 4;
+            LWOHeader.LWOStreamDBData[i].LOD_NormalStartOffset = geometry.NumVertices * 8;
+            LWOHeader.LWOStreamDBData[i].LOD_UVStartOffset = geometry.NumVertices * 16;
+            LWOHeader.LWOStreamDBData[i].LOD_ColorStartOffset = geometry.NumVertices * 20;
+            LWOHeader.LWOStreamDBData[i].LOD_FacesStartOffset = geometry.NumVertices * 24;
+            LWOHeader.LWOGeoStreamDiskLayout[i].StreamCompressionType = isStored ? STREAM_COMPRESSION_NONE_MODEL : STREAM_COMPRESSION_KRAKEN_MODEL;
             LWOHeader.LWOGeoStreamDiskLayout[i].decompressedSize = decompressedSize;
             LWOHeader.LWOGeoStreamDiskLayout[i].compressedSize = compressedSize;
         }
@@ -496,63 +689,221 @@ namespace HAYDEN
         LWOHeader.LWOStreamDBHeaders[1].decompressedSize = decompressedSize;
         LWOHeader.LWOStreamDBHeaders[2].decompressedSize = decompressedSize;
 
-        // Open lwo header for writing
-        std::string lwoHeaderFile = localLWOPath.string();
+        // Serialize the modified lwo header into memory
+        std::vector<uint8_t> lwoHeaderData;
+        appendData(lwoHeaderData, &LWOHeader.Header, sizeof(LWO_HEADER));
+
+        // Write Mesh metadata - use 1st mesh only
+        appendData(lwoHeaderData, &LWOHeader.MeshData[0].MeshHeader, sizeof(LWO_MESH_HEADER));
+        appendData(lwoHeaderData, LWOHeader.MeshData[0].MaterialDeclName.data(), LWOHeader.MeshData[0].MaterialDeclName.length());
+        appendData(lwoHeaderData, &LWOHeader.MeshData[0].MeshFooter, sizeof(LWO_MESH_FOOTER));
+
+        // Write BMLr metadata
+        for (int i = 0; i < LWOHeader.MeshData[0].BMLHeaders.size(); i++)
+        {
+            appendData(lwoHeaderData, &LWOHeader.MeshData[0].BMLHeaders[i], sizeof(LWO_BML_HEADER));
+        }
+
+        // Write LWO Settings
+        appendData(lwoHeaderData, &LWOHeader.LWOSettings, sizeof(LWO_SETTINGS));
+
+        // Just set this to zero - we don't know what it does.
+        // If it is "1" there is usually some extra data afterwards, but we aren't going to write this in our custom LWO.
+        LWOHeader.LWOSettings.unkFlag1 = 0;
+
+        // We dont know what these chunks are, write zero here so the game doesn't expect them.
+        LWOHeader.Num32ByteChunks = 0;
+        appendData(lwoHeaderData, &LWOHeader.Num32ByteChunks, sizeof(uint32_t));
+
+        // Write unk mesh strlen
+        appendData(lwoHeaderData, &LWOHeader.MeshStrlen, sizeof(uint32_t));
+        if (LWOHeader.MeshStrlen > 0)
+        {
+            appendData(lwoHeaderData, LWOHeader.MeshName.data(), LWOHeader.MeshName.length());
+        }
+
+        // Write LWO Settings 2
+        appendData(lwoHeaderData, &LWOHeader.LWOSettings2, sizeof(LWO_SETTINGS_2));
+
+        // Write StreamDB Data
+        for (int i = 0; i < 5; i++)
+        {
+            appendData(lwoHeaderData, &LWOHeader.LWOStreamDBHeaders[i], sizeof(LWO_STREAMDB_HEADER));
+            appendData(lwoHeaderData, &LWOHeader.LWOStreamDBData[i], sizeof(LWO_STREAMDB_DATA));
+            appendData(lwoHeaderData, &LWOHeader.LWOGeoStreamDiskLayout[i], sizeof(LWO_GEOMETRY_STREAMDISK_LAYOUT));
+        }
+
+        // Write lwo header to the imports folder
+        if (!fs::exists(localLWOPath.parent_path()))
+            if (!mkpath(localLWOPath.parent_path()))
+                fprintf(stderr, "Error: Failed to create directories for file: %s \n", localLWOPath.parent_path().string().c_str());
 
-        fs::path lwoHeaderPathWide = fs::current_path() / fs::path(lwoHeaderFile);
+        fs::path lwoHeaderPathWide = fs::current_path() / localLWOPath;
         FILE* fw = openLongFilePath(lwoHeaderPathWide); //wb
         if (fw != NULL)
         {
-            fwrite(&LWOHeader.Header, sizeof(LWO_HEADER), 1, fw);
+            fwrite(lwoHeaderData.data(), 1, lwoHeaderData.size(), fw);
+            fclose(fw);
+        }
 
-            // Write Mesh metadata - use 1st mesh only
-            fwrite(&LWOHeader.MeshData[0].MeshHeader, sizeof(LWO_MESH_HEADER), 1, fw);
-            fwrite(&LWOHeader.MeshData[0].MaterialDeclName[0], 1, LWOHeader.MeshData[0].MaterialDeclName.length(), fw);
-            fwrite(&LWOHeader.MeshData[0].MeshFooter, sizeof(LWO_MESH_FOOTER), 1, fw);
+        // Patch mode: the caller injects the new header into the .resources file as well
+        if (headerPatch != NULL)
+        {
+            headerPatch->EntryName = targetLWO.generic_string();
+            headerPatch->Data = std::move(lwoHeaderData);
+        }
 
-            // Write BMLr metadata
-            for (int i = 0; i < LWOHeader.MeshData[0].BMLHeaders.size(); i++)
-            {
-                fwrite(&LWOHeader.MeshData[0].BMLHeaders[i], sizeof(LWO_BML_HEADER), 1, fw);
-            }
+        return 1;
+    }
 
-            // Write LWO Settings
-            fwrite(&LWOHeader.LWOSettings, sizeof(LWO_SETTINGS), 1, fw);
+    // Patches headers into one .resources file in a single pass, then drops anything cached from it. Returns the number patched.
+    size_t ModelConverter::PatchResources(const fs::path& resourcePath, const std::vector<ResourcePatch>& patches)
+    {
+        // Reader and cached headers for this archive are stale once it has been patched
+        if (_ResourceReader && _ResourceReader->ResourceFilePath == resourcePath)
+            _ResourceReader.reset();
 
-            // Just set this to zero - we don't know what it does.
-            // If it is "1" there is usually some extra data afterwards, but we aren't going to write this in our custom LWO.
-            LWOHeader.LWOSettings.unkFlag1 = 0;
+        size_t numPatched = patchResourceEntries(resourcePath, patches);
+        ResourceSession::Get().Invalidate(resourcePath);
 
-            // We dont know what these chunks are, write zero here so the game doesn't expect them.
-            LWOHeader.Num32ByteChunks = 0;
-            fwrite(&LWOHeader.Num32ByteChunks, sizeof(uint32_t), 1, fw);
+        return numPatched;
+    }
 
-            // Write unk mesh strlen
-            fwrite(&LWOHeader.MeshStrlen, sizeof(uint32_t), 1, fw);
-            if (LWOHeader.MeshStrlen > 0)
-            {
-                fwrite(&LWOHeader.MeshName[0], 1, LWOHeader.MeshName.length(), fw);
-            }
+    // Everything up to the compressed geometry, from the import cache if nothing but header settings changed since the last import.
+    // Returns false if the OBJ couldn't be read or built. Otherwise either compressedGeometry is filled, or geometry.Data is ready to compress.
+    bool ModelConverter::PrepareImport(const fs::path& inputOBJ, bool useYOrientation, const CompressionOptions& compression, ImportCacheKeys& keys, ImportedGeometry& geometry, std::vector<uint8_t>& compressedGeometry)
+    {
+        if (UseImportCache)
+        {
+            if (!ImportCache::GetKeys(inputOBJ, useYOrientation, compression, keys))
+                return false;
 
-            // Write LWO Settings 2
-            fwrite(&LWOHeader.LWOSettings2, sizeof(LWO_SETTINGS_2), 1, fw);
+            // Cached geometry is Kraken, which the stand-in codec can't read back
+            if (!isStandInResourceCodecInUse() && ImportCache::Load(ImportStage::Compressed, keys.Compressed, compressedGeometry, &geometry))
+                return true;
+        }
 
-            // Write StreamDB Data
-            for (int i = 0; i < 5; i++)
+        return BuildImportGeometry(inputOBJ, useYOrientation, keys, geometry);
+    }
+
+    int ModelConverter::ConvertOBJtoLWO(fs::path gamePath, fs::path inputOBJ, fs::path targetLWO, fs::path resourcePath, std::string material2decl, bool useYOrientation, StreamDBWriter* streamDBWriter)
+    {
+        fs::path basePath = gamePath / "base";
+
+        // Make sure we have Oodle DLL available, or a stand-in for it
+        if (!oodleInit(basePath.string()) && !isStandInResourceCodecInUse())
+            return 0;
+
+        // A single stream, compressed on this thread with the default settings
+        CompressionOptions compression;
+        compression.NumThreads = 1;
+
+        ImportCacheKeys keys;
+        ImportedGeometry geometry;
+        std::vector<uint8_t> compressedGeometry;
+        if (!PrepareImport(inputOBJ, useYOrientation, compression, keys, geometry, compressedGeometry))
+            return 0;
+
+        if (compressedGeometry.empty())
+        {
+            CompressionStage compressionStage(compression);
+            size_t streamIndex = compressionStage.AddStream(targetLWO.generic_string(), std::move(geometry.Data));
+            compressionStage.Run();
+
+            compressedGeometry = compressionStage.GetStream(streamIndex).Output;
+            if (UseImportCache && !compressedGeometry.empty() && !compressionStage.GetStream(streamIndex).IsStored)
+                ImportCache::Save(ImportStage::Compressed, keys.Compressed, compressedGeometry, &geometry);
+        }
+
+        return WriteImportedModel(targetLWO, resourcePath, material2decl, geometry, compressedGeometry, streamDBWriter);
+    }
+
+    // Imports many models, with every geometry stream packed into one .streamdb at streamDBPath. Returns the number imported.
+    int ModelConverter::ConvertOBJsToLWO(fs::path gamePath, const std::vector<ModelImport>& imports, fs::path streamDBPath, bool useYOrientation, bool patchResources, const CompressionOptions& compression, bool printReport)
+    {
+        // Make sure we have Oodle DLL available, or a stand-in for it
+        if (!oodleInit((gamePath / "base").string()) && !isStandInResourceCodecInUse())
+            return 0;
+
+        // (a) Build every model's geometry, or find it in the import cache, (b) compress all of it at once, (c) write the headers, in list order
+        std::vector<ImportCacheKeys> keys(imports.size());
+        std::vector<ImportedGeometry> geometries(imports.size());
+        std::vector<std::vector<uint8_t>> compressedGeometries(imports.size());
+        std::vector<int64_t> streamIndexes(imports.size(), -1);
+        std::vector<bool> isPrepared(imports.size());
+        CompressionStage compressionStage(compression);
+
+        for (size_t i = 0; i < imports.size(); i++)
+        {
+            isPrepared[i] = PrepareImport(imports[i].OBJPath, useYOrientation, compression, keys[i], geometries[i], compressedGeometries[i]);
+            if (!isPrepared[i])
+                fprintf(stderr, "Error: Failed to import %s \n", imports[i].OBJPath.string().c_str());
+            else if (compressedGeometries[i].empty())
+                streamIndexes[i] = compressionStage.AddStream(imports[i].LWOPath.generic_string(), std::move(geometries[i].Data));
+        }
+
+        compressionStage.Run();
+
+        if (printReport)
+        {
+            compressionStage.PrintReport(stdout);
+            printf("%llu of %llu models were compressed already, from the import cache\n",
+                (unsigned long long)(std::count(isPrepared.begin(), isPrepared.end(), true) - compressionStage.NumStreams()),
+                (unsigned long long)imports.size());
+        }
+
+        for (size_t i = 0; i < imports.size(); i++)
+        {
+            if (streamIndexes[i] == -1)
+                continue;
+
+            compressedGeometries[i] = compressionStage.GetStream(streamIndexes[i]).Output;
+            if (UseImportCache && !compressedGeometries[i].empty() && !compressionStage.GetStream(streamIndexes[i]).IsStored)
+                ImportCache::Save(ImportStage::Compressed, keys[i].Compressed, compressedGeometries[i], &geometries[i]);
+        }
+
+        StreamDBWriter streamDBWriter;
+        int numImported = 0;
+
+        // Patched headers are grouped by archive, so each .resources file is parsed and patched once
+        std::map<fs::path, std::vector<ResourcePatch>> headerPatches;
+
+        for (size_t i = 0; i < imports.size(); i++)
+        {
+            if (!isPrepared[i])
+                continue;
+
+            const ModelImport& modelImport = imports[i];
+            ResourcePatch headerPatch;
+            if (WriteImportedModel(modelImport.LWOPath, modelImport.ResourcePath, modelImport.Material2Decl, geometries[i], compressedGeometries[i], &streamDBWriter, patchResources ? &headerPatch : NULL))
             {
-                fwrite(&LWOHeader.LWOStreamDBHeaders[i], sizeof(LWO_STREAMDB_HEADER), 1, fw);
-                fwrite(&LWOHeader.LWOStreamDBData[i], sizeof(LWO_STREAMDB_DATA), 1, fw);
-                fwrite(&LWOHeader.LWOGeoStreamDiskLayout[i], sizeof(LWO_GEOMETRY_STREAMDISK_LAYOUT), 1, fw);
+                numImported++;
+                if (patchResources)
+                    headerPatches[modelImport.ResourcePath].push_back(std::move(headerPatch));
             }
+            else
+            {
+                fprintf(stderr, "Error: Failed to import %s \n", modelImport.OBJPath.string().c_str());
+            }
+        }
 
-            // Finish and close file
-            fclose(fw);
+        // Headers point at geometry in this file, without it none of the imports work.
+        // Write syncs it to disk, so nothing is patched into the game's archives until the geometry is there.
+        if (!streamDBWriter.Empty() && !streamDBWriter.Write(streamDBPath))
+        {
+            ThrowError(0, "Failed to write .streamdb file.", "Could not write " + streamDBPath.string() + ".");
+            return 0;
         }
 
-        // Remove the temporary OBJ/MTL files
-        fs::remove(tmpOBJFile);
-        fs::remove(tmpMTLFile);
+        for (const auto& archivePatches : headerPatches)
+        {
+            size_t numPatched = PatchResources(archivePatches.first, archivePatches.second);
+            if (numPatched != archivePatches.second.size())
+                fprintf(stderr, "Error: Failed to patch %llu models into %s \n", (unsigned long long)(archivePatches.second.size() - numPatched), archivePatches.first.string().c_str());
 
-        return 1;
+            numImported -= (int)(archivePatches.second.size() - numPatched);
+        }
+
+        return numImported;
     }
 };
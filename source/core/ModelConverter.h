@@ -7,13 +7,25 @@
 #include <filesystem>
 #include <algorithm>
 #include <cmath>
+#include <map>
+#include <memory>
 
 #include "types/LWO.h"
 #include "types/OBJ.h"
 #include "types/ResourceFile.h"
 
+#include "CompressionStage.h"
+#include "GlobalResourceIndex.h"
+#include "ImportCache.h"
+#include "LWOExporter.h"
 #include "Oodle.h"
+#include "ResourceDiff.h"
+#include "ResourceExtractor.h"
 #include "ResourceFileReader.h"
+#include "ResourcePatcher.h"
+#include "ResourceSession.h"
+#include "ResourceVerifier.h"
+#include "StreamDBWriter.h"
 
 #include "vendor/obj/obj.h"
 
@@ -21,22 +33,50 @@ namespace fs = std::filesystem;
 
 namespace HAYDEN
 {
+    // One model for ConvertOBJsToLWO
+    struct ModelImport
+    {
+        fs::path OBJPath;
+        fs::path LWOPath;                       // entry name in the .resources file
+        fs::path ResourcePath;
+        std::string Material2Decl;
+    };
+
     class ModelConverter
     {
         public:
 
             int VertexCount = 0;
+            bool UseImportCache = 1;            // keep each import stage's output in cache/import, and start from it next time
 
-            bool LoadResource(const std::string fileName);
+            bool LoadResource(const std::string fileName, ResourceLoadProgress* progress = NULL);
+            bool LoadAllResources(const std::string basePath, ResourceLoadProgress* progress = NULL);
             bool HasResourceLoadError() { return _HasResourceLoadError; }
-            std::vector<ResourceEntry> GetResourceData() { return _ResourceData; }
+            bool HasGlobalIndex() { return _GlobalIndex != NULL; }
+            std::shared_ptr<const ResourceTable> GetResourceData() { return _ResourceReader ? _ResourceReader->GetResourceTable() : std::make_shared<const ResourceTable>(); }
+            std::shared_ptr<const ResourceTable> GetModelData() { return _ModelTable ? _ModelTable : std::make_shared<const ResourceTable>(); }
+            const GlobalResourceIndex& GetGlobalIndex() { return *_GlobalIndex; }
+            std::string GetBasePath() { return _BasePath; }
             std::string GetLastErrorMessage() { return _LastErrorMessage; }
             std::string GetLastErrorDetail() { return _LastErrorDetail; }
 
+            ExtractionStats ExtractResources(fs::path outputPath, const ResourceFilter& filter, uint32_t numThreads = 0);
+            VerificationStats VerifyResources(const ResourceFilter& filter, uint32_t numThreads = 0);
+            DiffStats DiffResources(fs::path originalPath, const ResourceFilter& filter, uint32_t numThreads = 0);
+            ModelExportStats ExportModels(fs::path outputPath, ModelExportFormat format, const ResourceFilter& filter, uint32_t lod = 0, uint32_t numThreads = 0, std::vector<fs::path> streamDBPaths = {});
             fs::path ExtractLWOHeader(fs::path lwoPath, fs::path resourcePath, bool temporaryExtraction, std::string streamDBIndexStr);
+            fs::path GetLWOHeaderImportPath(fs::path lwoPath, fs::path resourcePath, std::string streamDBIndexStr);
             std::vector<std::string> GetOBJMeshInfo(fs::path objPath);
             std::vector<std::string> GetLWOMeshInfo(fs::path lwoPath, fs::path resourcePath);
-            int ConvertOBJtoLWO(fs::path gamePath, fs::path objPath, fs::path lwoPath, fs::path resourcePath, std::string material2decl, bool useYOrientation);
+            // Geometry goes to a loose file under imports, or into streamDBWriter. Never patches the .resources file,
+            // the game only reads geometry from a .streamdb, so patching goes through ConvertOBJsToLWO.
+            int ConvertOBJtoLWO(fs::path gamePath, fs::path objPath, fs::path lwoPath, fs::path resourcePath, std::string material2decl, bool useYOrientation, StreamDBWriter* streamDBWriter = NULL);
+
+            // Imports many models, with every geometry stream packed into one .streamdb at streamDBPath. Returns the number imported.
+            // Geometry of the whole batch is compressed at once, printReport shows how each stream went.
+            // With patchResources, headers are only patched into the .resources files once the .streamdb has been written.
+            int ConvertOBJsToLWO(fs::path gamePath, const std::vector<ModelImport>& imports, fs::path streamDBPath, bool useYOrientation, bool patchResources = 0,
+                const CompressionOptions& compression = CompressionOptions(), bool printReport = 0);
 
         private:
 
@@ -46,7 +86,20 @@ namespace HAYDEN
             std::string _LastErrorDetail;
             std::string _BasePath;
             std::string _ResourcePath;
-            std::vector<ResourceEntry> _ResourceData;
+            std::shared_ptr<ResourceFileReader> _ResourceReader;   // shared through ResourceSession
+            std::shared_ptr<const ResourceTable> _ModelTable;        // .lwo entries of the last loaded .resources file
+            std::unique_ptr<GlobalResourceIndex> _GlobalIndex;
+
+            // ConvertOBJtoLWO in two halves, so a batch can compress all of its geometry in between
+            bool PrepareImport(const fs::path& inputOBJ, bool useYOrientation, const CompressionOptions& compression, ImportCacheKeys& keys, ImportedGeometry& geometry, std::vector<uint8_t>& compressedGeometry);
+            bool BuildImportGeometry(const fs::path& inputOBJ, bool useYOrientation, const ImportCacheKeys& keys, ImportedGeometry& geometry);
+            int WriteImportedModel(fs::path targetLWO, fs::path resourcePath, std::string material2decl, const ImportedGeometry& geometry, const std::vector<uint8_t>& compressedGeometry, StreamDBWriter* streamDBWriter, ResourcePatch* headerPatch = NULL);
+
+            // Patches headers into one .resources file in a single pass, then drops anything cached from it. Returns the number patched.
+            size_t PatchResources(const fs::path& resourcePath, const std::vector<ResourcePatch>& patches);
+
+            // Returns the session's reader for resourcePath, opened by whichever converter asked first
+            ResourceFileReader& GetResourceReader(const fs::path& resourcePath);
 
             // Outputs to stderr, but also stores error message for passing to another application (Qt, etc).
             void ThrowError(bool isFatal, std::string errorMessage, std::string errorDetail = "");
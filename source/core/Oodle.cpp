@@ -1,154 +1,569 @@
 #include "Oodle.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
 namespace HAYDEN
 {
-    // Decompress using Oodle DLL
-    OodLZ_DecompressFunc* OodLZ_Decompress = NULL;
-    OodLZ_CompressFunc* OodLZ_Compress = NULL;
+    // Decompress using Oodle DLL. Set once by oodleInit, read by any thread after that.
+    static std::atomic<OodLZ_DecompressFunc*> OodLZ_Decompress{ NULL };
+    static std::atomic<OodLZ_CompressFunc*> OodLZ_Compress{ NULL };
+    static std::atomic<OodLZ_CompressScratchMemBoundFunc*> OodLZ_CompressScratchMemBound{ NULL };
+    static std::atomic<OodLZ_GetCompressedStepForRawStepFunc*> OodLZ_GetCompressedStepForRawStep{ NULL };
+    static std::atomic<int64_t> OodleDecoderScratchSize{ 0 };
 
-    bool oodleInit(const std::string& basePath)
+    // Only one load is ever attempted at a time, and a base path that failed once isn't tried again
+    static std::mutex OodleLoadMutex;
+    static std::vector<std::string> OodleFailedBasePaths;
+
+    // Without a saved tuning only buffers this big are threaded. Well past where tuning usually lands,
+    // so an untuned machine gets most of the gain on the largest buffers and never pays for it on the rest.
+    static const uint64_t OODLE_DEFAULT_THREADED_CUTOFF = 16 * 1024 * 1024;
+
+    // Buffers at least this big are decompressed threaded. Replaced by the saved tuning once that's loaded.
+    static std::atomic<uint64_t> OodleThreadedCutoff{ OODLE_DEFAULT_THREADED_CUTOFF };
+    static std::once_flag OodleTuningLoaded;
+
+    // Loads the library and resolves both entry points. Only ever runs under OodleLoadMutex.
+    static bool loadOodle(const std::string& basePath)
     {
-        std::string oodlePath = basePath.substr(0, basePath.length() - 4) + "oo2core_8_win64.dll";
-        bool test = 0;
+        // The dll is in the game directory, next to base
+        std::error_code ec;
+        fs::path gamePath = fs::absolute(fs::path(basePath.substr(0, basePath.length() - 4)), ec).lexically_normal();
+        fs::path oodlePath = gamePath / "oo2core_8_win64.dll";
 #ifdef _WIN32
         // Load oodle dll
-        auto oodle = LoadLibraryA(oodlePath.c_str());
+        auto oodle = LoadLibraryW(oodlePath.wstring().c_str());
         if (!oodle)
             return false;
 
-        OodLZ_Decompress = (OodLZ_DecompressFunc*)GetProcAddress(oodle, "OodleLZ_Decompress");
-        OodLZ_Compress = (OodLZ_CompressFunc*)GetProcAddress(oodle, "OodleLZ_Compress");
+        auto decompress = (OodLZ_DecompressFunc*)GetProcAddress(oodle, "OodleLZ_Decompress");
+        auto compress = (OodLZ_CompressFunc*)GetProcAddress(oodle, "OodleLZ_Compress");
+        auto decoderMemorySizeNeeded = (OodLZ_DecoderMemorySizeNeededFunc*)GetProcAddress(oodle, "OodleLZDecoder_MemorySizeNeeded");
+        auto compressScratchMemBound = (OodLZ_CompressScratchMemBoundFunc*)GetProcAddress(oodle, "OodleLZ_GetCompressScratchMemBound");
+        auto getCompressedStepForRawStep = (OodLZ_GetCompressedStepForRawStepFunc*)GetProcAddress(oodle, "OodleLZ_GetCompressedStepForRawStep");
 #else
-        // Copy oodle to current dir to prevent linoodle errors
-        std::error_code ec;
-        fs::copy(oodlePath, fs::current_path(), ec);
-        if (ec.value() != 0)
+        // linoodle opens the dll by name from the working directory, and has no way to be given a path.
+        // Changing directory would move it under every other thread resolving a relative path (cache/, imports/),
+        // so the working directory gets a link to the game's dll instead. It's made once and left for next time.
+        if (!fs::exists(oodlePath, ec))
             return false;
 
+        fs::path linkedPath = fs::absolute(fs::path("oo2core_8_win64.dll"), ec);
+        if (!fs::exists(linkedPath, ec))
+        {
+            // A link left by a game install that's since moved
+            if (fs::is_symlink(fs::symlink_status(linkedPath, ec)))
+                fs::remove(linkedPath, ec);
+
+            ec.clear();
+            fs::create_symlink(oodlePath, linkedPath, ec);
+            if (ec)
+            {
+                ec.clear();
+                fs::copy_file(oodlePath, linkedPath, ec);
+            }
+
+            if (ec)
+                return false;
+        }
+
         // Load linoodle library
-        std::string linoodlePath = basePath + "/liblinoodle.so";
-        auto oodle = dlopen(linoodlePath.c_str(), RTLD_LAZY);
-        OodLZ_Decompress = (OodLZ_DecompressFunc*)dlsym(oodle, "OodleLZ_Decompress");
-        OodLZ_Compress = (OodLZ_CompressFunc*)dlsym(oodle, "OodleLZ_Compress");
+        fs::path linoodlePath = fs::absolute(fs::path(basePath) / "liblinoodle.so", ec);
+        auto oodle = dlopen(linoodlePath.string().c_str(), RTLD_LAZY);
+        if (oodle == NULL)
+            return false;
 
-        // Remove oodle dll
-        fs::remove(fs::current_path().append("oo2core_8_win64.dll"), ec);
+        auto decompress = (OodLZ_DecompressFunc*)dlsym(oodle, "OodleLZ_Decompress");
+        auto compress = (OodLZ_CompressFunc*)dlsym(oodle, "OodleLZ_Compress");
+        auto decoderMemorySizeNeeded = (OodLZ_DecoderMemorySizeNeededFunc*)dlsym(oodle, "OodleLZDecoder_MemorySizeNeeded");
+        auto compressScratchMemBound = (OodLZ_CompressScratchMemBoundFunc*)dlsym(oodle, "OodleLZ_GetCompressScratchMemBound");
+        auto getCompressedStepForRawStep = (OodLZ_GetCompressedStepForRawStepFunc*)dlsym(oodle, "OodleLZ_GetCompressedStepForRawStep");
 #endif
 
-        if (oodle == NULL || OodLZ_Decompress == NULL)
+        if (decompress == NULL)
             return false;
 
+        // Any codec, any size. Without it, Oodle allocates its own decoder memory on every call.
+        if (decoderMemorySizeNeeded != NULL)
+            OodleDecoderScratchSize.store(std::max<int64_t>(decoderMemorySizeNeeded(-1, -1), 0), std::memory_order_relaxed);
+
+        OodLZ_CompressScratchMemBound.store(compressScratchMemBound, std::memory_order_relaxed);
+        OodLZ_GetCompressedStepForRawStep.store(getCompressedStepForRawStep, std::memory_order_relaxed);
+        OodLZ_Decompress.store(decompress, std::memory_order_release);
+        OodLZ_Compress.store(compress, std::memory_order_release);
         return true;
     }
 
-    std::vector<uint8_t> oodleDecompress(std::vector<uint8_t> compressedData, const uint64_t decompressedSize)
+    // Loads Oodle the first time it's called, every call after that returns straight away.
+    // A failed load is remembered, only a different base path is tried again.
+    bool oodleInit(const std::string& basePath)
     {
-        if (OodLZ_Decompress == NULL)
-            return std::vector<uint8_t>();
+        if (oodleIsLoaded())
+            return true;
 
-        std::vector<uint8_t> output(decompressedSize + SAFE_SPACE);
-        uint64_t outbytes = 0;
+        std::lock_guard<std::mutex> lock(OodleLoadMutex);
+        if (oodleIsLoaded())
+            return true;
 
-        // Decompress using Oodle DLL
-        outbytes = OodLZ_Decompress(compressedData.data(), compressedData.size(), output.data(), decompressedSize, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+        std::error_code ec;
+        std::string basePathKey = fs::absolute(fs::path(basePath), ec).lexically_normal().generic_string();
+        if (std::find(OodleFailedBasePaths.begin(), OodleFailedBasePaths.end(), basePathKey) != OodleFailedBasePaths.end())
+            return false;
 
-        if (outbytes == 0)
+        if (loadOodle(basePath))
+            return true;
+
+        OodleFailedBasePaths.push_back(basePathKey);
+        return false;
+    }
+
+    bool oodleIsLoaded()
+    {
+        return OodLZ_Decompress.load(std::memory_order_acquire) != NULL;
+    }
+
+    const char* getOodleCodecName(OodleCodec codec)
+    {
+        switch (codec)
         {
-            fprintf(stderr, "Error: failed to decompress with Oodle DLL.\n\n");
-            return std::vector<uint8_t>();
+            case OodleCodec::Kraken:
+                return "kraken";
+            case OodleCodec::Mermaid:
+                return "mermaid";
+            case OodleCodec::Leviathan:
+                return "leviathan";
         }
+        return "unknown";
+    }
 
-        return std::vector<uint8_t>(output.begin(), output.begin() + outbytes);
+    bool parseOodleCodec(const std::string& name, OodleCodec& codec)
+    {
+        for (OodleCodec candidate : { OodleCodec::Kraken, OodleCodec::Mermaid, OodleCodec::Leviathan })
+        {
+            if (name == getOodleCodecName(candidate))
+            {
+                codec = candidate;
+                return true;
+            }
+        }
+        return false;
     }
 
-    int oodleCompress(std::string filename, std::string destFilename) 
+    // Scratch memory for this thread's calls, grown to the largest call so far and reused after that
+    static uint8_t* getThreadScratch(const uint64_t size)
     {
-        FILE* f;
-        uint8_t* input = NULL;
-        uint8_t* output = NULL;
-        uint64_t unpacked_size = 0;
-        uint64_t compressed_size = 0;
+        static thread_local std::vector<uint8_t> scratch;
+        if (scratch.size() < size)
+            scratch.resize(size);
 
-        // Make sure we have Oodle DLL available
-        if (OodLZ_Compress == NULL)
-        {
-            fprintf(stderr, "ERROR : OodleLibrary : Oodle has not been initialized. Run Oodle::Init() first. \n\n");
+        return scratch.data();
+    }
+
+    std::vector<uint8_t> oodleDecompress(const std::vector<uint8_t>& compressedData, const uint64_t decompressedSize)
+    {
+        std::vector<uint8_t> output(decompressedSize + SAFE_SPACE);
+        uint64_t outbytes = oodleDecompress(compressedData.data(), compressedData.size(), output.data(), decompressedSize);
+
+        output.resize(outbytes);
+        return output;
+    }
+
+    // The whole buffer in one call, on this thread
+    static uint64_t decompressUnthreaded(const uint8_t* compressedData, const uint64_t compressedSize, uint8_t* output, const uint64_t decompressedSize)
+    {
+        OodLZ_DecompressFunc* decompress = OodLZ_Decompress.load(std::memory_order_acquire);
+        if (decompress == NULL)
+            return 0;
+
+        int64_t scratchSize = OodleDecoderScratchSize.load(std::memory_order_relaxed);
+        uint8_t* scratch = scratchSize > 0 ? getThreadScratch(scratchSize) : NULL;
+
+        // Decompress using Oodle DLL
+        int64_t outbytes = decompress((uint8_t*)compressedData, compressedSize, output, decompressedSize, 0, 0, 0, 0, 0, 0, 0, scratch, scratch != NULL ? scratchSize : 0, 0);
+
+        if (outbytes <= 0)
+            return 0;
+
+        return outbytes;
+    }
+
+    // Raw bytes per Oodle block. The threaded path decodes one block at a time.
+    static const uint64_t OODLE_BLOCK_SIZE = 0x40000;
+
+    // Phase 1 workers per buffer. Phase 2 runs on one thread in block order, more than this can't keep it fed.
+    static const uint32_t MAX_PHASE1_THREADS = 4;
+
+    // Tuning measures sizes from 1 MB up to 32 MB, smaller buffers are never threaded.
+    // Threaded has to be at least 10% faster to be worth the extra threads.
+    static const uint64_t OODLE_MIN_THREADED_SIZE = 1024 * 1024;
+    static const uint64_t OODLE_MAX_BENCHMARK_SIZE = 32 * 1024 * 1024;
+    static const double OODLE_THREADED_MIN_SPEEDUP = 0.9;
+
+    struct OodleBlock
+    {
+        uint64_t CompressedOffset = 0;
+        uint64_t CompressedSize = 0;
+        uint64_t RawOffset = 0;
+        uint64_t RawSize = 0;
+    };
+
+    bool oodleCanDecompressThreaded()
+    {
+        return oodleIsLoaded() && OodLZ_GetCompressedStepForRawStep.load(std::memory_order_relaxed) != NULL && OodleDecoderScratchSize.load(std::memory_order_relaxed) > 0;
+    }
+
+    // Where each block starts and ends, in both the compressed and the raw data
+    static bool findOodleBlocks(const uint8_t* compressedData, const uint64_t compressedSize, const uint64_t decompressedSize, std::vector<OodleBlock>& blocks)
+    {
+        OodLZ_GetCompressedStepForRawStepFunc* getCompressedStepForRawStep = OodLZ_GetCompressedStepForRawStep.load(std::memory_order_relaxed);
+        if (getCompressedStepForRawStep == NULL)
             return false;
-        }
 
-        // Open source file for reading
-        f = fopen(filename.c_str(), "rb");
-        if (f == NULL)
+        OodleBlock block;
+        while (block.RawOffset < decompressedSize)
         {
-            fprintf(stderr, "ERROR : OodleLibrary : Failed to open %s for reading! \n\n", filename.c_str());
-            return 1;
+            int64_t endRawPos = 0;
+            int isIndependent = 0;
+            int64_t compressedStep = getCompressedStepForRawStep(compressedData + block.CompressedOffset, compressedSize - block.CompressedOffset,
+                block.RawOffset, std::min(OODLE_BLOCK_SIZE, decompressedSize - block.RawOffset), &endRawPos, &isIndependent);
+
+            if (compressedStep <= 0 || block.CompressedOffset + compressedStep > compressedSize || (uint64_t)endRawPos <= block.RawOffset)
+                return false;
+
+            block.CompressedSize = compressedStep;
+            block.RawSize = std::min<uint64_t>(endRawPos, decompressedSize) - block.RawOffset;
+            blocks.push_back(block);
+
+            block.CompressedOffset += block.CompressedSize;
+            block.RawOffset += block.RawSize;
         }
 
-        // Compress file in memory
-        if (f != NULL)
+        return true;
+    }
+
+    // Phase 1 (entropy decoding into scratch) only reads compressed data, so it runs ahead on a few workers, one block each.
+    // Phase 2 (copying matches into the output) needs every block before it, so it runs on this thread in block order.
+    // Each block has a scratch slot from phase 1 until phase 2 is done with it, the number of slots bounds how far ahead phase 1 gets.
+    static uint64_t decompressThreaded(const uint8_t* compressedData, const uint64_t compressedSize, uint8_t* output, const uint64_t decompressedSize)
+    {
+        OodLZ_DecompressFunc* decompress = OodLZ_Decompress.load(std::memory_order_acquire);
+        int64_t scratchSize = OodleDecoderScratchSize.load(std::memory_order_relaxed);
+
+        std::vector<OodleBlock> blocks;
+        if (decompress == NULL || scratchSize <= 0 || !findOodleBlocks(compressedData, compressedSize, decompressedSize, blocks))
+            return 0;
+
+        uint32_t numPhase1Threads = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+        numPhase1Threads = std::min<uint64_t>(std::min(numPhase1Threads, MAX_PHASE1_THREADS), blocks.size());
+
+        const size_t numSlots = numPhase1Threads * 2;
+        std::vector<std::vector<uint8_t>> scratch(numSlots, std::vector<uint8_t>(scratchSize));
+
+        auto decodePhase = [&](const OodleBlock& block, uint8_t* blockScratch, int threadPhase) -> bool
+        {
+            int64_t outbytes = decompress((uint8_t*)compressedData + block.CompressedOffset, block.CompressedSize, output + block.RawOffset, block.RawSize,
+                0, 0, 0, output, decompressedSize, 0, 0, blockScratch, scratchSize, threadPhase);
+            return outbytes > 0;
+        };
+
+        std::mutex mutex;
+        std::condition_variable blockDone;
+        std::vector<int8_t> phase1State(blocks.size(), 0);     // 1 decoded, -1 failed
+        size_t numPhase2Done = 0;
+        uint32_t numWorkersRunning = numPhase1Threads;
+        bool isFailed = 0;                                      // once set, never cleared
+
+        std::atomic<size_t> nextBlock(0);
+        auto phase1Worker = [&]()
         {
-            fseek(f, 0, SEEK_END);
+            for (size_t i = nextBlock++; i < blocks.size(); i = nextBlock++)
+            {
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    blockDone.wait(lock, [&]() { return isFailed || i < numPhase2Done + numSlots; });
+                    if (isFailed)
+                        break;
+                }
+
+                bool isDecoded = decodePhase(blocks[i], scratch[i % numSlots].data(), 1);
+
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    phase1State[i] = isDecoded ? 1 : -1;
+                    isFailed = isFailed || !isDecoded;
+                }
+                blockDone.notify_all();
+
+                if (!isDecoded)
+                    break;
+            }
 
-            unpacked_size = ftell(f);     
-            input = new uint8_t[unpacked_size];
-            output = new uint8_t[unpacked_size + 65536];
+            // A block nobody will decode any more must not keep phase 2 waiting
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                numWorkersRunning--;
+            }
+            blockDone.notify_all();
+        };
 
-            fseek(f, 0, SEEK_SET);
+        std::vector<std::thread> workers;
+        for (uint32_t i = 0; i < numPhase1Threads; i++)
+            workers.emplace_back(phase1Worker);
 
-            if (fread(input, 1, unpacked_size, f) != unpacked_size) 
+        for (size_t i = 0; i < blocks.size(); i++)
+        {
             {
-                fprintf(stderr, "ERROR : OodleLibrary : Failed to read file into memory.\n");
-                return 1;
+                std::unique_lock<std::mutex> lock(mutex);
+                blockDone.wait(lock, [&]() { return isFailed || phase1State[i] != 0 || numWorkersRunning == 0; });
+                if (phase1State[i] != 1)
+                    isFailed = 1;
+                if (isFailed)
+                    break;
             }
 
-            if (!output)
+            bool isDecoded = decodePhase(blocks[i], scratch[i % numSlots].data(), 2);
+
             {
-                fprintf(stderr, "ERROR : OodleLibrary : Couldn't allocate memory for compression.\n");
-                return 1;
+                std::lock_guard<std::mutex> lock(mutex);
+                isFailed = isFailed || !isDecoded;
+                numPhase2Done++;
             }
+            blockDone.notify_all();
 
-            // 8 = Kraken, 4 = compression level
-            compressed_size = OodLZ_Compress(8, input, unpacked_size, output, 4, 0, 0, 0, 0, 0);
+            if (!isDecoded)
+                break;
+        }
+
+        // Wakes workers still waiting for a slot if phase 2 gave up
+        blockDone.notify_all();
+        for (auto& worker : workers)
+            worker.join();
+
+        return isFailed ? 0 : decompressedSize;
+    }
+
+    // Tuning is measured per machine and saved next to the other caches
+    static fs::path getOodleTuningPath()
+    {
+        return fs::current_path() / "cache" / "oodle_tuning.bin";
+    }
+
+    // Repetitive, byte-oriented data with short matches, roughly what geometry and image data look like to Kraken
+    static std::vector<uint8_t> generateBenchmarkData(const uint64_t size)
+    {
+        std::vector<uint8_t> data(size);
+        uint32_t seed = 0x2545F491;
+        auto next = [&seed]() { seed = seed * 1664525u + 1013904223u; return seed >> 8; };
+
+        for (uint64_t i = 0; i < size;)
+        {
+            uint32_t r = next();
+            uint64_t length = std::min<uint64_t>(16 + r % 48, size - i);
+
+            if (i > 4096 && (r & 0x100) != 0)
+            {
+                uint64_t matchOffset = i - 1 - next() % 4096;
+                for (uint64_t j = 0; j < length; j++)
+                    data[i + j] = data[matchOffset + j];
+            }
+            else
+            {
+                for (uint64_t j = 0; j < length; j++)
+                    data[i + j] = (uint8_t)(next() % 24);
+            }
 
-            fclose(f);
+            i += length;
         }
 
-        // Make sure compression was successful
-        if (compressed_size <= 0) 
+        return data;
+    }
+
+    // Best of a few runs, in seconds. Returns a negative time if any run fails.
+    template <typename DecompressFunc>
+    static double timeDecompress(DecompressFunc decompressFunc, const std::vector<uint8_t>& compressedData, std::vector<uint8_t>& output, const uint64_t size)
+    {
+        double bestSeconds = -1;
+        for (int run = 0; run < 3; run++)
         {
-            fprintf(stderr, "ERROR : OodleLibrary : Compression failed.\n");
-            return 1;
+            auto decompressStart = std::chrono::steady_clock::now();
+            uint64_t outbytes = decompressFunc(compressedData.data(), compressedData.size(), output.data(), size);
+            std::chrono::duration<double> decompressTime = std::chrono::steady_clock::now() - decompressStart;
+
+            if (outbytes != size)
+                return -1;
+
+            if (bestSeconds < 0 || decompressTime.count() < bestSeconds)
+                bestSeconds = decompressTime.count();
         }
+        return bestSeconds;
+    }
+
+    static void saveOodleTuning(const uint64_t threadedCutoff)
+    {
+        fs::path tuningPath = getOodleTuningPath();
+        fs::path tmpTuningPath = tuningPath;
+        tmpTuningPath += ".tmp";
+
+        std::error_code ec;
+        fs::create_directories(tuningPath.parent_path(), ec);
 
-        // Write compressed data to destination file
-        f = fopen(destFilename.c_str(), "wb");
+        FILE* f = fopen(tmpTuningPath.string().c_str(), "wb");
         if (f == NULL)
+            return;
+
+        OodleTuningFileHeader header;
+        header.NumThreads = std::thread::hardware_concurrency();
+        header.ThreadedCutoff = threadedCutoff;
+
+        bool writeFailed = fwrite(&header, 1, sizeof(OodleTuningFileHeader), f) != sizeof(OodleTuningFileHeader);
+        writeFailed = fclose(f) != 0 || writeFailed;
+
+        if (!writeFailed)
+            fs::rename(tmpTuningPath, tuningPath, ec);
+
+        if (writeFailed || ec)
+            fs::remove(tmpTuningPath, ec);
+    }
+
+    // Only trusted if it was measured with as many cores as there are now
+    static bool loadOodleTuning()
+    {
+        FILE* f = fopen(getOodleTuningPath().string().c_str(), "rb");
+        if (f == NULL)
+            return false;
+
+        OodleTuningFileHeader header;
+        bool isValid = fread(&header, 1, sizeof(OodleTuningFileHeader), f) == sizeof(OodleTuningFileHeader);
+        fclose(f);
+
+        isValid = isValid && header.Magic == OODLE_TUNING_MAGIC && header.FormatVersion == OODLE_TUNING_VERSION;
+        isValid = isValid && header.NumThreads == std::thread::hardware_concurrency();
+
+        if (isValid)
+            OodleThreadedCutoff.store(header.ThreadedCutoff, std::memory_order_relaxed);
+
+        return isValid;
+    }
+
+    // Times both paths at doubling sizes. The cutoff is the smallest size from which the threaded path is
+    // correct and clearly faster at every size measured, so one noisy result can't switch it on too early.
+    OodleDecompressTuning oodleTuneDecompression()
+    {
+        OodleDecompressTuning tuning;
+        if (!oodleCanDecompressThreaded())
+            return tuning;
+
+        std::vector<uint8_t> data = generateBenchmarkData(OODLE_MAX_BENCHMARK_SIZE);
+        std::vector<uint8_t> unthreadedOutput(OODLE_MAX_BENCHMARK_SIZE + SAFE_SPACE);
+        std::vector<uint8_t> threadedOutput(OODLE_MAX_BENCHMARK_SIZE + SAFE_SPACE);
+
+        for (uint64_t size = OODLE_MIN_THREADED_SIZE; size <= OODLE_MAX_BENCHMARK_SIZE; size *= 2)
         {
-            fprintf(stderr, "ERROR : OodleLibrary : Failed to open destination file for writing!\n");
-            return 1;
+            OodleDecompressBenchmark benchmark;
+            benchmark.Size = size;
+
+            std::vector<uint8_t> compressedData = oodleCompress(data.data(), size);
+            if (!compressedData.empty())
+            {
+                benchmark.UnthreadedSeconds = timeDecompress(decompressUnthreaded, compressedData, unthreadedOutput, size);
+                benchmark.ThreadedSeconds = timeDecompress(decompressThreaded, compressedData, threadedOutput, size);
+                benchmark.IsThreadedValid = benchmark.UnthreadedSeconds > 0 && benchmark.ThreadedSeconds > 0
+                    && memcmp(unthreadedOutput.data(), data.data(), size) == 0 && memcmp(threadedOutput.data(), data.data(), size) == 0;
+            }
+
+            tuning.Benchmarks.push_back(benchmark);
         }
 
-        if (f != NULL && output != NULL) 
+        for (auto benchmark = tuning.Benchmarks.rbegin(); benchmark != tuning.Benchmarks.rend(); ++benchmark)
         {
-            // WRITE OUR STREAMDB MAGIC HEADER - static for now
-            uint64_t streamDBMagic = 4775026447650804819;
-            uint32_t lodCount = 3;
-            uint32_t lodDataOffset = 36;
-            uint32_t lodDataLength = compressed_size;
+            if (!benchmark->IsThreadedValid || benchmark->ThreadedSeconds > benchmark->UnthreadedSeconds * OODLE_THREADED_MIN_SPEEDUP)
+                break;
+
+            tuning.ThreadedCutoff = benchmark->Size;
+        }
+
+        OodleThreadedCutoff.store(tuning.ThreadedCutoff, std::memory_order_relaxed);
+        saveOodleTuning(tuning.ThreadedCutoff);
+        return tuning;
+    }
 
-            fwrite(&streamDBMagic, 8, 1, f);
-            fwrite(&lodCount, 4, 1, f);
+    // Decompress into a caller-provided buffer, which must hold at least decompressedSize + SAFE_SPACE bytes. Returns bytes written, 0 on failure.
+    // Buffers past the tuned cutoff go through the threaded path first, and fall back to a single call if that fails.
+    // Without a saved tuning the built-in cutoff is used. Tuning here would benchmark a machine that's busy with
+    // everyone else's work, and hold up every other large decompression while it ran.
+    uint64_t oodleDecompress(const uint8_t* compressedData, const uint64_t compressedSize, uint8_t* output, const uint64_t decompressedSize)
+    {
+        if (decompressedSize >= OODLE_MIN_THREADED_SIZE && oodleCanDecompressThreaded())
+        {
+            std::call_once(OodleTuningLoaded, []()
+            {
+                loadOodleTuning();
+            });
 
-            for (int i = 0; i < lodCount; i++)
+            if (decompressedSize >= OodleThreadedCutoff.load(std::memory_order_relaxed))
             {
-                fwrite(&lodDataOffset, 4, 1, f);
-                fwrite(&lodDataLength, 4, 1, f);
+                uint64_t outbytes = decompressThreaded(compressedData, compressedSize, output, decompressedSize);
+                if (outbytes == decompressedSize)
+                    return outbytes;
             }
+        }
 
-            fwrite(output, 1, compressed_size, f);
-            fclose(f);
+        uint64_t outbytes = decompressUnthreaded(compressedData, compressedSize, output, decompressedSize);
+        if (outbytes == 0)
+            fprintf(stderr, "Error: failed to decompress with Oodle DLL.\n\n");
+
+        return outbytes;
+    }
+
+    // Kraken's worst case is a little over the input size: a few hundred bytes per 256KB block
+    uint64_t oodleCompressBound(const uint64_t size)
+    {
+        return size + 274 * ((size + 0x3FFFF) / 0x40000) + 65536;
+    }
+
+    // Compress into a caller-provided buffer of at least oodleCompressBound(size) bytes. Returns bytes written, 0 on failure.
+    uint64_t oodleCompress(const uint8_t* data, const uint64_t size, uint8_t* output, const uint64_t outputSize, const OodleSettings& settings)
+    {
+        OodLZ_CompressFunc* compress = OodLZ_Compress.load(std::memory_order_acquire);
+        if (compress == NULL || outputSize < oodleCompressBound(size))
+            return 0;
+
+        // -1 means the level has no bound, Oodle allocates for itself then
+        uint8_t* scratch = NULL;
+        int64_t scratchSize = 0;
+
+        OodLZ_CompressScratchMemBoundFunc* compressScratchMemBound = OodLZ_CompressScratchMemBound.load(std::memory_order_relaxed);
+        if (compressScratchMemBound != NULL)
+        {
+            scratchSize = compressScratchMemBound((int)settings.Codec, settings.Level, size, NULL);
+            if (scratchSize > 0)
+                scratch = getThreadScratch(scratchSize);
         }
 
-        return compressed_size;
+        int64_t compressedSize = compress((int)settings.Codec, (uint8_t*)data, size, output, settings.Level, 0, 0, 0, scratch, scratch != NULL ? scratchSize : 0);
+
+        if (compressedSize <= 0)
+            return 0;
+
+        return compressedSize;
+    }
+
+    // Compress a buffer in memory, Kraken level 4 unless told otherwise. Returns an empty vector on failure.
+    std::vector<uint8_t> oodleCompress(const uint8_t* data, const uint64_t size, const OodleSettings& settings)
+    {
+        std::vector<uint8_t> output(oodleCompressBound(size));
+        output.resize(oodleCompress(data, size, output.data(), output.size(), settings));
+        return output;
+    }
+
+    uint64_t oodleGetThreadedCutoff()
+    {
+        return OodleThreadedCutoff.load(std::memory_order_relaxed);
     }
 }
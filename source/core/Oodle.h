@@ -8,6 +8,7 @@
 
 #include <string>
 #include <vector>
+#include <cstdint>
 #include <filesystem>
 
 #define SAFE_SPACE 64
@@ -20,12 +21,96 @@ typedef int OodLZ_CompressFunc(
     int codec, uint8_t* src_buf, size_t src_len, uint8_t* dst_buf, int level,
     void* opts, size_t offs, size_t unused, void* scratch, size_t scratch_size);
 
+// Scratch sizes. Optional, not every build of the library exports them.
+typedef int64_t OodLZ_DecoderMemorySizeNeededFunc(int codec, int64_t raw_len);
+typedef int64_t OodLZ_CompressScratchMemBoundFunc(int codec, int level, int64_t raw_len, void* opts);
+
+// Compressed size of the blocks covering raw_seek_bytes from start_raw_pos. Optional, needed for threaded decompression.
+typedef int64_t OodLZ_GetCompressedStepForRawStepFunc(
+    const uint8_t* comp_buf, int64_t comp_avail, int64_t start_raw_pos, int64_t raw_seek_bytes, int64_t* end_raw_pos, int* independent);
+
 namespace fs = std::filesystem;
 
 namespace HAYDEN
 {
-    // Decompress using Oodle DLL
+    // Codec numbers as OodleLZ_Compress takes them. The game's Oodle decodes any of them.
+    enum class OodleCodec : int
+    {
+        Kraken = 8,
+        Mermaid = 9,                            // faster to compress and decode, bigger output
+        Leviathan = 13                          // slower to compress, smallest output
+    };
+
+    // Level 1 (SuperFast) to 9 (Optimal5), 4 (Normal) is what the game's own files use
+    struct OodleSettings
+    {
+        OodleCodec Codec = OodleCodec::Kraken;
+        int Level = 4;
+    };
+
+    const char* getOodleCodecName(OodleCodec codec);
+    bool parseOodleCodec(const std::string& name, OodleCodec& codec);
+
+    // Decompress using Oodle DLL. The library is loaded once per process, on the first successful oodleInit.
+    // A base path that failed to load returns false straight away after that. On Linux, the working directory
+    // gets a link to the game's oo2core_8_win64.dll, since linoodle only looks for it there.
+    // Everything here can be called from any number of threads at once.
     bool oodleInit(const std::string& basePath);
-    std::vector<uint8_t> oodleDecompress(std::vector<uint8_t> compressedData, const uint64_t decompressedSize);
-    int oodleCompress(std::string filename, std::string destFilename);
+    bool oodleIsLoaded();
+    std::vector<uint8_t> oodleDecompress(const std::vector<uint8_t>& compressedData, const uint64_t decompressedSize);
+    std::vector<uint8_t> oodleCompress(const uint8_t* data, const uint64_t size, const OodleSettings& settings = OodleSettings());
+
+    // Buffer to buffer versions, for hot paths. Output is provided by the caller and nothing else is allocated,
+    // scratch memory is kept per thread and reused from one call to the next.
+    uint64_t oodleDecompress(const uint8_t* compressedData, const uint64_t compressedSize, uint8_t* output, const uint64_t decompressedSize);
+    uint64_t oodleCompress(const uint8_t* data, const uint64_t size, uint8_t* output, const uint64_t outputSize, const OodleSettings& settings = OodleSettings());
+
+    // Output size oodleCompress needs for size bytes of input
+    uint64_t oodleCompressBound(const uint64_t size);
+
+    const uint32_t OODLE_TUNING_MAGIC = 0x4E55544F;  // "OTUN"
+    const uint32_t OODLE_TUNING_VERSION = 1;
+
+#pragma pack(push)  // Not portable, sorry.
+#pragma pack(1)     // Works on my machine (TM).
+
+    // cache/oodle_tuning.bin, written by oodleTuneDecompression
+    struct OodleTuningFileHeader // 0x18 bytes
+    {
+        /* 0x00 */ uint32_t Magic = OODLE_TUNING_MAGIC;
+        /* 0x04 */ uint32_t FormatVersion = OODLE_TUNING_VERSION;
+        /* 0x08 */ uint32_t NumThreads = 0;        // hardware threads when it was measured
+        /* 0x0C */ uint32_t Unused0C = 0;
+        /* 0x10 */ uint64_t ThreadedCutoff = UINT64_MAX;
+    };
+
+#pragma pack(pop)
+
+    // One size measured by oodleTuneDecompression
+    struct OodleDecompressBenchmark
+    {
+        uint64_t Size = 0;
+        double UnthreadedSeconds = 0;
+        double ThreadedSeconds = 0;
+        bool IsThreadedValid = 0;               // threaded output matched unthreaded output
+
+        double UnthreadedMegabytesPerSecond() const { return UnthreadedSeconds > 0 ? (Size / (1024.0 * 1024.0)) / UnthreadedSeconds : 0; }
+        double ThreadedMegabytesPerSecond() const { return ThreadedSeconds > 0 ? (Size / (1024.0 * 1024.0)) / ThreadedSeconds : 0; }
+    };
+
+    struct OodleDecompressTuning
+    {
+        std::vector<OodleDecompressBenchmark> Benchmarks;
+        uint64_t ThreadedCutoff = UINT64_MAX;   // UINT64_MAX = never threaded
+    };
+
+    // Large buffers are decompressed on several threads, with Oodle's two decode phases pipelined block by block.
+    // Where the threaded path starts paying off is measured on this machine by oodleTuneDecompression (--tune-decompression),
+    // which should run on an otherwise idle machine. The first large decompression loads the saved cutoff from
+    // cache/oodle_tuning.bin. Without one, only buffers of 16 MB and up are threaded.
+    bool oodleCanDecompressThreaded();
+    uint64_t oodleGetThreadedCutoff();
+
+    // Benchmarks both paths on generated data, then uses and saves the cutoff found
+    OodleDecompressTuning oodleTuneDecompression();
 }
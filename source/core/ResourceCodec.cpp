@@ -0,0 +1,166 @@
+#include "ResourceCodec.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+
+#ifdef HAS_ZLIB
+#include <zlib.h>
+#endif
+
+namespace HAYDEN
+{
+    // Stored data. Compressed and decompressed sizes have to match.
+    class StoredResourceCodec : public ResourceCodec
+    {
+        public:
+            const char* GetName() const override { return "none"; }
+
+            uint64_t Decompress(const uint8_t* compressedData, const uint64_t compressedSize, uint8_t* output, const uint64_t decompressedSize) const override
+            {
+                if (compressedSize != decompressedSize)
+                    return 0;
+
+                memcpy(output, compressedData, compressedSize);
+                return decompressedSize;
+            }
+    };
+
+#ifdef HAS_ZLIB
+    // zlib or gzip streams, and raw deflate for data without either header
+    class ZlibResourceCodec : public ResourceCodec
+    {
+        public:
+            const char* GetName() const override { return "zlib"; }
+
+            uint64_t Decompress(const uint8_t* compressedData, const uint64_t compressedSize, uint8_t* output, const uint64_t decompressedSize) const override
+            {
+                uint64_t outbytes = Inflate(15 + 32, compressedData, compressedSize, output, decompressedSize);
+                if (outbytes == 0)
+                    outbytes = Inflate(-15, compressedData, compressedSize, output, decompressedSize);
+
+                return outbytes;
+            }
+
+        private:
+            static uint64_t Inflate(const int windowBits, const uint8_t* compressedData, const uint64_t compressedSize, uint8_t* output, const uint64_t decompressedSize)
+            {
+                // zlib counts in uInt, entries never get near that
+                if (compressedSize > UINT32_MAX || decompressedSize > UINT32_MAX)
+                    return 0;
+
+                z_stream stream;
+                memset(&stream, 0, sizeof(z_stream));
+                if (inflateInit2(&stream, windowBits) != Z_OK)
+                    return 0;
+
+                stream.next_in = (Bytef*)compressedData;
+                stream.avail_in = (uInt)compressedSize;
+                stream.next_out = output;
+                stream.avail_out = (uInt)decompressedSize;
+
+                int result = inflate(&stream, Z_FINISH);
+                uint64_t outbytes = stream.total_out;
+                inflateEnd(&stream);
+
+                if (result != Z_STREAM_END || outbytes != decompressedSize)
+                    return 0;
+
+                return outbytes;
+            }
+    };
+#endif
+
+    // The game's own codecs. The mode doesn't matter, Oodle reads the codec from the stream.
+    class OodleResourceCodec : public ResourceCodec
+    {
+        public:
+            const char* GetName() const override { return "oodle"; }
+
+            uint64_t Decompress(const uint8_t* compressedData, const uint64_t compressedSize, uint8_t* output, const uint64_t decompressedSize) const override
+            {
+                return oodleDecompress(compressedData, compressedSize, output, decompressedSize);
+            }
+    };
+
+    // Stand-in for Oodle: the compressed bytes, then zeros up to decompressedSize
+    class PassThroughResourceCodec : public ResourceCodec
+    {
+        public:
+            const char* GetName() const override { return "pass-through"; }
+
+            uint64_t Decompress(const uint8_t* compressedData, const uint64_t compressedSize, uint8_t* output, const uint64_t decompressedSize) const override
+            {
+                uint64_t copySize = std::min(compressedSize, decompressedSize);
+                memcpy(output, compressedData, copySize);
+                memset(output + copySize, 0, decompressedSize - copySize);
+                return decompressedSize;
+            }
+    };
+
+    static const StoredResourceCodec StoredDecoder;
+    static const OodleResourceCodec OodleDecoder;
+    static const PassThroughResourceCodec PassThroughDecoder;
+
+#ifdef HAS_ZLIB
+    static const ZlibResourceCodec ZlibDecoder;
+    static const ResourceCodec* const DEFAULT_ZLIB_CODEC = &ZlibDecoder;
+#else
+    static const ResourceCodec* const DEFAULT_ZLIB_CODEC = NULL;
+#endif
+
+    // Indexed by compression mode. Modes 3 and up to NUM_RESOURCE_COMPRESSION_MODES without a codec fail to decompress.
+    static std::atomic<const ResourceCodec*> ResourceCodecs[NUM_RESOURCE_COMPRESSION_MODES] = {
+        { &StoredDecoder },
+        { DEFAULT_ZLIB_CODEC },
+        { &OodleDecoder },
+        { NULL },
+        { &OodleDecoder },
+        { &OodleDecoder }
+    };
+
+    const ResourceCodec* getResourceCodec(const uint16_t compressionMode)
+    {
+        if (compressionMode >= NUM_RESOURCE_COMPRESSION_MODES)
+            return NULL;
+
+        return ResourceCodecs[compressionMode].load(std::memory_order_acquire);
+    }
+
+    void setResourceCodec(const ResourceCompressionMode compressionMode, const ResourceCodec* codec)
+    {
+        ResourceCodecs[(uint16_t)compressionMode].store(codec, std::memory_order_release);
+    }
+
+    void useStandInResourceCodec()
+    {
+        for (ResourceCompressionMode compressionMode : { ResourceCompressionMode::Kraken, ResourceCompressionMode::KrakenVariant, ResourceCompressionMode::Leviathan })
+            setResourceCodec(compressionMode, &PassThroughDecoder);
+    }
+
+    bool isStandInResourceCodecInUse()
+    {
+        return getResourceCodec((uint16_t)ResourceCompressionMode::Kraken) == &PassThroughDecoder;
+    }
+
+    uint64_t decompressResource(const uint16_t compressionMode, const uint8_t* compressedData, const uint64_t compressedSize, uint8_t* output, const uint64_t decompressedSize)
+    {
+        const ResourceCodec* codec = getResourceCodec(compressionMode);
+        if (codec == NULL)
+        {
+            fprintf(stderr, "Error: no codec for compression mode %u.\n", compressionMode);
+            return 0;
+        }
+
+        return codec->Decompress(compressedData, compressedSize, output, decompressedSize);
+    }
+
+    // Returns an empty vector on failure
+    std::vector<uint8_t> decompressResource(const uint16_t compressionMode, const std::vector<uint8_t>& compressedData, const uint64_t decompressedSize)
+    {
+        std::vector<uint8_t> output(decompressedSize + SAFE_SPACE);
+        output.resize(decompressResource(compressionMode, compressedData.data(), compressedData.size(), output.data(), decompressedSize));
+        return output;
+    }
+}
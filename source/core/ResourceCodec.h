@@ -0,0 +1,55 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "Oodle.h"
+
+namespace HAYDEN
+{
+    // ResourceFileEntry::CompressionMode
+    enum class ResourceCompressionMode : uint16_t
+    {
+        None = 0,
+        Zlib = 1,
+        Kraken = 2,
+        KrakenVariant = 4,
+        Leviathan = 5
+    };
+
+    const uint16_t NUM_RESOURCE_COMPRESSION_MODES = 6;
+
+    // Decompresses one compression mode. Implementations are called from any number of threads at once.
+    class ResourceCodec
+    {
+        public:
+            virtual ~ResourceCodec() {}
+
+            virtual const char* GetName() const = 0;
+
+            // Output holds at least decompressedSize + SAFE_SPACE bytes. Returns bytes written, 0 on failure.
+            virtual uint64_t Decompress(const uint8_t* compressedData, const uint64_t compressedSize, uint8_t* output, const uint64_t decompressedSize) const = 0;
+    };
+
+    // The codec registered for a mode, NULL if there is none. By default:
+    //   None            stored data, copied as-is
+    //   Zlib            zlib or raw deflate, when built with zlib
+    //   Kraken, KrakenVariant, Leviathan   the game's Oodle library, once oodleInit has loaded it
+    const ResourceCodec* getResourceCodec(const uint16_t compressionMode);
+
+    // Replaces the codec for a mode, NULL removes it. The codec has to outlive every call using it.
+    // Meant for startup, before any worker threads are decompressing.
+    void setResourceCodec(const ResourceCompressionMode compressionMode, const ResourceCodec* codec);
+
+    // Registers a pass-through stand-in for the Oodle modes, for machines without the game's library.
+    // It copies the compressed bytes and zero fills the rest, so parsing, extraction and conversion run end to end
+    // at roughly the speed of a memcpy. The output of Oodle compressed entries isn't real data while it's in use,
+    // and anything written meanwhile (imported geometry, patched entries) is stored uncompressed so it can be read back.
+    void useStandInResourceCodec();
+    bool isStandInResourceCodecInUse();
+
+    // Decompresses with the codec for compressionMode. Returns bytes written, 0 on failure or if there's no codec for the mode.
+    uint64_t decompressResource(const uint16_t compressionMode, const uint8_t* compressedData, const uint64_t compressedSize, uint8_t* output, const uint64_t decompressedSize);
+    std::vector<uint8_t> decompressResource(const uint16_t compressionMode, const std::vector<uint8_t>& compressedData, const uint64_t decompressedSize);
+}
@@ -0,0 +1,79 @@
+#include "ResourceDependencyGraph.h"
+#include "ResourceFileReader.h"
+
+namespace HAYDEN
+{
+    void ResourceDependencyGraph::Build(const ResourceTable& resourceTable, const std::vector<ResourceDependency>& dependencies, const std::vector<uint32_t>& dependencyIndexes)
+    {
+        Clear();
+
+        // Give every distinct dependency name a node index
+        std::vector<uint32_t> dependencyNodes(dependencies.size());
+        for (uint32_t i = 0; i < dependencies.size(); i++)
+            dependencyNodes[i] = _NameIndexes.emplace(std::string_view(dependencies[i].Name), (uint32_t)_NameIndexes.size()).first->second;
+
+        // Forward edges, skipping anything that points outside the dependency table
+        const std::vector<uint64_t>& dependencyIndexNumbers = resourceTable.GetDependencyIndexNumbers();
+        const std::vector<uint16_t>& numDependencies = resourceTable.GetNumDependencies();
+
+        _ForwardOffsets.resize(resourceTable.Size() + 1);
+        for (uint32_t i = 0; i < resourceTable.Size(); i++)
+        {
+            _ForwardOffsets[i] = (uint32_t)_ForwardEdges.size();
+
+            uint64_t first = dependencyIndexNumbers[i];
+            uint64_t last = first + numDependencies[i];
+            for (uint64_t j = first; j < last && j < dependencyIndexes.size(); j++)
+            {
+                if (dependencyIndexes[j] < dependencies.size())
+                    _ForwardEdges.push_back(dependencyIndexes[j]);
+            }
+        }
+        _ForwardOffsets[resourceTable.Size()] = (uint32_t)_ForwardEdges.size();
+
+        // Reverse edges: count per node, prefix sum, then fill
+        _ReverseOffsets.assign(_NameIndexes.size() + 1, 0);
+        for (uint32_t edge : _ForwardEdges)
+            _ReverseOffsets[dependencyNodes[edge] + 1]++;
+
+        for (size_t i = 1; i < _ReverseOffsets.size(); i++)
+            _ReverseOffsets[i] += _ReverseOffsets[i - 1];
+
+        std::vector<uint32_t> fillOffsets(_ReverseOffsets.begin(), _ReverseOffsets.end() - 1);
+        _ReverseEdges.resize(_ForwardEdges.size());
+
+        for (uint32_t i = 0; i < resourceTable.Size(); i++)
+        {
+            for (uint32_t j = _ForwardOffsets[i]; j < _ForwardOffsets[i + 1]; j++)
+                _ReverseEdges[fillOffsets[dependencyNodes[_ForwardEdges[j]]]++] = i;
+        }
+    }
+
+    void ResourceDependencyGraph::Clear()
+    {
+        _ForwardOffsets.clear();
+        _ForwardEdges.clear();
+        _NameIndexes.clear();
+        _ReverseOffsets.clear();
+        _ReverseEdges.clear();
+    }
+
+    // Indexes into the dependency table for everything this entry depends on
+    ArrayView<uint32_t> ResourceDependencyGraph::GetDependencies(uint32_t entryIndex) const
+    {
+        if (entryIndex + (uint64_t)1 >= _ForwardOffsets.size())
+            return ArrayView<uint32_t>();
+
+        return MakeView(_ForwardEdges, _ForwardOffsets[entryIndex], _ForwardOffsets[entryIndex + 1]);
+    }
+
+    // Indexes of every entry that depends on a resource with this name. Empty if nothing references it.
+    ArrayView<uint32_t> ResourceDependencyGraph::GetDependents(std::string_view name) const
+    {
+        auto node = _NameIndexes.find(name);
+        if (node == _NameIndexes.end())
+            return ArrayView<uint32_t>();
+
+        return MakeView(_ReverseEdges, _ReverseOffsets[node->second], _ReverseOffsets[node->second + 1]);
+    }
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+
+#include "MappedFile.h"
+
+namespace HAYDEN
+{
+    class ResourceTable;
+    struct ResourceDependency;
+
+    // Dependency graph for the entries of a single .resources file, stored in compressed sparse row form.
+    //
+    // Forward edges go from an entry to the dependency records it lists.
+    // Reverse edges go from a dependency name to every entry that lists it, so "who references X" is a single lookup.
+    class ResourceDependencyGraph
+    {
+        public:
+
+            // Indexes into the dependency table for everything this entry depends on
+            ArrayView<uint32_t> GetDependencies(uint32_t entryIndex) const;
+
+            // Indexes of every entry that depends on a resource with this name. Empty if nothing references it.
+            ArrayView<uint32_t> GetDependents(std::string_view name) const;
+
+            // Dependencies must stay alive and unmodified for as long as the graph is used
+            void Build(const ResourceTable& resourceTable, const std::vector<ResourceDependency>& dependencies, const std::vector<uint32_t>& dependencyIndexes);
+            void Clear();
+
+        private:
+
+            // Forward edges: entry i depends on _ForwardEdges[_ForwardOffsets[i] .. _ForwardOffsets[i + 1])
+            std::vector<uint32_t> _ForwardOffsets;
+            std::vector<uint32_t> _ForwardEdges;
+
+            // Reverse edges: dependency name n is referenced by _ReverseEdges[_ReverseOffsets[n] .. _ReverseOffsets[n + 1])
+            std::unordered_map<std::string_view, uint32_t> _NameIndexes;
+            std::vector<uint32_t> _ReverseOffsets;
+            std::vector<uint32_t> _ReverseEdges;
+
+            template <typename T>
+            static ArrayView<T> MakeView(const std::vector<T>& data, uint64_t start, uint64_t end) { return ArrayView<T>((const uint8_t*)(data.data() + start), end - start); }
+    };
+}
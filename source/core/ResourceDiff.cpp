@@ -0,0 +1,244 @@
+#include "ResourceDiff.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <unordered_map>
+
+#include "ResourceCodec.h"
+#include "Utilities.h"
+
+namespace HAYDEN
+{
+    // Same data, judged by metadata alone
+    static bool hasSameMetadata(const ResourceEntry& original, const ResourceEntry& modified)
+    {
+        if (original.DataSizeUncompressed != modified.DataSizeUncompressed)
+            return 0;
+
+        if (original.DataCheckSum != 0 && modified.DataCheckSum != 0)
+            return original.DataCheckSum == modified.DataCheckSum;
+
+        return original.DataOffset == modified.DataOffset && original.DataSize == modified.DataSize && original.CompressionMode == modified.CompressionMode;
+    }
+
+    // Reads and decompresses one entry into buffers owned by the caller. Returns NULL on failure.
+    static const uint8_t* readEntry(FILE* f, const ResourceEntry& entry, std::vector<uint8_t>& compressedData, std::vector<uint8_t>& decompressedData)
+    {
+        compressedData.resize(entry.DataSize);
+        if (f == NULL || readFileAt(f, compressedData.data(), entry.DataSize, entry.DataOffset) != entry.DataSize)
+            return NULL;
+
+        if (entry.DataSize == entry.DataSizeUncompressed)
+            return compressedData.data();
+
+        decompressedData.resize(entry.DataSizeUncompressed + SAFE_SPACE);
+        if (decompressResource(entry.CompressionMode, compressedData.data(), entry.DataSize, decompressedData.data(), entry.DataSizeUncompressed) != entry.DataSizeUncompressed)
+            return NULL;
+
+        return decompressedData.data();
+    }
+
+    // Compares every entry matching filter. numThreads = 0 uses one worker per core.
+    DiffStats ResourceDiff::Compare(const ResourceFilter& filter, uint32_t numThreads)
+    {
+        DiffStats stats;
+        auto diffStart = std::chrono::steady_clock::now();
+
+        const ResourceTable& originalTable = _OriginalReader.ParseResourceFile();
+        const ResourceTable& modifiedTable = _ModifiedReader.ParseResourceFile();
+
+        // Hash index over the modified archive. Names can repeat with different types, those are chained through nextSameName.
+        const uint32_t END_OF_CHAIN = 0xFFFFFFFF;
+        std::unordered_map<std::string_view, uint32_t> firstByName;
+        std::vector<uint32_t> nextSameName(modifiedTable.Size(), END_OF_CHAIN);
+        std::vector<uint8_t> isMatched(modifiedTable.Size(), 0);
+        firstByName.reserve(modifiedTable.Size());
+
+        for (uint32_t i = (uint32_t)modifiedTable.Size(); i-- > 0;)
+        {
+            if (!filter.Matches(modifiedTable.GetEntry(i)))
+                continue;
+
+            stats.NumModifiedEntries++;
+            auto first = firstByName.emplace(modifiedTable.GetName(i), i);
+            if (!first.second)
+            {
+                nextSameName[i] = first.first->second;
+                first.first->second = i;
+            }
+        }
+
+        // Join on name and type. Pairs with different metadata are queued for a byte compare.
+        std::vector<std::pair<ResourceEntry, ResourceEntry>> comparePairs;
+        for (uint32_t i = 0; i < originalTable.Size(); i++)
+        {
+            ResourceEntry original = originalTable.GetEntry(i);
+            if (!filter.Matches(original))
+                continue;
+
+            stats.NumOriginalEntries++;
+
+            uint32_t match = END_OF_CHAIN;
+            auto first = firstByName.find(original.Name);
+            for (uint32_t j = (first != firstByName.end()) ? first->second : END_OF_CHAIN; j != END_OF_CHAIN; j = nextSameName[j])
+            {
+                if (!isMatched[j] && modifiedTable.GetType(j) == original.Type)
+                {
+                    match = j;
+                    break;
+                }
+            }
+
+            if (match == END_OF_CHAIN)
+            {
+                ResourceDifference difference;
+                difference.Change = ResourceChange::Removed;
+                difference.Name = original.Name;
+                difference.Type = original.Type;
+                difference.OriginalSize = original.DataSizeUncompressed;
+                difference.OriginalCheckSum = original.DataCheckSum;
+                stats.Differences.push_back(difference);
+                continue;
+            }
+
+            isMatched[match] = 1;
+            ResourceEntry modified = modifiedTable.GetEntry(match);
+
+            if (hasSameMetadata(original, modified))
+                stats.NumUnchanged++;
+            else
+                comparePairs.emplace_back(original, modified);
+        }
+
+        // Read both archives front to back as far as possible
+        std::sort(comparePairs.begin(), comparePairs.end(), [](const auto& a, const auto& b) {
+            return a.first.DataOffset < b.first.DataOffset;
+        });
+
+        // Byte compare on all workers. Each worker keeps its own buffers, reads are positioned so the FILE*s are shared.
+        FILE* originalFile = fopen(_OriginalReader.ResourceFilePath.string().c_str(), "rb");
+        FILE* modifiedFile = fopen(_ModifiedReader.ResourceFilePath.string().c_str(), "rb");
+
+        std::vector<int64_t> firstDifferences(comparePairs.size(), -1);
+        std::vector<uint8_t> hasFailed(comparePairs.size(), 0);
+        std::atomic<uint64_t> bytesRead(0);
+        std::atomic<uint64_t> bytesCompared(0);
+        std::atomic<uint64_t> nextPair(0);
+
+        auto compareWorker = [&]()
+        {
+            std::vector<uint8_t> originalCompressed, originalDecompressed;
+            std::vector<uint8_t> modifiedCompressed, modifiedDecompressed;
+
+            for (uint64_t i = nextPair++; i < comparePairs.size(); i = nextPair++)
+            {
+                const ResourceEntry& original = comparePairs[i].first;
+                const ResourceEntry& modified = comparePairs[i].second;
+
+                const uint8_t* originalData = readEntry(originalFile, original, originalCompressed, originalDecompressed);
+                const uint8_t* modifiedData = readEntry(modifiedFile, modified, modifiedCompressed, modifiedDecompressed);
+                bytesRead += original.DataSize + modified.DataSize;
+
+                if (originalData == NULL || modifiedData == NULL)
+                {
+                    hasFailed[i] = 1;
+                    continue;
+                }
+
+                // Sizes may differ, then the first difference is where the shorter one ends
+                uint64_t commonSize = std::min(original.DataSizeUncompressed, modified.DataSizeUncompressed);
+                const uint64_t blockSize = 4096;
+                uint64_t offset = 0;
+
+                while (offset < commonSize && memcmp(originalData + offset, modifiedData + offset, std::min(blockSize, commonSize - offset)) == 0)
+                    offset += blockSize;
+
+                while (offset < commonSize && originalData[offset] == modifiedData[offset])
+                    offset++;
+
+                offset = std::min(offset, commonSize);
+                if (offset < commonSize || original.DataSizeUncompressed != modified.DataSizeUncompressed)
+                    firstDifferences[i] = offset;
+
+                bytesCompared += commonSize;
+            }
+        };
+
+        if (numThreads == 0)
+            numThreads = std::max(1u, std::thread::hardware_concurrency());
+        numThreads = std::max<uint32_t>(1, std::min<uint64_t>(numThreads, comparePairs.size()));
+
+        std::vector<std::thread> workers;
+        for (uint32_t i = 1; i < numThreads; i++)
+            workers.emplace_back(compareWorker);
+
+        compareWorker();
+        for (auto& worker : workers)
+            worker.join();
+
+        if (originalFile != NULL)
+            fclose(originalFile);
+        else
+            fprintf(stderr, "ERROR : ResourceDiff : Failed to open %s for reading.\n", _OriginalReader.ResourceFilePath.string().c_str());
+
+        if (modifiedFile != NULL)
+            fclose(modifiedFile);
+        else
+            fprintf(stderr, "ERROR : ResourceDiff : Failed to open %s for reading.\n", _ModifiedReader.ResourceFilePath.string().c_str());
+
+        for (uint64_t i = 0; i < comparePairs.size(); i++)
+        {
+            const ResourceEntry& original = comparePairs[i].first;
+            const ResourceEntry& modified = comparePairs[i].second;
+
+            if (hasFailed[i])
+            {
+                fprintf(stderr, "ERROR : ResourceDiff : Failed to read %s\n", std::string(original.Name).c_str());
+                stats.NumFailed++;
+                continue;
+            }
+
+            stats.NumCompared++;
+
+            ResourceDifference difference;
+            difference.Change = firstDifferences[i] == -1 ? ResourceChange::MetadataOnly : ResourceChange::Modified;
+            difference.Name = original.Name;
+            difference.Type = original.Type;
+            difference.OriginalSize = original.DataSizeUncompressed;
+            difference.ModifiedSize = modified.DataSizeUncompressed;
+            difference.OriginalCheckSum = original.DataCheckSum;
+            difference.ModifiedCheckSum = modified.DataCheckSum;
+            difference.FirstDifference = firstDifferences[i];
+            stats.Differences.push_back(difference);
+        }
+
+        // Whatever wasn't joined only exists in the modified archive
+        for (uint32_t i = 0; i < modifiedTable.Size(); i++)
+        {
+            if (isMatched[i])
+                continue;
+
+            ResourceEntry modified = modifiedTable.GetEntry(i);
+            if (!filter.Matches(modified))
+                continue;
+
+            ResourceDifference difference;
+            difference.Change = ResourceChange::Added;
+            difference.Name = modified.Name;
+            difference.Type = modified.Type;
+            difference.ModifiedSize = modified.DataSizeUncompressed;
+            difference.ModifiedCheckSum = modified.DataCheckSum;
+            stats.Differences.push_back(difference);
+        }
+
+        stats.BytesRead = bytesRead;
+        stats.BytesCompared = bytesCompared;
+
+        std::chrono::duration<double> diffTime = std::chrono::steady_clock::now() - diffStart;
+        stats.Seconds = diffTime.count();
+        return stats;
+    }
+}
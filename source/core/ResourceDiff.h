@@ -0,0 +1,68 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <filesystem>
+
+#include "ResourceFileReader.h"
+#include "ResourcePipeline.h"
+
+namespace fs = std::filesystem;
+
+namespace HAYDEN
+{
+    enum class ResourceChange
+    {
+        Added,                                  // only in the modified archive
+        Removed,                                // only in the original archive
+        Modified,                               // in both, data differs
+        MetadataOnly                            // in both, metadata differs but the data is byte for byte the same
+    };
+
+    struct ResourceDifference
+    {
+        ResourceChange Change = ResourceChange::Modified;
+        std::string Name;
+        std::string Type;
+        uint64_t OriginalSize = 0;              // decompressed sizes, 0 if the entry isn't in that archive
+        uint64_t ModifiedSize = 0;
+        uint64_t OriginalCheckSum = 0;
+        uint64_t ModifiedCheckSum = 0;
+        int64_t FirstDifference = -1;           // offset of the first differing byte, -1 if the data wasn't compared
+    };
+
+    struct DiffStats
+    {
+        uint64_t NumOriginalEntries = 0;        // entries passing the filter in each archive
+        uint64_t NumModifiedEntries = 0;
+        uint64_t NumUnchanged = 0;              // matched by metadata alone, never read
+        uint64_t NumCompared = 0;               // pairs that were decompressed and compared
+        uint64_t NumFailed = 0;                 // pairs that couldn't be read or decompressed
+        uint64_t BytesRead = 0;                 // compressed bytes read from both archives
+        uint64_t BytesCompared = 0;             // decompressed bytes compared
+        double Seconds = 0;
+        std::vector<ResourceDifference> Differences;
+
+        double MegabytesPerSecond() const { return Seconds > 0 ? (BytesCompared / (1024.0 * 1024.0)) / Seconds : 0; }
+    };
+
+    // Compares two versions of the same .resources file, e.g. a patched archive and its .resources.backup.
+    //
+    // Entries are joined by name and type through a hash index over the modified archive.
+    // Pairs are then compared by metadata: if both have a checksum, equal checksums and sizes mean the entry is unchanged.
+    // Without checksums, the data's offset, sizes and compression must all be equal instead.
+    // Only pairs that fail this are read, decompressed and compared byte for byte, on a pool of workers.
+    class ResourceDiff
+    {
+        public:
+
+            // Compares every entry matching filter. numThreads = 0 uses one worker per core.
+            DiffStats Compare(const ResourceFilter& filter, uint32_t numThreads = 0);
+
+            ResourceDiff(ResourceFileReader& originalReader, ResourceFileReader& modifiedReader) : _OriginalReader(originalReader), _ModifiedReader(modifiedReader) {}
+
+        private:
+            ResourceFileReader& _OriginalReader;
+            ResourceFileReader& _ModifiedReader;
+    };
+}
@@ -0,0 +1,63 @@
+#include "ResourceExtractor.h"
+
+#include <chrono>
+
+#include "Utilities.h"
+
+namespace HAYDEN
+{
+    // Extracts every entry matching filter to outputPath/<entry name>. numThreads = 0 uses one decompression worker per core.
+    ExtractionStats ResourceExtractor::Extract(const fs::path& outputPath, const ResourceFilter& filter, uint32_t numThreads)
+    {
+        ExtractionStats stats;
+        auto extractStart = std::chrono::steady_clock::now();
+        fs::path absoluteOutputPath = fs::absolute(outputPath);
+
+        std::vector<ResourceEntry> selectedEntries = filter.SelectEntries(_ResourceReader);
+
+        // Files are written on this thread, in archive order
+        ResourcePipeline pipeline;
+        pipeline.FinishJob = [&](ResourceJob& job)
+        {
+            bool writeFailed = job.Failed;
+
+            fs::path filePath;
+            if (!writeFailed && !getEntryOutputPath(absoluteOutputPath, std::string(job.Entry.Name), filePath))
+                writeFailed = 1;
+
+            if (!writeFailed)
+            {
+                if (!fs::exists(filePath.parent_path()))
+                    mkpath(filePath.parent_path());
+
+                FILE* f = openLongFilePath(filePath); //wb
+                if (f != NULL)
+                {
+                    writeFailed = fwrite(job.Output, 1, job.Entry.DataSizeUncompressed, f) != job.Entry.DataSizeUncompressed;
+                    fclose(f);
+                }
+                else
+                {
+                    writeFailed = 1;
+                }
+            }
+
+            if (writeFailed)
+            {
+                fprintf(stderr, "ERROR : ResourceExtractor : Failed to extract %s\n", std::string(job.Entry.Name).c_str());
+                stats.NumFailed++;
+            }
+            else
+            {
+                stats.NumEntries++;
+                stats.BytesWritten += job.Entry.DataSizeUncompressed;
+            }
+        };
+
+        stats.BytesRead = pipeline.Run(_ResourceReader.ResourceFilePath, selectedEntries, numThreads);
+
+        std::chrono::duration<double> extractTime = std::chrono::steady_clock::now() - extractStart;
+        stats.Seconds = extractTime.count();
+        return stats;
+    }
+}
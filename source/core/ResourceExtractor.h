@@ -0,0 +1,40 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <filesystem>
+
+#include "ResourceFileReader.h"
+#include "ResourcePipeline.h"
+
+namespace fs = std::filesystem;
+
+namespace HAYDEN
+{
+    struct ExtractionStats
+    {
+        uint64_t NumEntries = 0;                // entries written successfully
+        uint64_t NumFailed = 0;                 // entries that couldn't be read, decompressed or written
+        uint64_t BytesRead = 0;                 // compressed bytes read from the archive
+        uint64_t BytesWritten = 0;              // decompressed bytes written to disk
+        double Seconds = 0;
+
+        double MegabytesPerSecond() const { return Seconds > 0 ? (BytesWritten / (1024.0 * 1024.0)) / Seconds : 0; }
+        double EntriesPerSecond() const { return Seconds > 0 ? NumEntries / Seconds : 0; }
+    };
+
+    // Bulk extraction of embedded files from a single .resources file.
+    // Entries go through a ResourcePipeline; files are written in the same order they were read, so both disks see sequential access.
+    class ResourceExtractor
+    {
+        public:
+
+            // Extracts every entry matching filter to outputPath/<entry name>. numThreads = 0 uses one decompression worker per core.
+            ExtractionStats Extract(const fs::path& outputPath, const ResourceFilter& filter, uint32_t numThreads = 0);
+
+            ResourceExtractor(ResourceFileReader& resourceReader) : _ResourceReader(resourceReader) {}
+
+        private:
+            ResourceFileReader& _ResourceReader;
+    };
+}
@@ -1,91 +1,271 @@
 #include "ResourceFileReader.h"
+#include "ResourceTOCCache.h"
 
 namespace HAYDEN
 {
     // Retrieve embedded file data for a specific file entry
-    std::vector<uint8_t> ResourceFileReader::GetEmbeddedFileHeader(FILE* f, const uint64_t fileOffset, const uint64_t compressedSize, const uint64_t decompressedSize)
+    std::vector<uint8_t> ResourceFileReader::GetEmbeddedFileHeader(FILE* f, const uint64_t fileOffset, const uint64_t compressedSize, const uint64_t decompressedSize, const uint16_t compressionMode)
     {
         std::vector<uint8_t> embeddedHeader(compressedSize);
-        fseek(f, (long)fileOffset, SEEK_SET);
-        fread(embeddedHeader.data(), 1, compressedSize, f);
+        if (readFileAt(f, embeddedHeader.data(), compressedSize, fileOffset) != compressedSize)
+        {
+            fprintf(stderr, "ERROR : ResourceFileReader : Failed to read embedded file at offset %llu.\n", (unsigned long long)fileOffset);
+            return std::vector<uint8_t>();
+        }
 
         if (embeddedHeader.size() != decompressedSize)
-            embeddedHeader = oodleDecompress(embeddedHeader, decompressedSize);
+            embeddedHeader = decompressResource(compressionMode, embeddedHeader, decompressedSize);
 
         return embeddedHeader;
     }
 
-    // Retrieve all entries from a .resources file as vector<ResourceEntry>
-    std::vector<ResourceEntry> ResourceFileReader::ParseResourceFile()
+    // Converts entries from the archive into table rows. If filter is set, names are only resolved for entries that pass it.
+    // Returns false if the parse was cancelled through progress.
+    static bool parseEntries(const fs::path& resourcePath, const ResourceFile& resourceFile, ResourceTable& resourceTable, const ResourceEntryFilter& filter, ResourceLoadProgress* progress)
     {
-        // read .resources file from filesystem
-        ResourceFile resourceFile(ResourceFilePath);
-        std::vector<uint64_t> pathStringIndexes = resourceFile.GetAllPathStringIndexes();
+        ArrayView<uint64_t> pathStringIndexes = resourceFile.GetAllPathStringIndexes();
         uint32_t numFileEntries = resourceFile.GetNumFileEntries();
 
-        // allocate vector to hold all entries from this .resources file
-        std::vector<ResourceEntry> resourceData;
-        resourceData.resize(numFileEntries);
+        if (!filter)
+            resourceTable.Reserve(numFileEntries, 0);
 
         // Parse each resource file and convert to usable data
         for (uint32_t i = 0; i < numFileEntries; i++)
         {
-            ResourceFileEntry& lexedEntry = resourceFile.GetResourceFileEntry(i);
-            resourceData[i].DataOffset = lexedEntry.DataOffset;
-            resourceData[i].DataSize = lexedEntry.DataSize;
-            resourceData[i].DataSizeUncompressed = lexedEntry.DataSizeUncompressed;
-            resourceData[i].Version = lexedEntry.Version;
-            resourceData[i].StreamResourceHash = lexedEntry.StreamResourceHash;
-            resourceData[i].Type = resourceFile.GetResourceStringEntry(pathStringIndexes[lexedEntry.PathTuple_Index]);
-            resourceData[i].Name = resourceFile.GetResourceStringEntry(pathStringIndexes[lexedEntry.PathTuple_Index + 1]);
+            const ResourceFileEntry& lexedEntry = resourceFile.GetResourceFileEntry(i);
+            bool hasPathStrings = lexedEntry.PathTuple_Index + 1 < pathStringIndexes.Size();
+
+            ResourceEntry entry;
+            if (hasPathStrings)
+                entry.Type = resourceFile.GetResourceStringEntry(pathStringIndexes[lexedEntry.PathTuple_Index]);
+
+            bool isSelected = !filter || filter(lexedEntry.Version, entry.Type);
+            if (isSelected)
+            {
+                entry.Index = i;
+                entry.DataOffset = lexedEntry.DataOffset;
+                entry.DataSize = lexedEntry.DataSize;
+                entry.DataSizeUncompressed = lexedEntry.DataSizeUncompressed;
+                entry.Version = lexedEntry.Version;
+                entry.CompressionMode = lexedEntry.CompressionMode;
+                entry.DataCheckSum = lexedEntry.DataCheckSum;
+                entry.StreamResourceHash = lexedEntry.StreamResourceHash;
+                entry.DependencyIndexNumber = lexedEntry.DependencyIndexNumber;
+                entry.NumDependencies = lexedEntry.NumDependencies;
+
+                if (hasPathStrings)
+                    entry.Name = resourceFile.GetResourceStringEntry(pathStringIndexes[lexedEntry.PathTuple_Index + 1]);
+
+                resourceTable.AddEntry(entry);
+            }
+
+            // Publish what we have so far, and stop here if the load was cancelled
+            if (progress != NULL && ((i + 1) % progress->ChunkSize == 0 || i + 1 == numFileEntries))
+            {
+                if (!progress->EndChunk(resourcePath, resourceTable, i + 1, numFileEntries))
+                {
+                    resourceTable.Clear();
+                    return false;
+                }
+            }
         }
+        return true;
+    }
 
-        return resourceData;
-    };
+    // Retrieve all entries from a .resources file as a ResourceTable
+    const ResourceTable& ResourceFileReader::ParseResourceFile()
+    {
+        std::call_once(_ParseOnce, [this]()
+        {
+            parseAll();
+            _IsParsed = 1;
+        });
 
-    // Finds the ResourceID for a specific file
-    uint64_t ResourceFileReader::GetResourceIndex(fs::path targetResourceEntry)
+        return *_ResourceTable;
+    }
+
+    // Only ever runs once, through ParseResourceFile
+    void ResourceFileReader::parseAll()
     {
-        // get resource file entries
-        std::vector<ResourceEntry> resourceEntries = ParseResourceFile();
+        std::shared_ptr<ResourceTable> resourceTable = std::make_shared<ResourceTable>();
+        _ResourceTable = resourceTable;
 
-        // find the resource entry we're looking for
-        ResourceEntry targetEntry;
-        for (int i = 0; i < resourceEntries.size(); i++)
+        // use the sidecar TOC cache if this archive hasn't changed since it was last parsed
+        if (loadTOCCache(ResourceFilePath, *resourceTable, _Dependencies, _DependencyIndexes))
         {
-            if (resourceEntries[i].Name != targetResourceEntry)
-                continue;
+            _Index.Build(*_ResourceTable);
+            return;
+        }
+
+        // read .resources file from filesystem
+        ResourceFile resourceFile(ResourceFilePath);
+        if (!resourceFile.IsLoaded())
+            return;
 
-            // found, stop looking
-            targetEntry = resourceEntries[i];
-            break;
+        parseEntries(ResourceFilePath, resourceFile, *resourceTable, nullptr, NULL);
+
+        // dependency table, resolved to strings while the file is still open
+        ArrayView<ResourceFileDependency> fileDependencies = resourceFile.GetAllFileDependencies();
+        _Dependencies.resize(fileDependencies.Size());
+
+        for (uint64_t i = 0; i < fileDependencies.Size(); i++)
+        {
+            ResourceFileDependency lexedDependency = fileDependencies[i];
+            _Dependencies[i].DependencyType = lexedDependency.DependencyType;
+            _Dependencies[i].Type = resourceFile.GetResourceStringEntry(lexedDependency.AssetTypeStringIndex);
+            _Dependencies[i].Name = resourceFile.GetResourceStringEntry(lexedDependency.FileNameStringIndex);
         }
 
-        return targetEntry.StreamResourceHash;
+        ArrayView<uint32_t> dependencyIndexes = resourceFile.GetAllDependencyIndexes();
+        _DependencyIndexes.resize(dependencyIndexes.Size());
+        std::memcpy(_DependencyIndexes.data(), dependencyIndexes.Data(), dependencyIndexes.Size() * sizeof(uint32_t));
+
+        // build lookup index once, all later searches use this
+        _Index.Build(*_ResourceTable);
+
+        // next time this archive is opened, the sidecar is used instead of a full parse
+        saveTOCCache(ResourceFilePath, *_ResourceTable, _Dependencies, _DependencyIndexes);
+    }
+
+    // Retrieve only the entries that pass filter, without parsing or caching the rest of the file
+    std::shared_ptr<const ResourceTable> ResourceFileReader::ParseResourceFile(const ResourceEntryFilter& filter, ResourceLoadProgress* progress)
+    {
+        std::shared_ptr<ResourceTable> resourceTable = std::make_shared<ResourceTable>();
+
+        // Already parsed, so just pick the rows out of the full table
+        if (_IsParsed)
+        {
+            const std::vector<uint32_t>& versions = _ResourceTable->GetVersions();
+            for (uint32_t i = 0; i < _ResourceTable->Size(); i++)
+            {
+                if (filter(versions[i], _ResourceTable->GetType(i)))
+                    resourceTable->AddEntry(_ResourceTable->GetEntry(i));
+            }
+
+            if (progress != NULL && !progress->EndChunk(ResourceFilePath, *resourceTable, _ResourceTable->Size(), _ResourceTable->Size()))
+                resourceTable->Clear();
+
+            return resourceTable;
+        }
+
+        // A partial table is never written to the sidecar, but a full one can still be read from it
+        if (loadTOCCache(ResourceFilePath, *resourceTable, filter, progress))
+            return resourceTable;
+
+        if (progress != NULL && progress->IsCancelled())
+            return resourceTable;
+
+        ResourceFile resourceFile(ResourceFilePath);
+        if (resourceFile.IsLoaded())
+            parseEntries(ResourceFilePath, resourceFile, *resourceTable, filter, progress);
+
+        return resourceTable;
+    }
+
+    std::shared_ptr<const ResourceTable> ResourceFileReader::GetResourceTable()
+    {
+        ParseResourceFile();
+        return _ResourceTable;
+    }
+
+    std::optional<ResourceEntry> ResourceFileReader::FindEntry(std::string_view name)
+    {
+        const ResourceTable& resourceTable = ParseResourceFile();
+        int64_t i = _Index.FindByName(name);
+        return (i == -1) ? std::optional<ResourceEntry>() : resourceTable.GetEntry((uint32_t)i);
+    }
+
+    std::optional<ResourceEntry> ResourceFileReader::FindEntryByStreamResourceHash(uint64_t streamResourceHash)
+    {
+        const ResourceTable& resourceTable = ParseResourceFile();
+        int64_t i = _Index.FindByStreamResourceHash(streamResourceHash);
+        return (i == -1) ? std::optional<ResourceEntry>() : resourceTable.GetEntry((uint32_t)i);
+    }
+
+    std::vector<uint32_t> ResourceFileReader::GetEntriesByVersion(uint32_t version)
+    {
+        return ParseResourceFile().FindByVersion(version);
+    }
+
+    std::vector<uint32_t> ResourceFileReader::GetEntriesByType(std::string_view type)
+    {
+        return ParseResourceFile().FindByType(type);
+    }
+
+    const std::vector<ResourceDependency>& ResourceFileReader::GetDependencyTable()
+    {
+        ParseResourceFile();
+        return _Dependencies;
+    }
+
+    const ResourceDependencyGraph& ResourceFileReader::GetDependencyGraph()
+    {
+        ParseResourceFile();
+        std::call_once(_DependencyGraphOnce, [this]()
+        {
+            _DependencyGraph.Build(*_ResourceTable, _Dependencies, _DependencyIndexes);
+        });
+        return _DependencyGraph;
+    }
+
+    // Finds the ResourceID for a specific file
+    uint64_t ResourceFileReader::GetResourceIndex(fs::path targetResourceEntry)
+    {
+        // resource names always use forward slashes
+        std::optional<ResourceEntry> targetEntry = FindEntry(targetResourceEntry.generic_string());
+        if (!targetEntry)
+            return 0;
+
+        return targetEntry->StreamResourceHash;
     }
 
     // Convert resource entry ID to streamdb entry ID
     uint64_t ResourceFileReader::CalculateStreamDBIndex(uint64_t resourceId, int mipCount)
     {
-        // Get hex bytes string
-        std::string hexBytes = intToHex(resourceId);
+        uint64_t streamDBIndex = 0;
+        CalculateStreamDBIndexes(&resourceId, &streamDBIndex, 1, mipCount);
+        return streamDBIndex;
+    }
 
-        // Reverse each byte
-        for (int i = 0; i < hexBytes.size(); i += 2)
-            std::swap(hexBytes[i], hexBytes[i + (int64_t)1]);
+    // Convert resource entry IDs to streamdb entry IDs.
+    // Viewed as a hex string: swap the two digits of each byte, shift every digit one place right (the last wraps to the front),
+    // swap the digits of each byte again, then set the second digit from the mip count.
+    void ResourceFileReader::CalculateStreamDBIndexes(const uint64_t* resourceIds, uint64_t* streamDBIndexes, uint64_t count, int mipCount)
+    {
+        const uint64_t lowNibbles = 0x0F0F0F0F0F0F0F0F;
 
-        // Shift digits to the right
-        hexBytes = hexBytes.substr(hexBytes.size() - 1) + hexBytes.substr(0, hexBytes.size() - 1);
+        // Second digit is the last hex digit of (char)(6 + mipCount), printed as an int - so always 'f' when that's negative
+        int mipDigit = (char)(6 + mipCount);
+        uint64_t mipNibble = (mipDigit < 0) ? 0xF : (mipDigit & 0xF);
+
+        for (uint64_t i = 0; i < count; i++)
+        {
+            uint64_t id = resourceIds[i];
+            id = ((id & lowNibbles) << 4) | ((id >> 4) & lowNibbles);
+            id = (id >> 4) | (id << 60);
+            id = ((id & lowNibbles) << 4) | ((id >> 4) & lowNibbles);
+            streamDBIndexes[i] = (id & ~(0xFull << 56)) | (mipNibble << 56);
+        }
+    }
+
+    // .streamdb identifiers for rows of the resource table, straight from the StreamResourceHash column
+    std::vector<uint64_t> ResourceFileReader::GetStreamDBIdentifiers(const std::vector<uint32_t>& rows, int mipCount)
+    {
+        const std::vector<uint64_t>& streamResourceHashes = ParseResourceFile().GetStreamResourceHashes();
+
+        std::vector<uint64_t> identifiers(rows.size());
+        for (size_t i = 0; i < rows.size(); i++)
+        {
+            identifiers[i] = streamResourceHashes[rows[i]];
+            endianSwap(identifiers[i]);
+        }
 
-        // Reverse each byte again
-        for (int i = 0; i < hexBytes.size(); i += 2)
-            std::swap(hexBytes[i], hexBytes[i + (int64_t)1]);
+        CalculateStreamDBIndexes(identifiers.data(), identifiers.data(), identifiers.size(), mipCount);
 
-        // Get second digit based on mip count
-        hexBytes[1] = intToHex((char)(6 + mipCount))[1];
+        for (uint64_t& identifier : identifiers)
+            endianSwap(identifier);
 
-        // Convert hex string back to uint64 and return
-        return hexToInt64(hexBytes);
+        return identifiers;
     }
 
 }
@@ -2,24 +2,28 @@
 
 #include <string>
 #include <vector>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <filesystem>
 
 #include "types/ResourceFile.h"
 
 #include "Oodle.h"
+#include "ResourceCodec.h"
+#include "ResourceDependencyGraph.h"
+#include "ResourceIndex.h"
+#include "ResourceLoadProgress.h"
+#include "ResourceTable.h"
 #include "Utilities.h"
 
 namespace HAYDEN
 {
-    // User-friendly struct for managing .resources data
-    struct ResourceEntry
+    // User-friendly struct for .resources dependency entries
+    struct ResourceDependency
     {
-        uint64_t DataOffset = 0;
-        uint64_t DataSize = 0;
-        uint64_t DataSizeUncompressed = 0;
-        uint64_t StreamResourceHash = 0;
-        uint32_t Version = 0;
-        uint16_t CompressionMode = 0;
+        uint32_t DependencyType = 0;        // 2 = RES_DEP_RESOURCE,  5 = RES_DEP_EMBEDDED_RESOURCE
         std::string Name;
         std::string Type;
     };
@@ -28,10 +32,58 @@ namespace HAYDEN
     {
         public:
             fs::path ResourceFilePath;
-            std::vector<ResourceEntry> ParseResourceFile();
-            uint64_t CalculateStreamDBIndex(uint64_t resourceId, int mipCount);
+
+            // Parses the .resources file and builds the lookup index on first call, returns cached data after that.
+            // Readers are shared between threads, the first caller parses and any others wait for it.
+            const ResourceTable& ParseResourceFile();
+            bool IsParsed() const { return _IsParsed; }
+
+            // Same table, for callers that need to keep it alive after this reader is gone
+            std::shared_ptr<const ResourceTable> GetResourceTable();
+
+            // Parses only the entries that pass filter into a new table. Version and type are checked before any names are resolved.
+            // Doesn't fill or build anything for the other calls, this is for callers that only ever need a few types (e.g. .lwo).
+            // Rows are published through progress as they're parsed. A cancelled parse returns an empty table.
+            std::shared_ptr<const ResourceTable> ParseResourceFile(const ResourceEntryFilter& filter, ResourceLoadProgress* progress = NULL);
+
+            // O(1) lookups, these parse the file first if needed. Return an empty optional if not found.
+            std::optional<ResourceEntry> FindEntry(std::string_view name);
+            std::optional<ResourceEntry> FindEntryByStreamResourceHash(uint64_t streamResourceHash);
+
+            // Single scan over the Version or type column
+            std::vector<uint32_t> GetEntriesByVersion(uint32_t version);
+            std::vector<uint32_t> GetEntriesByType(std::string_view type);
+
+            // Dependency table, and the graph over it. The graph is built on first use.
+            const std::vector<ResourceDependency>& GetDependencyTable();
+            const ResourceDependencyGraph& GetDependencyGraph();
+
+            // resourceId is a byte-swapped StreamResourceHash. The batch version works on any number of ids in one pass.
+            static uint64_t CalculateStreamDBIndex(uint64_t resourceId, int mipCount);
+            static void CalculateStreamDBIndexes(const uint64_t* resourceIds, uint64_t* streamDBIndexes, uint64_t count, int mipCount);
+
+            // .streamdb identifiers for rows of the resource table, straight from the StreamResourceHash column.
+            // Same values ConvertOBJtoLWO uses for the streamdb import folders.
+            std::vector<uint64_t> GetStreamDBIdentifiers(const std::vector<uint32_t>& rows, int mipCount);
+
             uint64_t GetResourceIndex(fs::path targetResourceEntry);
-            std::vector<uint8_t> GetEmbeddedFileHeader(FILE* f, const uint64_t fileOffset, const uint64_t compressedSize, const uint64_t decompressedSize);
+            std::vector<uint8_t> GetEmbeddedFileHeader(FILE* f, const uint64_t fileOffset, const uint64_t compressedSize, const uint64_t decompressedSize, const uint16_t compressionMode);
+
             ResourceFileReader(const fs::path resourceFilePath) { ResourceFilePath = resourceFilePath; }
+            ResourceFileReader(const ResourceFileReader&) = delete;
+            ResourceFileReader& operator=(const ResourceFileReader&) = delete;
+
+        private:
+            std::once_flag _ParseOnce;
+            std::atomic<bool> _IsParsed{ 0 };            // set once the table is complete, it's never changed after that
+            std::shared_ptr<const ResourceTable> _ResourceTable;
+            std::vector<ResourceDependency> _Dependencies;
+            std::vector<uint32_t> _DependencyIndexes;
+            ResourceIndex _Index;
+
+            std::once_flag _DependencyGraphOnce;
+            ResourceDependencyGraph _DependencyGraph;
+
+            void parseAll();
     };
 }
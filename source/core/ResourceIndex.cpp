@@ -0,0 +1,110 @@
+#include "ResourceIndex.h"
+#include "ResourceTable.h"
+
+namespace HAYDEN
+{
+    // 64-bit FNV-1a hash, used for resource name lookups
+    uint64_t hashResourceName(std::string_view name)
+    {
+        uint64_t hash = 0xCBF29CE484222325;
+        for (size_t i = 0; i < name.size(); i++)
+        {
+            hash ^= (uint8_t)name[i];
+            hash *= 0x100000001B3;
+        }
+        return hash;
+    }
+
+    // StreamResourceHash values are already hashes, but their low bits aren't guaranteed to be well mixed
+    static uint64_t mixStreamHash(uint64_t value)
+    {
+        value ^= value >> 33;
+        value *= 0xFF51AFD7ED558CCD;
+        value ^= value >> 33;
+        return value;
+    }
+
+    void ResourceIndex::InsertSlot(std::vector<IndexSlot>& slots, uint64_t slotMask, uint64_t hash, uint32_t entryIndex)
+    {
+        uint64_t slot = hash & slotMask;
+        while (slots[slot].EntryIndex != EMPTY_SLOT)
+            slot = (slot + 1) & slotMask;
+
+        slots[slot].Hash = hash;
+        slots[slot].EntryIndex = entryIndex;
+    }
+
+    void ResourceIndex::Build(const ResourceTable& resourceTable)
+    {
+        Clear();
+        _ResourceTable = &resourceTable;
+
+        // Keep load factor at or below 50%
+        uint64_t capacity = 16;
+        while (capacity < resourceTable.Size() * 2)
+            capacity <<= 1;
+
+        _SlotMask = capacity - 1;
+        _NameSlots.resize(capacity);
+        _StreamHashSlots.resize(capacity);
+
+        const std::vector<uint64_t>& streamResourceHashes = resourceTable.GetStreamResourceHashes();
+        for (uint32_t i = 0; i < resourceTable.Size(); i++)
+        {
+            std::string_view name = resourceTable.GetName(i);
+
+            // First entry wins for duplicate names, same as the old linear scan
+            if (FindByName(name) == -1)
+                InsertSlot(_NameSlots, _SlotMask, hashResourceName(name), i);
+
+            if (FindByStreamResourceHash(streamResourceHashes[i]) == -1)
+                InsertSlot(_StreamHashSlots, _SlotMask, mixStreamHash(streamResourceHashes[i]), i);
+        }
+    }
+
+    void ResourceIndex::Clear()
+    {
+        _ResourceTable = NULL;
+        _NameSlots.clear();
+        _StreamHashSlots.clear();
+        _SlotMask = 0;
+    }
+
+    int64_t ResourceIndex::FindByName(std::string_view name) const
+    {
+        if (_NameSlots.empty())
+            return -1;
+
+        uint64_t hash = hashResourceName(name);
+        uint64_t slot = hash & _SlotMask;
+
+        while (_NameSlots[slot].EntryIndex != EMPTY_SLOT)
+        {
+            const IndexSlot& thisSlot = _NameSlots[slot];
+            if (thisSlot.Hash == hash && _ResourceTable->GetName(thisSlot.EntryIndex) == name)
+                return thisSlot.EntryIndex;
+
+            slot = (slot + 1) & _SlotMask;
+        }
+        return -1;
+    }
+
+    int64_t ResourceIndex::FindByStreamResourceHash(uint64_t streamResourceHash) const
+    {
+        if (_StreamHashSlots.empty())
+            return -1;
+
+        uint64_t hash = mixStreamHash(streamResourceHash);
+        uint64_t slot = hash & _SlotMask;
+
+        while (_StreamHashSlots[slot].EntryIndex != EMPTY_SLOT)
+        {
+            const IndexSlot& thisSlot = _StreamHashSlots[slot];
+            if (thisSlot.Hash == hash && _ResourceTable->GetStreamResourceHashes()[thisSlot.EntryIndex] == streamResourceHash)
+                return thisSlot.EntryIndex;
+
+            slot = (slot + 1) & _SlotMask;
+        }
+        return -1;
+    }
+}
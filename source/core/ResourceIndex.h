@@ -0,0 +1,46 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace HAYDEN
+{
+    class ResourceTable;
+
+    // 64-bit FNV-1a hash, used for resource name lookups
+    uint64_t hashResourceName(std::string_view name);
+
+    // Lookup index over the entries of a single .resources file.
+    // Built once after parsing, then every lookup is O(1) instead of a scan over all entries.
+    class ResourceIndex
+    {
+        public:
+
+            // Returns -1 if not found. If a name appears more than once, the first entry wins.
+            int64_t FindByName(std::string_view name) const;
+            int64_t FindByStreamResourceHash(uint64_t streamResourceHash) const;
+
+            // Table must stay alive and unmodified for as long as the index is used
+            void Build(const ResourceTable& resourceTable);
+            void Clear();
+
+        private:
+
+            // Open addressing with linear probing. Capacity is a power of two, EntryIndex == EMPTY_SLOT marks a free slot.
+            struct IndexSlot
+            {
+                uint64_t Hash = 0;
+                uint32_t EntryIndex = EMPTY_SLOT;
+            };
+
+            static constexpr uint32_t EMPTY_SLOT = 0xFFFFFFFF;
+
+            const ResourceTable* _ResourceTable = NULL;
+            std::vector<IndexSlot> _NameSlots;
+            std::vector<IndexSlot> _StreamHashSlots;
+            uint64_t _SlotMask = 0;
+
+            static void InsertSlot(std::vector<IndexSlot>& slots, uint64_t slotMask, uint64_t hash, uint32_t entryIndex);
+    };
+}
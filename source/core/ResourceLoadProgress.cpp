@@ -0,0 +1,26 @@
+#include "ResourceLoadProgress.h"
+
+namespace HAYDEN
+{
+    // Called by the parser after every chunk. Publishes the rows added since the last call. Returns false if the load should stop.
+    bool ResourceLoadProgress::EndChunk(const fs::path& archivePath, const ResourceTable& resourceTable, uint64_t done, uint64_t total)
+    {
+        // Table was cleared and started over, e.g. after a stale sidecar
+        if (resourceTable.Size() < _PublishedRows)
+            _PublishedRows = 0;
+
+        if (OnBatch && resourceTable.Size() > _PublishedRows)
+        {
+            std::shared_ptr<ResourceTable> batch = std::make_shared<ResourceTable>();
+            batch->Reserve(resourceTable.Size() - _PublishedRows, 0);
+
+            for (uint64_t i = _PublishedRows; i < resourceTable.Size(); i++)
+                batch->AddEntry(resourceTable.GetEntry((uint32_t)i));
+
+            _PublishedRows = resourceTable.Size();
+            OnBatch(archivePath, batch, done, total);
+        }
+
+        return !IsCancelled();
+    }
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <functional>
+#include <filesystem>
+
+#include "ResourceTable.h"
+
+namespace fs = std::filesystem;
+
+namespace HAYDEN
+{
+    // Set from any thread to ask a running load to stop. Loads check it between chunks and return early, nothing is killed mid-way.
+    class CancellationToken
+    {
+        public:
+            void Cancel() { _IsCancelled = 1; }
+            void Reset() { _IsCancelled = 0; }
+            bool IsCancelled() const { return _IsCancelled; }
+
+        private:
+            std::atomic<bool> _IsCancelled{ 0 };
+    };
+
+    // Called by a load whenever it has new rows. The batch only holds the new rows and owns its strings, so it can be passed to another thread.
+    // Done and total are entries for a single archive, archives when loading all of them.
+    using ResourceBatchCallback = std::function<void(const fs::path& archivePath, std::shared_ptr<const ResourceTable> batch, uint64_t done, uint64_t total)>;
+
+    // Progress reporting and cancellation for long loads. Every member is optional.
+    struct ResourceLoadProgress
+    {
+        CancellationToken Cancellation;
+        ResourceBatchCallback OnBatch;
+        uint32_t ChunkSize = 4096;              // entries parsed between publishing batches and checking for cancellation
+
+        bool IsCancelled() const { return Cancellation.IsCancelled(); }
+
+        // Called by the parser after every chunk. Publishes the rows added since the last call. Returns false if the load should stop.
+        bool EndChunk(const fs::path& archivePath, const ResourceTable& resourceTable, uint64_t done, uint64_t total);
+
+        // Called before each load, so the same progress can be reused
+        void Begin() { Cancellation.Reset(); _PublishedRows = 0; }
+
+        private:
+            uint64_t _PublishedRows = 0;
+    };
+}
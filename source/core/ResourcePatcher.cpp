@@ -0,0 +1,175 @@
+#include "ResourcePatcher.h"
+
+#include "types/ResourceFile.h"
+
+#include "Checksum.h"
+#include "Oodle.h"
+#include "ResourceCodec.h"
+#include "ResourceFileReader.h"
+#include "Utilities.h"
+
+namespace HAYDEN
+{
+    // Copies resourcePath to resourcePath.backup, unless that already exists. False if the copy couldn't be made.
+    bool backupResourceFile(const fs::path& resourcePath)
+    {
+        fs::path backupPath = resourcePath;
+        backupPath += ".backup";
+
+        std::error_code ec;
+        if (fs::exists(backupPath, ec))
+            return true;
+
+        // Copied under a temporary name first, so a half written copy is never mistaken for the original
+        fs::path tmpBackupPath = backupPath;
+        tmpBackupPath += ".tmp";
+
+        fs::copy_file(resourcePath, tmpBackupPath, fs::copy_options::overwrite_existing, ec);
+        if (!ec)
+            fs::rename(tmpBackupPath, backupPath, ec);
+
+        if (ec)
+        {
+            fprintf(stderr, "ERROR : ResourcePatcher : Failed to back up %s\n", resourcePath.string().c_str());
+            fs::remove(tmpBackupPath, ec);
+            return false;
+        }
+
+        return true;
+    }
+
+    // Replaces every patched entry in resourcePath. Data is recompressed if the original entry was compressed.
+    // Returns the number of entries patched, entries that can't be found are skipped.
+    size_t patchResourceEntries(const fs::path& resourcePath, const std::vector<ResourcePatch>& patches)
+    {
+        std::vector<uint64_t> entryIndexes;
+        std::vector<const ResourcePatch*> foundPatches;
+        {
+            // Reader is closed again before the archive is opened for writing
+            ResourceFileReader resourceReader(resourcePath);
+            for (const ResourcePatch& patch : patches)
+            {
+                std::optional<ResourceEntry> targetEntry = resourceReader.FindEntry(patch.EntryName);
+                if (!targetEntry)
+                {
+                    fprintf(stderr, "ERROR : ResourcePatcher : Failed to find %s in %s\n", patch.EntryName.c_str(), resourcePath.string().c_str());
+                    continue;
+                }
+
+                entryIndexes.push_back(targetEntry->Index);
+                foundPatches.push_back(&patch);
+            }
+        }
+
+        if (foundPatches.empty())
+            return 0;
+
+        // The backup is the original archive, patching it would leave nothing to restore from
+        if (resourcePath.extension() == ".backup")
+        {
+            fprintf(stderr, "ERROR : ResourcePatcher : %s is a backup, patch the .resources file instead.\n", resourcePath.string().c_str());
+            return 0;
+        }
+
+        if (!backupResourceFile(resourcePath))
+            return 0;
+
+        FILE* f = fopen(resourcePath.string().c_str(), "r+b");
+        if (f == NULL)
+        {
+            fprintf(stderr, "ERROR : ResourcePatcher : Failed to open %s for writing.\n", resourcePath.string().c_str());
+            return 0;
+        }
+
+        std::error_code ec;
+        uint64_t appendOffset = fs::file_size(resourcePath, ec);
+        if (ec)
+        {
+            fprintf(stderr, "ERROR : ResourcePatcher : Failed to read the size of %s\n", resourcePath.string().c_str());
+            fclose(f);
+            return 0;
+        }
+
+        // Append all of the new data first, each entry read straight from the archive and updated in memory
+        std::vector<ResourceFileEntry> fileEntries(foundPatches.size());
+        for (size_t i = 0; i < foundPatches.size(); i++)
+        {
+            const std::vector<uint8_t>& data = foundPatches[i]->Data;
+            ResourceFileEntry& fileEntry = fileEntries[i];
+
+            uint64_t addrEntry = sizeof(ResourceFileHeader) + (entryIndexes[i] * sizeof(ResourceFileEntry));
+            if (readFileAt(f, &fileEntry, sizeof(ResourceFileEntry), addrEntry) != sizeof(ResourceFileEntry))
+            {
+                fprintf(stderr, "ERROR : ResourcePatcher : Failed to read entry from %s\n", resourcePath.string().c_str());
+                fclose(f);
+                return 0;
+            }
+
+            // Keep the entry compressed if it was before, unless compression doesn't help.
+            // With the stand-in codec in use it's always stored, Oodle output couldn't be read back here.
+            std::vector<uint8_t> compressedData;
+            if (fileEntry.DataSize != fileEntry.DataSizeUncompressed && !isStandInResourceCodecInUse())
+                compressedData = oodleCompress(data.data(), data.size());
+
+            bool isCompressed = !compressedData.empty() && compressedData.size() < data.size();
+            const std::vector<uint8_t>& patchData = isCompressed ? compressedData : data;
+
+            if (writeFileAt(f, patchData.data(), patchData.size(), appendOffset) != patchData.size())
+            {
+                fprintf(stderr, "ERROR : ResourcePatcher : Failed to append data to %s\n", resourcePath.string().c_str());
+                fclose(f);
+                return 0;
+            }
+
+            fileEntry.DataOffset = appendOffset;
+            fileEntry.DataSize = patchData.size();
+            fileEntry.DataSizeUncompressed = data.size();
+            fileEntry.DataCheckSum = murmurHash64A(data.data(), data.size());
+
+            // The new data is always Oodle, whatever the entry was compressed with before (zlib included)
+            fileEntry.CompressionMode = isCompressed ? (uint16_t)ResourceCompressionMode::Kraken : (uint16_t)ResourceCompressionMode::None;
+
+            appendOffset += patchData.size();
+        }
+
+        // Sync the appended data before anything points at it
+        if (!syncFile(f))
+        {
+            fprintf(stderr, "ERROR : ResourcePatcher : Failed to append data to %s\n", resourcePath.string().c_str());
+            fclose(f);
+            return 0;
+        }
+
+        // Point the entries at the new data
+        size_t numPatched = 0;
+        for (size_t i = 0; i < fileEntries.size(); i++)
+        {
+            uint64_t addrEntry = sizeof(ResourceFileHeader) + (entryIndexes[i] * sizeof(ResourceFileEntry));
+            if (writeFileAt(f, &fileEntries[i], sizeof(ResourceFileEntry), addrEntry) != sizeof(ResourceFileEntry))
+            {
+                fprintf(stderr, "ERROR : ResourcePatcher : Failed to update entry in %s\n", resourcePath.string().c_str());
+                continue;
+            }
+
+            numPatched++;
+        }
+
+        if (!syncFile(f))
+        {
+            fprintf(stderr, "ERROR : ResourcePatcher : Failed to update entries in %s\n", resourcePath.string().c_str());
+            numPatched = 0;
+        }
+
+        fclose(f);
+        return numPatched;
+    }
+
+    // Replaces the embedded file entryName in resourcePath with data
+    bool patchResourceEntry(const fs::path& resourcePath, std::string_view entryName, const std::vector<uint8_t>& data)
+    {
+        std::vector<ResourcePatch> patches(1);
+        patches[0].EntryName = std::string(entryName);
+        patches[0].Data = data;
+        return patchResourceEntries(resourcePath, patches) == 1;
+    }
+}
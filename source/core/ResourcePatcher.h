@@ -0,0 +1,42 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+namespace HAYDEN
+{
+    /**
+    *   Notes on patching .resources files in place:
+    *
+    *   Instead of rebuilding the whole archive, the new file data is appended to the end of the .resources file,
+    *   then only the target ResourceFileEntry is rewritten so its DataOffset points at the appended data.
+    *   The old data is left where it is, unreferenced.
+    *
+    *   The append is synced to disk before the entry is rewritten, so a crash never leaves the entry pointing at missing data.
+    *   Before the first write to an archive, it's copied to <archive>.backup, so the original can always be restored
+    *   (and diffed against). An existing .backup is never touched, it's the original from before any patching.
+    *   Every patch changes the archive's size, so the TOC sidecar is stale afterwards. Patch all entries of one archive
+    *   in a single patchResourceEntries call, so its TOC is only parsed once.
+    */
+
+    // New data for one embedded file
+    struct ResourcePatch
+    {
+        std::string EntryName;
+        std::vector<uint8_t> Data;
+    };
+
+    // Copies resourcePath to resourcePath.backup, unless that already exists. False if the copy couldn't be made.
+    bool backupResourceFile(const fs::path& resourcePath);
+
+    // Replaces every patched entry in resourcePath. Data is recompressed if the original entry was compressed.
+    // Returns the number of entries patched, entries that can't be found are skipped.
+    size_t patchResourceEntries(const fs::path& resourcePath, const std::vector<ResourcePatch>& patches);
+
+    // Replaces the embedded file entryName in resourcePath with data
+    bool patchResourceEntry(const fs::path& resourcePath, std::string_view entryName, const std::vector<uint8_t>& data);
+}
@@ -0,0 +1,175 @@
+#include "ResourcePipeline.h"
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <thread>
+
+#include "ResourceCodec.h"
+#include "Utilities.h"
+#include "WorkQueue.h"
+
+namespace HAYDEN
+{
+    bool ResourceFilter::Matches(const ResourceEntry& entry) const
+    {
+        if (Version != -1 && entry.Version != Version)
+            return 0;
+
+        if (!Type.empty() && entry.Type != Type)
+            return 0;
+
+        if (!NameContains.empty() && entry.Name.find(NameContains) == std::string_view::npos)
+            return 0;
+
+        return 1;
+    }
+
+    // Entries from reader matching this filter, sorted by DataOffset so the archive is read front to back
+    std::vector<ResourceEntry> ResourceFilter::SelectEntries(ResourceFileReader& reader) const
+    {
+        const ResourceTable& resourceTable = reader.ParseResourceFile();
+        const std::vector<uint32_t>& versions = resourceTable.GetVersions();
+        const std::vector<uint16_t>& typeIds = resourceTable.GetTypeIds();
+
+        // Version and type are checked one column at a time, names are only looked at for entries that pass both
+        int32_t typeId = Type.empty() ? -1 : resourceTable.FindTypeId(Type);
+        if (!Type.empty() && typeId == -1)
+            return std::vector<ResourceEntry>();
+
+        std::vector<ResourceEntry> selectedEntries;
+        for (uint32_t i = 0; i < resourceTable.Size(); i++)
+        {
+            if (Version != -1 && versions[i] != Version)
+                continue;
+
+            if (typeId != -1 && typeIds[i] != typeId)
+                continue;
+
+            std::string_view name = resourceTable.GetName(i);
+            if (name.empty() || (!NameContains.empty() && name.find(NameContains) == std::string_view::npos))
+                continue;
+
+            selectedEntries.push_back(resourceTable.GetEntry(i));
+        }
+
+        std::sort(selectedEntries.begin(), selectedEntries.end(), [](const ResourceEntry& a, const ResourceEntry& b) {
+            return a.DataOffset < b.DataOffset;
+        });
+
+        return selectedEntries;
+    }
+
+    // Runs every entry through the pipeline. numThreads = 0 uses one worker per core. Returns compressed bytes read.
+    uint64_t ResourcePipeline::Run(const fs::path& resourcePath, const std::vector<ResourceEntry>& entries, uint32_t numThreads)
+    {
+        if (entries.empty())
+            return 0;
+
+        if (numThreads == 0)
+            numThreads = std::max(1u, std::thread::hardware_concurrency());
+
+        FILE* archive = fopen(resourcePath.string().c_str(), "rb");
+
+        // A few jobs per worker keeps every stage busy without holding too much data in memory
+        const uint32_t numSlots = numThreads * 4;
+        std::vector<ResourceJob> jobs(numSlots);
+
+        BoundedQueue<uint32_t> freeSlots(numSlots);
+        BoundedQueue<uint32_t> decompressQueue(numSlots);
+        BoundedQueue<uint32_t> finishQueue(numSlots);
+
+        for (uint32_t i = 0; i < numSlots; i++)
+            freeSlots.Push(i);
+
+        std::atomic<uint64_t> bytesRead(0);
+
+        // (a) Read compressed data in the given order
+        std::thread readerThread([&]()
+        {
+            uint32_t slot = 0;
+            for (uint64_t i = 0; i < entries.size() && freeSlots.Pop(slot); i++)
+            {
+                ResourceJob& job = jobs[slot];
+                job.Sequence = i;
+                job.Entry = entries[i];
+                job.Failed = archive == NULL;
+                job.Checksum = 0;
+
+                if (!job.Failed)
+                {
+                    job.CompressedData.resize(job.Entry.DataSize);
+                    job.Failed = readFileAt(archive, job.CompressedData.data(), job.Entry.DataSize, job.Entry.DataOffset) != job.Entry.DataSize;
+                    bytesRead += job.Entry.DataSize;
+                }
+
+                decompressQueue.Push(slot);
+            }
+            decompressQueue.Close();
+        });
+
+        // (b) Decompress and process on all workers. The last worker to finish closes the finish queue.
+        std::atomic<uint32_t> activeWorkers(numThreads);
+        auto decompressWorker = [&]()
+        {
+            uint32_t slot = 0;
+            while (decompressQueue.Pop(slot))
+            {
+                ResourceJob& job = jobs[slot];
+                job.Output = job.CompressedData.data();
+
+                if (!job.Failed && job.Entry.DataSize != job.Entry.DataSizeUncompressed)
+                {
+                    job.DecompressedData.resize(job.Entry.DataSizeUncompressed + SAFE_SPACE);
+                    uint64_t decompressedSize = decompressResource(job.Entry.CompressionMode, job.CompressedData.data(), job.Entry.DataSize, job.DecompressedData.data(), job.Entry.DataSizeUncompressed);
+
+                    job.Failed = decompressedSize != job.Entry.DataSizeUncompressed;
+                    job.Output = job.DecompressedData.data();
+                }
+
+                if (!job.Failed && ProcessJob)
+                    ProcessJob(job);
+
+                finishQueue.Push(slot);
+            }
+
+            if (--activeWorkers == 0)
+                finishQueue.Close();
+        };
+
+        std::vector<std::thread> decompressThreads;
+        for (uint32_t i = 0; i < numThreads; i++)
+            decompressThreads.emplace_back(decompressWorker);
+
+        // (c) Finish on this thread, in the order entries were read. Jobs that arrive early wait in pendingJobs.
+        std::map<uint64_t, uint32_t> pendingJobs;
+        uint64_t nextSequence = 0;
+        uint32_t slot = 0;
+
+        while (finishQueue.Pop(slot))
+        {
+            pendingJobs[jobs[slot].Sequence] = slot;
+
+            for (auto next = pendingJobs.find(nextSequence); next != pendingJobs.end(); next = pendingJobs.find(++nextSequence))
+            {
+                if (FinishJob)
+                    FinishJob(jobs[next->second]);
+
+                freeSlots.Push(next->second);
+                pendingJobs.erase(next);
+            }
+        }
+
+        for (auto& thread : decompressThreads)
+            thread.join();
+
+        readerThread.join();
+
+        if (archive != NULL)
+            fclose(archive);
+        else
+            fprintf(stderr, "ERROR : ResourcePipeline : Failed to open %s for reading.\n", resourcePath.string().c_str());
+
+        return bytesRead;
+    }
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <functional>
+
+#include "ResourceFileReader.h"
+
+namespace HAYDEN
+{
+    // Which entries to process. Empty fields match everything.
+    struct ResourceFilter
+    {
+        std::string Type;                       // exact match on ResourceEntry::Type, e.g. "model"
+        std::string NameContains;               // substring of ResourceEntry::Name
+        int64_t Version = -1;                   // ResourceEntry::Version, -1 for any
+
+        bool Matches(const ResourceEntry& entry) const;
+
+        // Entries from reader matching this filter, sorted by DataOffset so the archive is read front to back
+        std::vector<ResourceEntry> SelectEntries(ResourceFileReader& reader) const;
+    };
+
+    // One entry moving through the pipeline. Jobs are recycled, buffers only ever grow.
+    struct ResourceJob
+    {
+        uint64_t Sequence = 0;
+        ResourceEntry Entry;
+        std::vector<uint8_t> CompressedData;
+        std::vector<uint8_t> DecompressedData;
+        const uint8_t* Output = NULL;           // decompressed data, DataSizeUncompressed bytes
+        bool Failed = 0;                        // read or decompression failed
+        uint64_t Checksum = 0;                  // free for ProcessJob to fill in
+    };
+
+    // Reads and decompresses entries from a single .resources file as overlapping stages:
+    //   (a) one reader, reading entries in the given order with positioned reads
+    //   (b) a pool of workers decompressing with Oodle, then running ProcessJob
+    //   (c) FinishJob on the calling thread, in the same order entries were read
+    //
+    // Stages are connected by bounded queues. Buffers live in a fixed set of jobs and are reused, so memory stays bounded.
+    class ResourcePipeline
+    {
+        public:
+
+            // Runs on the worker threads after decompression. Optional.
+            std::function<void(ResourceJob&)> ProcessJob;
+
+            // Runs on the calling thread, in order. Optional.
+            std::function<void(ResourceJob&)> FinishJob;
+
+            // Runs every entry through the pipeline. numThreads = 0 uses one worker per core. Returns compressed bytes read.
+            uint64_t Run(const fs::path& resourcePath, const std::vector<ResourceEntry>& entries, uint32_t numThreads = 0);
+    };
+}
@@ -0,0 +1,283 @@
+#include "ResourceSession.h"
+
+namespace HAYDEN
+{
+    ResourceSession& ResourceSession::Get()
+    {
+        static ResourceSession session;
+        return session;
+    }
+
+    std::string ResourceSession::getArchiveKey(const fs::path& resourcePath)
+    {
+        std::error_code ec;
+        return fs::absolute(resourcePath, ec).lexically_normal().generic_string();
+    }
+
+    // Zero size and time if the file can't be read, which still works as a stamp - it changes once the file is back
+    ResourceSession::ArchiveStamp ResourceSession::getArchiveStamp(const fs::path& resourcePath)
+    {
+        ArchiveStamp stamp;
+        std::error_code ec;
+
+        stamp.Size = fs::file_size(resourcePath, ec);
+        if (ec)
+            return ArchiveStamp();
+
+        stamp.ModifiedTime = fs::last_write_time(resourcePath, ec).time_since_epoch().count();
+        if (ec)
+            return ArchiveStamp();
+
+        return stamp;
+    }
+
+    ResourceSession::ArchiveId ResourceSession::getArchiveId(const fs::path& resourcePath)
+    {
+        ArchiveId archiveId;
+        archiveId.Path = resourcePath;
+        archiveId.Key = getArchiveKey(resourcePath);
+        archiveId.Stamp = getArchiveStamp(resourcePath);
+        return archiveId;
+    }
+
+    // Finds or opens the archive and moves it to the front. An archive that changed on disk starts over with a new reader.
+    // A new reader isn't parsed here, that happens on first use, outside the lock.
+    ResourceSession::SessionArchive& ResourceSession::getArchive(const ArchiveId& archiveId)
+    {
+        for (auto archive = _Archives.begin(); archive != _Archives.end(); archive++)
+        {
+            if (archive->Key != archiveId.Key)
+                continue;
+
+            if (archive->Stamp == archiveId.Stamp)
+            {
+                _Archives.splice(_Archives.begin(), _Archives, archive);
+                return _Archives.front();
+            }
+
+            removeArchive(archiveId.Key);
+            break;
+        }
+
+        SessionArchive archive;
+        archive.Key = archiveId.Key;
+        archive.Stamp = archiveId.Stamp;
+        archive.Reader = std::make_shared<ResourceFileReader>(archiveId.Path);
+        _Archives.push_front(std::move(archive));
+
+        evict();
+        return _Archives.front();
+    }
+
+    // Row of the partial table, only while the full table isn't parsed yet. Empty if the full table is needed.
+    std::optional<ResourceEntry> ResourceSession::findPartialEntry(SessionArchive& archive, std::string_view name)
+    {
+        // The full table is always right once it's there, the partial table only saves parsing it
+        if (archive.Reader->IsParsed() || !archive.PartialTable)
+            return std::optional<ResourceEntry>();
+
+        if (archive.PartialNames.empty())
+        {
+            archive.PartialNames.reserve(archive.PartialTable->Size());
+            for (uint32_t i = 0; i < archive.PartialTable->Size(); i++)
+                archive.PartialNames.emplace(archive.PartialTable->GetName(i), i);
+        }
+
+        auto row = archive.PartialNames.find(name);
+        if (row != archive.PartialNames.end())
+            return archive.PartialTable->GetEntry(row->second);
+
+        return std::optional<ResourceEntry>();
+    }
+
+    // True if this archive is still in the session, unchanged
+    bool ResourceSession::hasArchive(const ArchiveId& archiveId) const
+    {
+        for (const SessionArchive& archive : _Archives)
+        {
+            if (archive.Key == archiveId.Key)
+                return archive.Stamp == archiveId.Stamp;
+        }
+
+        return false;
+    }
+
+    // Removes an archive and all of its entries
+    void ResourceSession::removeArchive(const std::string& archiveKey)
+    {
+        _Archives.remove_if([&archiveKey](const SessionArchive& archive) { return archive.Key == archiveKey; });
+
+        for (auto entry = _Entries.begin(); entry != _Entries.end();)
+        {
+            if (entry->ArchiveKey != archiveKey)
+            {
+                entry++;
+                continue;
+            }
+
+            _CachedBytes -= entry->Data->size();
+            _EntriesByKey.erase(entry->Key);
+            entry = _Entries.erase(entry);
+        }
+    }
+
+    // Drops least recently used archives and entries until both limits are met. The most recent of each is always kept.
+    void ResourceSession::evict()
+    {
+        while (_Archives.size() > 1 && _Archives.size() > _MaxArchives)
+            removeArchive(_Archives.back().Key);
+
+        while (_Entries.size() > 1 && _CachedBytes > _MaxCachedBytes)
+        {
+            _CachedBytes -= _Entries.back().Data->size();
+            _EntriesByKey.erase(_Entries.back().Key);
+            _Entries.pop_back();
+        }
+    }
+
+    std::shared_ptr<ResourceFileReader> ResourceSession::GetReader(const fs::path& resourcePath)
+    {
+        ArchiveId archiveId = getArchiveId(resourcePath);
+        std::lock_guard<std::mutex> lock(_Mutex);
+        return getArchive(archiveId).Reader;
+    }
+
+    void ResourceSession::AddReader(std::shared_ptr<ResourceFileReader> reader)
+    {
+        ArchiveId archiveId = getArchiveId(reader->ResourceFilePath);
+        std::lock_guard<std::mutex> lock(_Mutex);
+        SessionArchive& archive = getArchive(archiveId);
+        archive.Reader = reader;
+    }
+
+    void ResourceSession::AddPartialTable(const fs::path& resourcePath, std::shared_ptr<const ResourceTable> resourceTable)
+    {
+        ArchiveId archiveId = getArchiveId(resourcePath);
+        std::lock_guard<std::mutex> lock(_Mutex);
+        SessionArchive& archive = getArchive(archiveId);
+        archive.PartialTable = resourceTable;
+        archive.PartialNames.clear();
+    }
+
+    std::optional<ResourceEntry> ResourceSession::FindEntry(const fs::path& resourcePath, std::string_view name)
+    {
+        ArchiveId archiveId = getArchiveId(resourcePath);
+        std::shared_ptr<ResourceFileReader> reader;
+        {
+            std::lock_guard<std::mutex> lock(_Mutex);
+            SessionArchive& archive = getArchive(archiveId);
+
+            std::optional<ResourceEntry> entry = findPartialEntry(archive, name);
+            if (entry)
+                return entry;
+
+            reader = archive.Reader;
+        }
+
+        // A full parse can take a while, it runs without the session lock
+        return reader->FindEntry(name);
+    }
+
+    std::shared_ptr<const std::vector<uint8_t>> ResourceSession::GetEmbeddedFile(const fs::path& resourcePath, std::string_view name)
+    {
+        ArchiveId archiveId = getArchiveId(resourcePath);
+        std::string entryKey = archiveId.Key + "\n" + std::to_string(archiveId.Stamp.ModifiedTime) + "\n" + std::string(name);
+
+        std::shared_ptr<ResourceFileReader> reader;
+        std::optional<ResourceEntry> entry;
+        {
+            std::lock_guard<std::mutex> lock(_Mutex);
+            SessionArchive& archive = getArchive(archiveId);
+
+            auto cachedEntry = _EntriesByKey.find(entryKey);
+            if (cachedEntry != _EntriesByKey.end())
+            {
+                _Entries.splice(_Entries.begin(), _Entries, cachedEntry->second);
+                return _Entries.front().Data;
+            }
+
+            entry = findPartialEntry(archive, name);
+            reader = archive.Reader;
+        }
+
+        // Parsing, reading and decompressing all run without the session lock. The reader is kept alive until we're done with it.
+        if (!entry)
+            entry = reader->FindEntry(name);
+
+        if (!entry)
+            return NULL;
+
+        FILE* f = fopen(resourcePath.string().c_str(), "rb");
+        if (f == NULL)
+            return NULL;
+
+        std::vector<uint8_t> data = reader->GetEmbeddedFileHeader(f, entry->DataOffset, entry->DataSize, entry->DataSizeUncompressed, entry->CompressionMode);
+        fclose(f);
+
+        if (data.size() != entry->DataSizeUncompressed)
+            return NULL;
+
+        std::shared_ptr<const std::vector<uint8_t>> entryData = std::make_shared<const std::vector<uint8_t>>(std::move(data));
+
+        std::lock_guard<std::mutex> lock(_Mutex);
+
+        // Another thread may have read the same entry in the meantime, keep the one that's cached already
+        auto cachedEntry = _EntriesByKey.find(entryKey);
+        if (cachedEntry != _EntriesByKey.end())
+        {
+            _Entries.splice(_Entries.begin(), _Entries, cachedEntry->second);
+            return _Entries.front().Data;
+        }
+
+        // Nothing is cached for an archive that was invalidated or changed while we were reading it
+        if (!hasArchive(archiveId))
+            return entryData;
+
+        SessionEntry sessionEntry;
+        sessionEntry.Key = entryKey;
+        sessionEntry.ArchiveKey = archiveId.Key;
+        sessionEntry.Data = entryData;
+
+        _CachedBytes += sessionEntry.Data->size();
+        _Entries.push_front(std::move(sessionEntry));
+        _EntriesByKey[entryKey] = _Entries.begin();
+
+        evict();
+        return entryData;
+    }
+
+    void ResourceSession::Invalidate(const fs::path& resourcePath)
+    {
+        std::lock_guard<std::mutex> lock(_Mutex);
+        removeArchive(getArchiveKey(resourcePath));
+    }
+
+    void ResourceSession::Clear()
+    {
+        std::lock_guard<std::mutex> lock(_Mutex);
+        _Archives.clear();
+        _Entries.clear();
+        _EntriesByKey.clear();
+        _CachedBytes = 0;
+    }
+
+    void ResourceSession::SetMaxArchives(uint32_t maxArchives)
+    {
+        std::lock_guard<std::mutex> lock(_Mutex);
+        _MaxArchives = maxArchives;
+        evict();
+    }
+
+    void ResourceSession::SetMaxCachedBytes(uint64_t maxCachedBytes)
+    {
+        std::lock_guard<std::mutex> lock(_Mutex);
+        _MaxCachedBytes = maxCachedBytes;
+        evict();
+    }
+
+    uint64_t ResourceSession::GetCachedBytes()
+    {
+        std::lock_guard<std::mutex> lock(_Mutex);
+        return _CachedBytes;
+    }
+}
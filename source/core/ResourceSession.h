@@ -0,0 +1,116 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <filesystem>
+
+#include "ResourceFileReader.h"
+
+namespace fs = std::filesystem;
+
+namespace HAYDEN
+{
+    // Process-wide cache of opened archives and decompressed entries, shared by every ModelConverter.
+    //
+    // Archives are keyed by absolute path and checked against the file's size and modified time on every call,
+    // so an archive that changed on disk is simply parsed again. Decompressed entries (e.g. .lwo headers) are kept
+    // in an LRU bounded by total bytes, keyed by (archive path, modified time, entry name).
+    // The session lock only covers the caches themselves. Parsing, reading and decompressing run outside it,
+    // so one slow archive doesn't hold up every other thread. Readers parse themselves once, however many threads ask.
+    class ResourceSession
+    {
+        public:
+
+            static ResourceSession& Get();
+
+            // Reader for this archive, shared with everyone else asking for the same file. Not parsed yet if it's new.
+            std::shared_ptr<ResourceFileReader> GetReader(const fs::path& resourcePath);
+
+            // Adds a reader that's already parsed (e.g. from a GlobalResourceIndex), replacing any reader for the same file
+            void AddReader(std::shared_ptr<ResourceFileReader> reader);
+
+            // Adds a filtered table of this archive. Lookups for names in it won't need a full parse of the archive.
+            void AddPartialTable(const fs::path& resourcePath, std::shared_ptr<const ResourceTable> resourceTable);
+
+            // Finds an entry in the partial table if there is one, or in the full table otherwise (parsed on first use).
+            // Name and Type point into the session's tables, copy them if they're needed after the archive is invalidated.
+            std::optional<ResourceEntry> FindEntry(const fs::path& resourcePath, std::string_view name);
+
+            // Decompressed data of an entry, from the cache if it's been read before. NULL if not found or unreadable.
+            std::shared_ptr<const std::vector<uint8_t>> GetEmbeddedFile(const fs::path& resourcePath, std::string_view name);
+
+            // Drops everything cached for this archive, for callers that have just written to it
+            void Invalidate(const fs::path& resourcePath);
+            void Clear();
+
+            // Limits are checked whenever something is added. Archives are counted, entries are bounded by total bytes.
+            void SetMaxArchives(uint32_t maxArchives);
+            void SetMaxCachedBytes(uint64_t maxCachedBytes);
+            uint64_t GetCachedBytes();
+
+            ResourceSession(const ResourceSession&) = delete;
+            ResourceSession& operator=(const ResourceSession&) = delete;
+
+        private:
+            ResourceSession() {}
+
+            struct ArchiveStamp
+            {
+                uint64_t Size = 0;
+                int64_t ModifiedTime = 0;
+
+                bool operator==(const ArchiveStamp& other) const { return Size == other.Size && ModifiedTime == other.ModifiedTime; }
+            };
+
+            // Key and stamp of an archive, read from the filesystem before the lock is taken
+            struct ArchiveId
+            {
+                fs::path Path;
+                std::string Key;                                            // absolute path
+                ArchiveStamp Stamp;
+            };
+
+            struct SessionArchive
+            {
+                std::string Key;                                            // absolute path
+                ArchiveStamp Stamp;
+                std::shared_ptr<ResourceFileReader> Reader;
+                std::shared_ptr<const ResourceTable> PartialTable;
+                std::unordered_map<std::string_view, uint32_t> PartialNames; // built on first lookup, views into PartialTable
+            };
+
+            struct SessionEntry
+            {
+                std::string Key;                                            // archive key, modified time and entry name
+                std::string ArchiveKey;
+                std::shared_ptr<const std::vector<uint8_t>> Data;
+            };
+
+            // Most recently used first
+            std::list<SessionArchive> _Archives;
+            std::list<SessionEntry> _Entries;
+            std::unordered_map<std::string, std::list<SessionEntry>::iterator> _EntriesByKey;
+
+            uint32_t _MaxArchives = 256;
+            uint64_t _MaxCachedBytes = 64 * 1024 * 1024;
+            uint64_t _CachedBytes = 0;
+            std::mutex _Mutex;
+
+            static std::string getArchiveKey(const fs::path& resourcePath);
+            static ArchiveStamp getArchiveStamp(const fs::path& resourcePath);
+            static ArchiveId getArchiveId(const fs::path& resourcePath);
+
+            // These expect the lock to be held already
+            SessionArchive& getArchive(const ArchiveId& archiveId);
+            std::optional<ResourceEntry> findPartialEntry(SessionArchive& archive, std::string_view name);
+            bool hasArchive(const ArchiveId& archiveId) const;
+            void removeArchive(const std::string& archiveKey);
+            void evict();
+    };
+}
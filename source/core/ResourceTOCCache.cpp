@@ -0,0 +1,296 @@
+#include "ResourceTOCCache.h"
+
+#include <unordered_map>
+
+#include "types/ResourceFile.h"
+
+#include "ResourceFileReader.h"
+#include "Utilities.h"
+
+namespace HAYDEN
+{
+    // Path of the sidecar file for a given .resources file
+    fs::path getTOCCachePath(const fs::path& resourcePath)
+    {
+        // Different archives share file names (e.g. every level has a .resources.backup), so include a hash of the full path
+        std::error_code ec;
+        fs::path absolutePath = fs::absolute(resourcePath, ec);
+        std::string pathHash = intToHex(hashResourceName(absolutePath.generic_string()));
+
+        return fs::current_path() / "cache" / "toc" / (resourcePath.filename().string() + "_" + pathHash + ".toc");
+    }
+
+    // Reads the stamp values that the sidecar must match. Returns false if the archive can't be read.
+    static bool getArchiveStamp(const fs::path& resourcePath, TOCCacheHeader& stamp)
+    {
+        std::error_code ec;
+        stamp.ArchiveSize = fs::file_size(resourcePath, ec);
+        if (ec)
+            return false;
+
+        stamp.ArchiveModifiedTime = fs::last_write_time(resourcePath, ec).time_since_epoch().count();
+        if (ec)
+            return false;
+
+        FILE* f = fopen(resourcePath.string().c_str(), "rb");
+        if (f == NULL)
+            return false;
+
+        ResourceFileHeader resourceHeader;
+        uint64_t bytesRead = readFileAt(f, &resourceHeader, sizeof(ResourceFileHeader), 0);
+        fclose(f);
+
+        if (bytesRead != sizeof(ResourceFileHeader))
+            return false;
+
+        stamp.ArchiveMagic = resourceHeader.Magic;
+        stamp.ArchiveVersion = resourceHeader.Version;
+        return true;
+    }
+
+    // Maps the sidecar file and checks it against the archive. Returns false if there is no sidecar or it's stale.
+    static bool openTOCCache(const fs::path& resourcePath, MappedFile& cacheFile, TOCCacheHeader& header)
+    {
+        TOCCacheHeader stamp;
+        if (!getArchiveStamp(resourcePath, stamp))
+            return false;
+
+        if (!cacheFile.Open(getTOCCachePath(resourcePath)))
+            return false;
+
+        if (!cacheFile.Contains(0, sizeof(TOCCacheHeader)))
+            return false;
+
+        std::memcpy(&header, cacheFile.Data(), sizeof(TOCCacheHeader));
+
+        // Sidecar must be from this version of the tool, and the archive must be unchanged since it was written
+        if (header.Magic != TOC_CACHE_MAGIC || header.FormatVersion != TOC_CACHE_VERSION)
+            return false;
+
+        if (header.ArchiveSize != stamp.ArchiveSize || header.ArchiveModifiedTime != stamp.ArchiveModifiedTime)
+            return false;
+
+        if (header.ArchiveMagic != stamp.ArchiveMagic || header.ArchiveVersion != stamp.ArchiveVersion)
+            return false;
+
+        if (header.NumEntries > (cacheFile.Size() - sizeof(TOCCacheHeader)) / sizeof(TOCCacheEntry))
+            return false;
+
+        if (header.NumDependencies > cacheFile.Size() / sizeof(TOCCacheDependency) || !cacheFile.Contains(header.AddrDependencies, header.NumDependencies * sizeof(TOCCacheDependency)))
+            return false;
+
+        if (header.NumDependencyIndexes > cacheFile.Size() / sizeof(uint32_t) || !cacheFile.Contains(header.AddrDependencyIndexes, header.NumDependencyIndexes * sizeof(uint32_t)))
+            return false;
+
+        if (!cacheFile.Contains(header.AddrStrings, header.SizeStrings))
+            return false;
+
+        return true;
+    }
+
+    // Adds the cached entries that pass filter to the table, or all of them if filter is empty
+    static bool loadCacheEntries(const fs::path& resourcePath, const MappedFile& cacheFile, const TOCCacheHeader& header, ResourceTable& resourceTable, const ResourceEntryFilter& filter, ResourceLoadProgress* progress)
+    {
+        ArrayView<TOCCacheEntry> cacheEntries(cacheFile.Data() + sizeof(TOCCacheHeader), header.NumEntries);
+        const char* strings = (const char*)cacheFile.Data() + header.AddrStrings;
+
+        if (!filter)
+            resourceTable.Reserve(header.NumEntries, header.SizeStrings);
+
+        for (uint64_t i = 0; i < header.NumEntries; i++)
+        {
+            TOCCacheEntry cacheEntry = cacheEntries[i];
+            if ((uint64_t)cacheEntry.TypeOffset + cacheEntry.TypeLength > header.SizeStrings || (uint64_t)cacheEntry.NameOffset + cacheEntry.NameLength > header.SizeStrings)
+            {
+                resourceTable.Clear();
+                return false;
+            }
+
+            ResourceEntry entry;
+            entry.Type = std::string_view(strings + cacheEntry.TypeOffset, cacheEntry.TypeLength);
+
+            if (!filter || filter(cacheEntry.Version, entry.Type))
+            {
+                entry.Index = (uint32_t)i;
+                entry.DataOffset = cacheEntry.DataOffset;
+                entry.DataSize = cacheEntry.DataSize;
+                entry.DataSizeUncompressed = cacheEntry.DataSizeUncompressed;
+                entry.DataCheckSum = cacheEntry.DataCheckSum;
+                entry.StreamResourceHash = cacheEntry.StreamResourceHash;
+                entry.DependencyIndexNumber = cacheEntry.DependencyIndexNumber;
+                entry.Version = cacheEntry.Version;
+                entry.CompressionMode = cacheEntry.CompressionMode;
+                entry.NumDependencies = cacheEntry.NumDependencies;
+                entry.Name = std::string_view(strings + cacheEntry.NameOffset, cacheEntry.NameLength);
+                resourceTable.AddEntry(entry);
+            }
+
+            // Publish what we have so far, and stop here if the load was cancelled
+            if (progress != NULL && ((i + 1) % progress->ChunkSize == 0 || i + 1 == header.NumEntries))
+            {
+                if (!progress->EndChunk(resourcePath, resourceTable, i + 1, header.NumEntries))
+                {
+                    resourceTable.Clear();
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    // Fills the resource table and dependency tables from the sidecar file. Returns false if there is no sidecar or it's stale.
+    bool loadTOCCache(const fs::path& resourcePath, ResourceTable& resourceTable, std::vector<ResourceDependency>& dependencies, std::vector<uint32_t>& dependencyIndexes)
+    {
+        MappedFile cacheFile;
+        TOCCacheHeader header;
+        if (!openTOCCache(resourcePath, cacheFile, header))
+            return false;
+
+        if (!loadCacheEntries(resourcePath, cacheFile, header, resourceTable, nullptr, NULL))
+            return false;
+
+        ArrayView<TOCCacheDependency> cacheDependencies(cacheFile.Data() + header.AddrDependencies, header.NumDependencies);
+        const char* strings = (const char*)cacheFile.Data() + header.AddrStrings;
+
+        dependencies.resize(header.NumDependencies);
+        for (uint64_t i = 0; i < header.NumDependencies; i++)
+        {
+            TOCCacheDependency cacheDependency = cacheDependencies[i];
+            if ((uint64_t)cacheDependency.TypeOffset + cacheDependency.TypeLength > header.SizeStrings || (uint64_t)cacheDependency.NameOffset + cacheDependency.NameLength > header.SizeStrings)
+            {
+                resourceTable.Clear();
+                dependencies.clear();
+                return false;
+            }
+
+            ResourceDependency& dependency = dependencies[i];
+            dependency.DependencyType = cacheDependency.DependencyType;
+            dependency.Type.assign(strings + cacheDependency.TypeOffset, cacheDependency.TypeLength);
+            dependency.Name.assign(strings + cacheDependency.NameOffset, cacheDependency.NameLength);
+        }
+
+        dependencyIndexes.resize(header.NumDependencyIndexes);
+        std::memcpy(dependencyIndexes.data(), cacheFile.Data() + header.AddrDependencyIndexes, header.NumDependencyIndexes * sizeof(uint32_t));
+        return true;
+    }
+
+    // Fills the resource table with only the entries that pass filter. Returns false if there is no sidecar, it's stale, or progress was cancelled.
+    bool loadTOCCache(const fs::path& resourcePath, ResourceTable& resourceTable, const ResourceEntryFilter& filter, ResourceLoadProgress* progress)
+    {
+        MappedFile cacheFile;
+        TOCCacheHeader header;
+        if (!openTOCCache(resourcePath, cacheFile, header))
+            return false;
+
+        return loadCacheEntries(resourcePath, cacheFile, header, resourceTable, filter, progress);
+    }
+
+    // Writes the sidecar file for this .resources file
+    bool saveTOCCache(const fs::path& resourcePath, const ResourceTable& resourceTable, const std::vector<ResourceDependency>& dependencies, const std::vector<uint32_t>& dependencyIndexes)
+    {
+        TOCCacheHeader header;
+        if (!getArchiveStamp(resourcePath, header))
+            return false;
+
+        // Build the flat entry and dependency tables, and the string blob
+        std::vector<TOCCacheEntry> cacheEntries(resourceTable.Size());
+        std::vector<TOCCacheDependency> cacheDependencies(dependencies.size());
+        std::unordered_map<std::string, uint32_t> typeOffsets;
+        std::string strings;
+
+        // Type strings are only stored once and shared
+        auto addTypeString = [&typeOffsets, &strings](const std::string& type)
+        {
+            auto typeOffset = typeOffsets.find(type);
+            if (typeOffset == typeOffsets.end())
+            {
+                typeOffset = typeOffsets.emplace(type, (uint32_t)strings.size()).first;
+                strings.append(type);
+            }
+            return typeOffset->second;
+        };
+
+        // Entry types are already interned by the table
+        std::vector<uint32_t> entryTypeOffsets(resourceTable.GetTypes().size());
+        for (size_t i = 0; i < entryTypeOffsets.size(); i++)
+            entryTypeOffsets[i] = addTypeString(resourceTable.GetTypes()[i]);
+
+        for (uint32_t i = 0; i < resourceTable.Size(); i++)
+        {
+            ResourceEntry entry = resourceTable.GetEntry(i);
+            TOCCacheEntry& cacheEntry = cacheEntries[i];
+
+            cacheEntry.DataOffset = entry.DataOffset;
+            cacheEntry.DataSize = entry.DataSize;
+            cacheEntry.DataSizeUncompressed = entry.DataSizeUncompressed;
+            cacheEntry.DataCheckSum = entry.DataCheckSum;
+            cacheEntry.StreamResourceHash = entry.StreamResourceHash;
+            cacheEntry.DependencyIndexNumber = (uint32_t)entry.DependencyIndexNumber;
+            cacheEntry.Version = entry.Version;
+            cacheEntry.CompressionMode = entry.CompressionMode;
+            cacheEntry.NumDependencies = entry.NumDependencies;
+
+            cacheEntry.TypeOffset = entryTypeOffsets[resourceTable.GetTypeIds()[i]];
+            cacheEntry.TypeLength = (uint16_t)entry.Type.size();
+            cacheEntry.NameOffset = (uint32_t)strings.size();
+            cacheEntry.NameLength = (uint32_t)entry.Name.size();
+            strings.append(entry.Name);
+        }
+
+        for (size_t i = 0; i < dependencies.size(); i++)
+        {
+            const ResourceDependency& dependency = dependencies[i];
+            TOCCacheDependency& cacheDependency = cacheDependencies[i];
+
+            cacheDependency.DependencyType = dependency.DependencyType;
+            cacheDependency.TypeOffset = addTypeString(dependency.Type);
+            cacheDependency.TypeLength = (uint16_t)dependency.Type.size();
+            cacheDependency.NameOffset = (uint32_t)strings.size();
+            cacheDependency.NameLength = (uint32_t)dependency.Name.size();
+            strings.append(dependency.Name);
+        }
+
+        header.NumEntries = cacheEntries.size();
+        header.NumDependencies = cacheDependencies.size();
+        header.AddrDependencies = sizeof(TOCCacheHeader) + (cacheEntries.size() * sizeof(TOCCacheEntry));
+        header.NumDependencyIndexes = dependencyIndexes.size();
+        header.AddrDependencyIndexes = header.AddrDependencies + (cacheDependencies.size() * sizeof(TOCCacheDependency));
+        header.AddrStrings = header.AddrDependencyIndexes + (dependencyIndexes.size() * sizeof(uint32_t));
+        header.SizeStrings = strings.size();
+
+        // Write to a temporary file first, so an interrupted write never leaves a half-written sidecar behind
+        fs::path cachePath = getTOCCachePath(resourcePath);
+        fs::path tmpCachePath = cachePath;
+        tmpCachePath.replace_extension(".toc.tmp");
+
+        if (!fs::exists(cachePath.parent_path()))
+            if (!mkpath(cachePath.parent_path()))
+                return false;
+
+        FILE* f = openLongFilePath(tmpCachePath); //wb
+        if (f == NULL)
+            return false;
+
+        fwrite(&header, sizeof(TOCCacheHeader), 1, f);
+        fwrite(cacheEntries.data(), sizeof(TOCCacheEntry), cacheEntries.size(), f);
+        fwrite(cacheDependencies.data(), sizeof(TOCCacheDependency), cacheDependencies.size(), f);
+        fwrite(dependencyIndexes.data(), sizeof(uint32_t), dependencyIndexes.size(), f);
+        fwrite(strings.data(), 1, strings.size(), f);
+
+        bool writeFailed = ferror(f) != 0;
+        fclose(f);
+
+        std::error_code ec;
+        if (!writeFailed)
+            fs::rename(tmpCachePath, cachePath, ec);
+
+        if (writeFailed || ec)
+        {
+            fprintf(stderr, "ERROR : ResourceTOCCache : Failed to write %s\n", cachePath.string().c_str());
+            fs::remove(tmpCachePath, ec);
+            return false;
+        }
+
+        return true;
+    }
+}
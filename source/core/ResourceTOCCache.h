@@ -0,0 +1,97 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <filesystem>
+
+#include "MappedFile.h"
+#include "ResourceLoadProgress.h"
+#include "ResourceTable.h"
+
+#pragma pack(push)  // Not portable, sorry.
+#pragma pack(1)     // Works on my machine (TM).
+
+namespace fs = std::filesystem;
+
+namespace HAYDEN
+{
+    /**
+    *   Notes on the TOC cache format:
+    *
+    *   After a .resources file is parsed, its entries are written to a sidecar file in cache/toc/.
+    *   The next time the same archive is opened, the sidecar is mapped and used instead of parsing the archive.
+    *
+    *   The format is:
+    *     (a) a TOCCacheHeader, used to check the sidecar still matches the archive, followed by
+    *     (b) one TOCCacheEntry per resource entry, in archive order, followed by
+    *     (c) one TOCCacheDependency per dependency entry, in archive order, followed by
+    *     (d) the archive's dependency indexes (uint32_t), followed by
+    *     (e) a blob with all name/type strings (not null-terminated)
+    */
+
+    struct ResourceDependency;
+
+    const uint32_t TOC_CACHE_MAGIC = 0x434F5453;    // "STOC"
+    const uint32_t TOC_CACHE_VERSION = 3;           // bump this whenever the cached fields change
+
+    struct TOCCacheHeader // 0x58 bytes
+    {
+        /* 0x00 */ uint32_t Magic = TOC_CACHE_MAGIC;
+        /* 0x04 */ uint32_t FormatVersion = TOC_CACHE_VERSION;
+        /* 0x08 */ uint64_t ArchiveSize = 0;            // must match the .resources file size
+        /* 0x10 */ int64_t  ArchiveModifiedTime = 0;    // must match the .resources file last write time
+        /* 0x18 */ uint32_t ArchiveMagic = 0;           // must match ResourceFileHeader::Magic
+        /* 0x1C */ uint32_t ArchiveVersion = 0;         // must match ResourceFileHeader::Version
+        /* 0x20 */ uint64_t NumEntries = 0;
+        /* 0x28 */ uint64_t AddrStrings = 0;
+        /* 0x30 */ uint64_t SizeStrings = 0;
+        /* 0x38 */ uint64_t NumDependencies = 0;
+        /* 0x40 */ uint64_t AddrDependencies = 0;
+        /* 0x48 */ uint64_t NumDependencyIndexes = 0;
+        /* 0x50 */ uint64_t AddrDependencyIndexes = 0;
+    };
+
+    struct TOCCacheEntry // 0x48 bytes
+    {
+        /* 0x00 */ uint64_t DataOffset = 0;
+        /* 0x08 */ uint64_t DataSize = 0;
+        /* 0x10 */ uint64_t DataSizeUncompressed = 0;
+        /* 0x18 */ uint64_t StreamResourceHash = 0;
+        /* 0x20 */ uint32_t Version = 0;
+        /* 0x24 */ uint16_t CompressionMode = 0;
+        /* 0x26 */ uint16_t TypeLength = 0;
+        /* 0x28 */ uint32_t TypeOffset = 0;             // type strings are only stored once and shared between entries
+        /* 0x2C */ uint32_t NameOffset = 0;             // string offsets are relative to TOCCacheHeader::AddrStrings
+        /* 0x30 */ uint32_t NameLength = 0;
+        /* 0x34 */ uint32_t DependencyIndexNumber = 0;
+        /* 0x38 */ uint16_t NumDependencies = 0;
+        /* 0x3A */ uint16_t Unused3A = 0;
+        /* 0x3C */ uint32_t Unused3C = 0;
+        /* 0x40 */ uint64_t DataCheckSum = 0;
+    };
+
+    struct TOCCacheDependency // 0x18 bytes
+    {
+        /* 0x00 */ uint32_t DependencyType = 0;
+        /* 0x04 */ uint32_t TypeOffset = 0;             // same string blob as TOCCacheEntry
+        /* 0x08 */ uint32_t NameOffset = 0;
+        /* 0x0C */ uint32_t NameLength = 0;
+        /* 0x10 */ uint16_t TypeLength = 0;
+        /* 0x12 */ uint16_t Unused12 = 0;
+        /* 0x14 */ uint32_t Unused14 = 0;
+    };
+
+    // Path of the sidecar file for a given .resources file
+    fs::path getTOCCachePath(const fs::path& resourcePath);
+
+    // Fills the resource table and dependency tables from the sidecar file. Returns false if there is no sidecar or it's stale.
+    bool loadTOCCache(const fs::path& resourcePath, ResourceTable& resourceTable, std::vector<ResourceDependency>& dependencies, std::vector<uint32_t>& dependencyIndexes);
+
+    // Fills the resource table with only the entries that pass filter. Returns false if there is no sidecar, it's stale, or progress was cancelled.
+    bool loadTOCCache(const fs::path& resourcePath, ResourceTable& resourceTable, const ResourceEntryFilter& filter, ResourceLoadProgress* progress = NULL);
+
+    // Writes the sidecar file for this .resources file
+    bool saveTOCCache(const fs::path& resourcePath, const ResourceTable& resourceTable, const std::vector<ResourceDependency>& dependencies, const std::vector<uint32_t>& dependencyIndexes);
+}
+
+#pragma pack(pop)
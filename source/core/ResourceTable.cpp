@@ -0,0 +1,113 @@
+#include "ResourceTable.h"
+
+namespace HAYDEN
+{
+    ResourceEntry ResourceTable::GetEntry(uint32_t i) const
+    {
+        ResourceEntry entry;
+        entry.Index = _EntryIndexes[i];
+        entry.DataOffset = _DataOffsets[i];
+        entry.DataSize = _DataSizes[i];
+        entry.DataSizeUncompressed = _DataSizesUncompressed[i];
+        entry.DataCheckSum = _DataCheckSums[i];
+        entry.StreamResourceHash = _StreamResourceHashes[i];
+        entry.DependencyIndexNumber = _DependencyIndexNumbers[i];
+        entry.Version = _Versions[i];
+        entry.CompressionMode = _CompressionModes[i];
+        entry.NumDependencies = _NumDependencies[i];
+        entry.Name = GetName(i);
+        entry.Type = GetType(i);
+        return entry;
+    }
+
+    int32_t ResourceTable::FindTypeId(std::string_view type) const
+    {
+        for (size_t i = 0; i < _Types.size(); i++)
+        {
+            if (_Types[i] == type)
+                return (int32_t)i;
+        }
+        return -1;
+    }
+
+    std::vector<uint32_t> ResourceTable::FindByVersion(uint32_t version) const
+    {
+        std::vector<uint32_t> entryIndexes;
+        for (uint32_t i = 0; i < _Versions.size(); i++)
+        {
+            if (_Versions[i] == version)
+                entryIndexes.push_back(i);
+        }
+        return entryIndexes;
+    }
+
+    std::vector<uint32_t> ResourceTable::FindByType(std::string_view type) const
+    {
+        std::vector<uint32_t> entryIndexes;
+        int32_t typeId = FindTypeId(type);
+        if (typeId == -1)
+            return entryIndexes;
+
+        for (uint32_t i = 0; i < _TypeIds.size(); i++)
+        {
+            if (_TypeIds[i] == typeId)
+                entryIndexes.push_back(i);
+        }
+        return entryIndexes;
+    }
+
+    void ResourceTable::Reserve(uint64_t numEntries, uint64_t namesSize)
+    {
+        _EntryIndexes.reserve(numEntries);
+        _DataOffsets.reserve(numEntries);
+        _DataSizes.reserve(numEntries);
+        _DataSizesUncompressed.reserve(numEntries);
+        _DataCheckSums.reserve(numEntries);
+        _StreamResourceHashes.reserve(numEntries);
+        _DependencyIndexNumbers.reserve(numEntries);
+        _Versions.reserve(numEntries);
+        _CompressionModes.reserve(numEntries);
+        _NumDependencies.reserve(numEntries);
+        _TypeIds.reserve(numEntries);
+        _NameOffsets.reserve(numEntries + 1);
+        _NameData.reserve(namesSize);
+    }
+
+    // Appends a row, entry.Index must be the entry's index in the .resources file. Returns the row number.
+    uint32_t ResourceTable::AddEntry(const ResourceEntry& entry)
+    {
+        // Entries of the same type are usually next to each other, so check the last type first
+        if (_Types.empty() || _Types[_LastTypeId] != entry.Type)
+        {
+            int32_t typeId = FindTypeId(entry.Type);
+            if (typeId == -1)
+            {
+                typeId = (int32_t)_Types.size();
+                _Types.emplace_back(entry.Type);
+            }
+            _LastTypeId = (uint16_t)typeId;
+        }
+
+        _EntryIndexes.push_back(entry.Index);
+        _DataOffsets.push_back(entry.DataOffset);
+        _DataSizes.push_back(entry.DataSize);
+        _DataSizesUncompressed.push_back(entry.DataSizeUncompressed);
+        _DataCheckSums.push_back(entry.DataCheckSum);
+        _StreamResourceHashes.push_back(entry.StreamResourceHash);
+        _DependencyIndexNumbers.push_back(entry.DependencyIndexNumber);
+        _Versions.push_back(entry.Version);
+        _CompressionModes.push_back(entry.CompressionMode);
+        _NumDependencies.push_back(entry.NumDependencies);
+        _TypeIds.push_back(_LastTypeId);
+
+        _NameData.insert(_NameData.end(), entry.Name.begin(), entry.Name.end());
+        _NameOffsets.push_back((uint32_t)_NameData.size());
+
+        return (uint32_t)(_Versions.size() - 1);
+    }
+
+    void ResourceTable::Clear()
+    {
+        *this = ResourceTable();
+    }
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <functional>
+
+namespace HAYDEN
+{
+    // One row of a ResourceTable. Name and Type are views into the table, valid for as long as the table is alive.
+    struct ResourceEntry
+    {
+        uint32_t Index = 0;                     // entry index in the .resources file
+        uint64_t DataOffset = 0;
+        uint64_t DataSize = 0;
+        uint64_t DataSizeUncompressed = 0;
+        uint64_t DataCheckSum = 0;
+        uint64_t StreamResourceHash = 0;
+        uint64_t DependencyIndexNumber = 0;
+        uint32_t Version = 0;
+        uint16_t CompressionMode = 0;
+        uint16_t NumDependencies = 0;
+        std::string_view Name;
+        std::string_view Type;
+    };
+
+    // Used to only parse some entries of a .resources file. Only gets the fields known before any names are resolved.
+    using ResourceEntryFilter = std::function<bool(uint32_t version, std::string_view type)>;
+
+    // Every entry of a single .resources file, stored by column.
+    //
+    // Each field has its own array, so a filter on one field (e.g. Version == 67) is a single scan over one array.
+    // All names are stored back to back in one buffer, and each distinct type string is only stored once.
+    // Tables are filled once while parsing and never modified after that, so they can be shared between threads.
+    class ResourceTable
+    {
+        public:
+
+            uint64_t Size() const { return _Versions.size(); }
+            bool Empty() const { return _Versions.empty(); }
+
+            // Copies row i out of the columns. Cheap, the strings are views.
+            ResourceEntry GetEntry(uint32_t i) const;
+            ResourceEntry operator[](uint32_t i) const { return GetEntry(i); }
+
+            std::string_view GetName(uint32_t i) const { return std::string_view(_NameData.data() + _NameOffsets[i], _NameOffsets[i + 1] - _NameOffsets[i]); }
+            std::string_view GetType(uint32_t i) const { return _Types[_TypeIds[i]]; }
+
+            // Columns, one value per entry. Entry indexes only differ from the row number in a filtered table.
+            const std::vector<uint32_t>& GetEntryIndexes() const { return _EntryIndexes; }
+            const std::vector<uint64_t>& GetDataOffsets() const { return _DataOffsets; }
+            const std::vector<uint64_t>& GetDataSizes() const { return _DataSizes; }
+            const std::vector<uint64_t>& GetDataSizesUncompressed() const { return _DataSizesUncompressed; }
+            const std::vector<uint64_t>& GetDataCheckSums() const { return _DataCheckSums; }
+            const std::vector<uint64_t>& GetStreamResourceHashes() const { return _StreamResourceHashes; }
+            const std::vector<uint64_t>& GetDependencyIndexNumbers() const { return _DependencyIndexNumbers; }
+            const std::vector<uint32_t>& GetVersions() const { return _Versions; }
+            const std::vector<uint16_t>& GetCompressionModes() const { return _CompressionModes; }
+            const std::vector<uint16_t>& GetNumDependencies() const { return _NumDependencies; }
+            const std::vector<uint16_t>& GetTypeIds() const { return _TypeIds; }
+
+            // Distinct type strings, indexed by the values in GetTypeIds()
+            const std::vector<std::string>& GetTypes() const { return _Types; }
+
+            // Returns -1 if no entry has this type
+            int32_t FindTypeId(std::string_view type) const;
+
+            // Rows of all entries with the given resource Version (0x43 = model, 0x21 = image, etc.) or type string
+            std::vector<uint32_t> FindByVersion(uint32_t version) const;
+            std::vector<uint32_t> FindByType(std::string_view type) const;
+
+            // Only used while the table is being filled
+            void Reserve(uint64_t numEntries, uint64_t namesSize);
+            uint32_t AddEntry(const ResourceEntry& entry);
+            void Clear();
+
+        private:
+            std::vector<uint32_t> _EntryIndexes;
+            std::vector<uint64_t> _DataOffsets;
+            std::vector<uint64_t> _DataSizes;
+            std::vector<uint64_t> _DataSizesUncompressed;
+            std::vector<uint64_t> _DataCheckSums;
+            std::vector<uint64_t> _StreamResourceHashes;
+            std::vector<uint64_t> _DependencyIndexNumbers;
+            std::vector<uint32_t> _Versions;
+            std::vector<uint16_t> _CompressionModes;
+            std::vector<uint16_t> _NumDependencies;
+            std::vector<uint16_t> _TypeIds;
+
+            // Name i is _NameData[_NameOffsets[i] .. _NameOffsets[i + 1])
+            std::vector<char> _NameData;
+            std::vector<uint32_t> _NameOffsets = { 0 };
+
+            std::vector<std::string> _Types;
+            uint16_t _LastTypeId = 0;
+    };
+}
@@ -0,0 +1,54 @@
+#include "ResourceVerifier.h"
+
+#include <chrono>
+
+#include "Checksum.h"
+
+namespace HAYDEN
+{
+    // Verifies every entry matching filter. numThreads = 0 uses one worker per core.
+    VerificationStats ResourceVerifier::Verify(const ResourceFilter& filter, uint32_t numThreads)
+    {
+        VerificationStats stats;
+        auto verifyStart = std::chrono::steady_clock::now();
+
+        // Entries without a stored checksum are never read
+        std::vector<ResourceEntry> selectedEntries;
+        for (const ResourceEntry& entry : filter.SelectEntries(_ResourceReader))
+        {
+            if (entry.DataCheckSum != 0)
+                selectedEntries.push_back(entry);
+            else
+                stats.NumSkipped++;
+        }
+
+        ResourcePipeline pipeline;
+        pipeline.ProcessJob = [](ResourceJob& job)
+        {
+            job.Checksum = murmurHash64A(job.Output, job.Entry.DataSizeUncompressed);
+        };
+
+        // Results are tallied on this thread, so mismatches are reported in archive order
+        pipeline.FinishJob = [&](ResourceJob& job)
+        {
+            if (job.Failed)
+            {
+                fprintf(stderr, "ERROR : ResourceVerifier : Failed to read %s\n", std::string(job.Entry.Name).c_str());
+                stats.NumFailed++;
+                return;
+            }
+
+            stats.NumEntries++;
+            stats.BytesHashed += job.Entry.DataSizeUncompressed;
+
+            if (job.Checksum != job.Entry.DataCheckSum)
+                stats.Mismatches.push_back({ std::string(job.Entry.Name), job.Entry.DataCheckSum, job.Checksum });
+        };
+
+        stats.BytesRead = pipeline.Run(_ResourceReader.ResourceFilePath, selectedEntries, numThreads);
+
+        std::chrono::duration<double> verifyTime = std::chrono::steady_clock::now() - verifyStart;
+        stats.Seconds = verifyTime.count();
+        return stats;
+    }
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <filesystem>
+
+#include "ResourceFileReader.h"
+#include "ResourcePipeline.h"
+
+namespace fs = std::filesystem;
+
+namespace HAYDEN
+{
+    struct ChecksumMismatch
+    {
+        std::string Name;
+        uint64_t Expected = 0;                  // ResourceEntry::DataCheckSum
+        uint64_t Actual = 0;                    // checksum of the decompressed data
+    };
+
+    struct VerificationStats
+    {
+        uint64_t NumEntries = 0;                // entries hashed, matching or not
+        uint64_t NumFailed = 0;                 // entries that couldn't be read or decompressed
+        uint64_t NumSkipped = 0;                // entries without a stored checksum
+        uint64_t BytesRead = 0;                 // compressed bytes read from the archive
+        uint64_t BytesHashed = 0;               // decompressed bytes hashed
+        double Seconds = 0;
+        std::vector<ChecksumMismatch> Mismatches;
+
+        double MegabytesPerSecond() const { return Seconds > 0 ? (BytesHashed / (1024.0 * 1024.0)) / Seconds : 0; }
+        double EntriesPerSecond() const { return Seconds > 0 ? NumEntries / Seconds : 0; }
+    };
+
+    // Checks the DataCheckSum of embedded files in a single .resources file.
+    // Entries go through a ResourcePipeline, hashing happens on the decompression workers right after each entry is decompressed.
+    class ResourceVerifier
+    {
+        public:
+
+            // Verifies every entry matching filter. numThreads = 0 uses one worker per core.
+            VerificationStats Verify(const ResourceFilter& filter, uint32_t numThreads = 0);
+
+            ResourceVerifier(ResourceFileReader& resourceReader) : _ResourceReader(resourceReader) {}
+
+        private:
+            ResourceFileReader& _ResourceReader;
+    };
+}
@@ -0,0 +1,159 @@
+#include "StreamDBWriter.h"
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+#include "Utilities.h"
+
+namespace HAYDEN
+{
+    // Entry data starts on a 16 byte boundary, StreamDBEntry::DataOffset16 counts in those units
+    static uint64_t alignTo16(uint64_t offset)
+    {
+        return (offset + 15) & ~15ull;
+    }
+
+    // Adds data under identifier. Adding an identifier again replaces its data.
+    void StreamDBWriter::AddEntry(uint64_t identifier, std::vector<uint8_t> data)
+    {
+        auto existing = _EntryByIdentifier.find(identifier);
+        if (existing != _EntryByIdentifier.end())
+        {
+            _Entries[existing->second].Data = std::move(data);
+            return;
+        }
+
+        _EntryByIdentifier.emplace(identifier, _Entries.size());
+        _Entries.push_back({ identifier, std::move(data) });
+    }
+
+    void StreamDBWriter::Clear()
+    {
+        _Entries.clear();
+        _EntryByIdentifier.clear();
+    }
+
+    uint64_t StreamDBWriter::GetFileSize() const
+    {
+        uint64_t fileSize = alignTo16(sizeof(StreamDBHeader) + (_Entries.size() * sizeof(StreamDBEntry)));
+        for (const PendingEntry& entry : _Entries)
+            fileSize = alignTo16(fileSize + entry.Data.size());
+
+        return fileSize;
+    }
+
+    // Writes to a temporary file first, then renames it over filePath
+    bool StreamDBWriter::Write(const fs::path& filePath) const
+    {
+        // Index is sorted by identifier, data follows in the same order
+        std::vector<uint32_t> writeOrder(_Entries.size());
+        std::iota(writeOrder.begin(), writeOrder.end(), 0);
+        std::sort(writeOrder.begin(), writeOrder.end(), [this](uint32_t a, uint32_t b) {
+            return _Entries[a].Identifier < _Entries[b].Identifier;
+        });
+
+        StreamDBHeader header;
+        header.Magic = STREAMDB_MAGIC;
+        header.HeaderLength = (uint32_t)(sizeof(StreamDBHeader) + (_Entries.size() * sizeof(StreamDBEntry)));
+        header.NumEntries = (uint32_t)_Entries.size();
+
+        std::vector<StreamDBEntry> index(_Entries.size());
+        uint64_t dataOffset = alignTo16(header.HeaderLength);
+
+        for (size_t i = 0; i < writeOrder.size(); i++)
+        {
+            const PendingEntry& entry = _Entries[writeOrder[i]];
+
+            // Offsets are stored in 16 byte units, lengths in 32 bits
+            if (dataOffset / 16 > UINT32_MAX || entry.Data.size() > UINT32_MAX)
+            {
+                fprintf(stderr, "ERROR : StreamDBWriter : %s would be larger than the .streamdb format allows.\n", filePath.string().c_str());
+                return false;
+            }
+
+            index[i].Identifier = entry.Identifier;
+            index[i].DataOffset16 = (uint32_t)(dataOffset / 16);
+            index[i].DataLength = (uint32_t)entry.Data.size();
+            dataOffset = alignTo16(dataOffset + entry.Data.size());
+        }
+
+        fs::path tmpFilePath = filePath;
+        tmpFilePath += ".tmp";
+
+        if (filePath.has_parent_path() && !fs::exists(filePath.parent_path()))
+            if (!mkpath(filePath.parent_path()))
+                return false;
+
+        FILE* f = openLongFilePath(tmpFilePath); //wb
+        if (f == NULL)
+        {
+            fprintf(stderr, "ERROR : StreamDBWriter : Failed to open %s for writing.\n", tmpFilePath.string().c_str());
+            return false;
+        }
+
+        // Small entries are gathered into one buffer and written together, large ones are written straight from their own buffer
+        const uint64_t writeBlockSize = 8 * 1024 * 1024;
+        std::vector<uint8_t> writeBuffer;
+        writeBuffer.reserve(writeBlockSize);
+        bool writeFailed = 0;
+
+        auto flushBuffer = [&]()
+        {
+            if (!writeBuffer.empty() && fwrite(writeBuffer.data(), 1, writeBuffer.size(), f) != writeBuffer.size())
+                writeFailed = 1;
+
+            writeBuffer.clear();
+        };
+
+        auto appendData = [&](const void* data, uint64_t size)
+        {
+            if (writeBuffer.size() + size > writeBlockSize)
+                flushBuffer();
+
+            if (size >= writeBlockSize)
+            {
+                if (fwrite(data, 1, size, f) != size)
+                    writeFailed = 1;
+                return;
+            }
+
+            const uint8_t* bytes = (const uint8_t*)data;
+            writeBuffer.insert(writeBuffer.end(), bytes, bytes + size);
+        };
+
+        const uint8_t padding[16] = { 0 };
+        uint64_t fileOffset = 0;
+
+        appendData(&header, sizeof(StreamDBHeader));
+        appendData(index.data(), index.size() * sizeof(StreamDBEntry));
+        fileOffset = header.HeaderLength;
+
+        for (uint32_t i : writeOrder)
+        {
+            const PendingEntry& entry = _Entries[i];
+            appendData(padding, alignTo16(fileOffset) - fileOffset);
+            appendData(entry.Data.data(), entry.Data.size());
+            fileOffset = alignTo16(fileOffset) + entry.Data.size();
+        }
+
+        appendData(padding, alignTo16(fileOffset) - fileOffset);
+        flushBuffer();
+
+        writeFailed = writeFailed || ferror(f) != 0 || !syncFile(f);
+        fclose(f);
+
+        std::error_code ec;
+        if (!writeFailed)
+            fs::rename(tmpFilePath, filePath, ec);
+
+        if (writeFailed || ec)
+        {
+            fprintf(stderr, "ERROR : StreamDBWriter : Failed to write %s\n", filePath.string().c_str());
+            fs::remove(tmpFilePath, ec);
+            return false;
+        }
+
+        return true;
+    }
+}
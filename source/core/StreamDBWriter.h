@@ -0,0 +1,44 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <filesystem>
+
+#include "types/StreamDBFile.h"
+
+namespace fs = std::filesystem;
+
+namespace HAYDEN
+{
+    // Builds a .streamdb file (see StreamDBFile for the format) from entries added in any order.
+    // Entries are kept in memory until Write, which lays out the header, the index sorted by identifier, and the data
+    // 16 byte aligned, all in one sequential pass with large writes.
+    class StreamDBWriter
+    {
+        public:
+
+            // Adds data under identifier. Adding an identifier again replaces its data.
+            void AddEntry(uint64_t identifier, std::vector<uint8_t> data);
+            void Clear();
+
+            uint64_t NumEntries() const { return _Entries.size(); }
+            bool Empty() const { return _Entries.empty(); }
+
+            // Size of the file Write would produce
+            uint64_t GetFileSize() const;
+
+            // Writes to a temporary file first, then renames it over filePath
+            bool Write(const fs::path& filePath) const;
+
+        private:
+            struct PendingEntry
+            {
+                uint64_t Identifier = 0;
+                std::vector<uint8_t> Data;
+            };
+
+            std::vector<PendingEntry> _Entries;
+            std::unordered_map<uint64_t, size_t> _EntryByIdentifier;
+    };
+}
@@ -0,0 +1,221 @@
+#include "ThumbnailCache.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "LWODecoder.h"
+#include "ResourceIndex.h"
+#include "ResourceSession.h"
+#include "Utilities.h"
+
+namespace HAYDEN
+{
+    // Cache key for an entry's thumbnail
+    uint64_t getThumbnailKey(const ResourceEntry& entry)
+    {
+        if (entry.DataCheckSum != 0)
+            return entry.DataCheckSum;
+
+        return hashResourceName(entry.Name) ^ (entry.DataOffset * 0x9E3779B97F4A7C15ull) ^ entry.DataSize;
+    }
+
+    ThumbnailCache::ThumbnailCache(const fs::path& basePath, uint32_t size, uint32_t numThreads)
+        : _BasePath(basePath), _Size(size)
+    {
+        if (numThreads == 0)
+            numThreads = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+
+        for (uint32_t i = 0; i < numThreads; i++)
+            _Workers.emplace_back([this]() { RunWorker(); });
+    }
+
+    // Drops everything waiting, and waits for the thumbnails being rendered
+    ThumbnailCache::~ThumbnailCache()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_Mutex);
+            _Pending.clear();
+            _IsStopping = 1;
+        }
+
+        _WorkAvailable.notify_all();
+        for (std::thread& worker : _Workers)
+            worker.join();
+    }
+
+    // Replaces everything still waiting. Requests are rendered in the order given.
+    void ThumbnailCache::Request(std::vector<ThumbnailRequest> requests)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_Mutex);
+            _Pending.clear();
+
+            for (ThumbnailRequest& request : requests)
+                if (_Rendering.count(request.Key) == 0)
+                    _Pending.push_back(std::move(request));
+        }
+
+        _WorkAvailable.notify_all();
+    }
+
+    fs::path ThumbnailCache::GetCachePath(uint64_t key)
+    {
+        return fs::current_path() / "cache" / "thumbnails" / (intToHex(key) + ".thumb");
+    }
+
+    // A missing, stale or different sized file returns false. A model saved as not renderable returns true with an empty thumbnail.
+    bool ThumbnailCache::Load(uint64_t key, uint32_t size, Thumbnail& thumbnail)
+    {
+        thumbnail = Thumbnail();
+
+        FILE* f = fopen(GetCachePath(key).string().c_str(), "rb");
+        if (f == NULL)
+            return 0;
+
+        ThumbnailFileHeader header;
+        bool isValid = fread(&header, 1, sizeof(ThumbnailFileHeader), f) == sizeof(ThumbnailFileHeader);
+        isValid = isValid && header.Magic == THUMBNAIL_MAGIC && header.FormatVersion == THUMBNAIL_VERSION;
+        isValid = isValid && (header.Size == 0 || header.Size == size);
+
+        if (isValid && header.Size != 0)
+        {
+            thumbnail.Size = header.Size;
+            thumbnail.Pixels.resize((size_t)header.Size * header.Size * 2);
+            isValid = fread(thumbnail.Pixels.data(), 1, thumbnail.Pixels.size(), f) == thumbnail.Pixels.size();
+        }
+
+        fclose(f);
+
+        if (!isValid)
+            thumbnail = Thumbnail();
+
+        return isValid;
+    }
+
+    // Writes to a temporary file first, then renames it, so a reader never sees half a thumbnail
+    bool ThumbnailCache::Save(uint64_t key, const Thumbnail& thumbnail)
+    {
+        fs::path cachePath = GetCachePath(key);
+        fs::path tmpCachePath = cachePath;
+        tmpCachePath += ".tmp";
+
+        if (!fs::exists(cachePath.parent_path()))
+            if (!mkpath(cachePath.parent_path()))
+                return false;
+
+        FILE* f = openLongFilePath(tmpCachePath); //wb
+        if (f == NULL)
+            return false;
+
+        ThumbnailFileHeader header;
+        header.Size = thumbnail.Empty() ? 0 : thumbnail.Size;
+
+        bool writeFailed = fwrite(&header, 1, sizeof(ThumbnailFileHeader), f) != sizeof(ThumbnailFileHeader);
+        writeFailed = writeFailed || fwrite(thumbnail.Pixels.data(), 1, thumbnail.Pixels.size(), f) != thumbnail.Pixels.size();
+        writeFailed = writeFailed || ferror(f) != 0;
+        fclose(f);
+
+        std::error_code ec;
+        if (!writeFailed)
+            fs::rename(tmpCachePath, cachePath, ec);
+
+        if (writeFailed || ec)
+        {
+            fs::remove(tmpCachePath, ec);
+            return false;
+        }
+
+        return true;
+    }
+
+    void ThumbnailCache::RunWorker()
+    {
+        while (1)
+        {
+            ThumbnailRequest request;
+            {
+                std::unique_lock<std::mutex> lock(_Mutex);
+                _WorkAvailable.wait(lock, [this]() { return _IsStopping || !_Pending.empty(); });
+
+                if (_IsStopping)
+                    return;
+
+                request = std::move(_Pending.front());
+                _Pending.pop_front();
+
+                // Two workers never render the same model, Request skips keys in here too
+                if (!_Rendering.insert(request.Key).second)
+                    continue;
+            }
+
+            std::shared_ptr<const Thumbnail> thumbnail = GetThumbnail(request);
+
+            {
+                std::lock_guard<std::mutex> lock(_Mutex);
+                _Rendering.erase(request.Key);
+            }
+
+            if (OnThumbnail)
+                OnThumbnail(request.Key, thumbnail);
+        }
+    }
+
+    // From disk if it's been rendered before, rendered and saved otherwise
+    std::shared_ptr<const Thumbnail> ThumbnailCache::GetThumbnail(const ThumbnailRequest& request)
+    {
+        auto thumbnail = std::make_shared<Thumbnail>();
+        if (Load(request.Key, _Size, *thumbnail))
+            return thumbnail;
+
+        // An archive that can't be read now might be readable later, only models that don't render are remembered
+        std::shared_ptr<const std::vector<uint8_t>> header = ResourceSession::Get().GetEmbeddedFile(request.ArchivePath, request.EntryName);
+        if (!header)
+            return thumbnail;
+
+        LWODecodeResult renderResult = RenderModel(request, *header, *thumbnail);
+        if (renderResult != LWODecodeResult::Decoded)
+            *thumbnail = Thumbnail();
+
+        if (renderResult == LWODecodeResult::Decoded || renderResult == LWODecodeResult::Unsupported)
+            Save(request.Key, *thumbnail);
+
+        return thumbnail;
+    }
+
+    // Lowest detail LOD first, it's the fastest to decode and looks the same at this size.
+    // Unsupported only if no LOD rendered and none of them failed for a reason that might go away.
+    LWODecodeResult ThumbnailCache::RenderModel(const ThumbnailRequest& request, const std::vector<uint8_t>& header, Thumbnail& thumbnail)
+    {
+        std::call_once(_StreamDBsOpened, [this]()
+        {
+            for (const fs::path& streamDBPath : StreamDBFile::FindStreamDBs(_BasePath))
+            {
+                auto streamDB = std::make_shared<const StreamDBFile>(streamDBPath);
+                if (streamDB->IsLoaded())
+                    _StreamDBs.push_back(streamDB);
+            }
+        });
+
+        const uint64_t streamDBIdentifier = getLWOStreamDBIdentifier(request.StreamResourceHash);
+        std::vector<LWOMeshGeometry> meshes;
+
+        LWODecodeResult renderResult = LWODecodeResult::Unsupported;
+
+        for (int32_t lod = 2; lod >= 0; lod--)
+        {
+            LWODecodeResult decodeResult = decodeLWOModel(header.data(), header.size(), streamDBIdentifier, _StreamDBs, lod, 1, meshes);
+            if (decodeResult != LWODecodeResult::Decoded)
+            {
+                if (decodeResult != LWODecodeResult::Unsupported)
+                    renderResult = decodeResult;
+                continue;
+            }
+
+            // Decoded, but nothing to draw (e.g. no triangles). That won't change next time.
+            if (renderThumbnail(meshes, _Size, thumbnail))
+                return LWODecodeResult::Decoded;
+        }
+
+        return renderResult;
+    }
+}
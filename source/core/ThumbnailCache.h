@@ -0,0 +1,115 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <functional>
+#include <unordered_set>
+#include <condition_variable>
+#include <filesystem>
+
+#include "types/StreamDBFile.h"
+
+#include "ResourceTable.h"
+#include "ThumbnailRenderer.h"
+
+namespace fs = std::filesystem;
+
+namespace HAYDEN
+{
+    /**
+    *   Notes on the thumbnail cache:
+    *
+    *   Thumbnails are rendered from the lowest detail LOD that decodes, and written to cache/thumbnails/<key>.thumb.
+    *   The key is the entry's DataCheckSum, so the same model in several archives is only rendered once,
+    *   and a model that's been replaced gets a new thumbnail. Entries without a checksum fall back to a hash of name, offset and size.
+    *
+    *   The format is:
+    *     (a) a ThumbnailFileHeader, followed by
+    *     (b) Size * Size * 2 bytes of pixels, laid out as in Thumbnail
+    *
+    *   Models whose header we can't read are saved with Size 0, so they aren't tried again. Anything that might work
+    *   next time (Oodle not loaded, a .streamdb that couldn't be opened, a failed decompression) isn't saved at all.
+    */
+
+    const uint32_t THUMBNAIL_MAGIC = 0x424D4854;    // "THMB"
+    const uint32_t THUMBNAIL_VERSION = 2;           // bump this whenever the renderer's output changes
+
+#pragma pack(push)  // Not portable, sorry.
+#pragma pack(1)     // Works on my machine (TM).
+
+    struct ThumbnailFileHeader // 0x10 bytes
+    {
+        /* 0x00 */ uint32_t Magic = THUMBNAIL_MAGIC;
+        /* 0x04 */ uint32_t FormatVersion = THUMBNAIL_VERSION;
+        /* 0x08 */ uint32_t Size = 0;
+        /* 0x0C */ uint32_t Unused0C = 0;
+    };
+
+#pragma pack(pop)
+
+    struct ThumbnailRequest
+    {
+        uint64_t Key = 0;                       // from getThumbnailKey
+        uint64_t StreamResourceHash = 0;
+        fs::path ArchivePath;
+        std::string EntryName;
+    };
+
+    // Called on a worker thread. thumbnail is empty if the model couldn't be rendered.
+    using ThumbnailCallback = std::function<void(uint64_t key, std::shared_ptr<const Thumbnail> thumbnail)>;
+
+    // Cache key for an entry's thumbnail
+    uint64_t getThumbnailKey(const ResourceEntry& entry);
+
+    // Renders .lwo thumbnails on a pool of background threads, and keeps them on disk.
+    //
+    // Request replaces everything still waiting, so callers pass only what's on screen (most important first) every time
+    // the view moves, and whatever was scrolled past is simply dropped. Requests already being rendered aren't queued again.
+    // Workers leave one core free, so the thread asking stays responsive.
+    class ThumbnailCache
+    {
+        public:
+
+            ThumbnailCallback OnThumbnail;
+
+            // Set OnThumbnail before the first Request. Geometry is looked up in every .streamdb under basePath, opened on first use.
+            ThumbnailCache(const fs::path& basePath, uint32_t size, uint32_t numThreads = 0);
+            ~ThumbnailCache();
+
+            void Request(std::vector<ThumbnailRequest> requests);
+            void Cancel() { Request(std::vector<ThumbnailRequest>()); }
+
+            uint32_t GetSize() const { return _Size; }
+
+            static fs::path GetCachePath(uint64_t key);
+
+            // A missing, stale or different sized file returns false. A model saved as not renderable returns true with an empty thumbnail.
+            static bool Load(uint64_t key, uint32_t size, Thumbnail& thumbnail);
+            static bool Save(uint64_t key, const Thumbnail& thumbnail);
+
+            ThumbnailCache(const ThumbnailCache&) = delete;
+            ThumbnailCache& operator=(const ThumbnailCache&) = delete;
+
+        private:
+            fs::path _BasePath;
+            uint32_t _Size = 0;
+
+            std::once_flag _StreamDBsOpened;
+            std::vector<std::shared_ptr<const StreamDBFile>> _StreamDBs;
+
+            std::deque<ThumbnailRequest> _Pending;
+            std::unordered_set<uint64_t> _Rendering;
+            std::vector<std::thread> _Workers;
+            std::condition_variable _WorkAvailable;
+            std::mutex _Mutex;
+            bool _IsStopping = 0;
+
+            void RunWorker();
+            std::shared_ptr<const Thumbnail> GetThumbnail(const ThumbnailRequest& request);
+            LWODecodeResult RenderModel(const ThumbnailRequest& request, const std::vector<uint8_t>& header, Thumbnail& thumbnail);
+    };
+}
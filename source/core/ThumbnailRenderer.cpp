@@ -0,0 +1,290 @@
+#include "ThumbnailRenderer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// SSE2 is always there on x64. Anything else uses the scalar loops.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define HAYDEN_USE_SSE2
+#endif
+
+namespace HAYDEN
+{
+    // View rotation in radians: turn around Y first, then tilt so the camera looks down at the model
+    const float THUMBNAIL_YAW = 0.6f;
+    const float THUMBNAIL_PITCH = 0.45f;
+
+    // Light comes from above, front left of the camera. Faces turned away still get the ambient part.
+    const float THUMBNAIL_AMBIENT = 0.2f;
+    const float THUMBNAIL_LIGHT[3] = { -0.45f, 0.65f, 0.61f };
+
+    // Samples per pixel on each axis
+    const uint32_t THUMBNAIL_SUPERSAMPLE = 2;
+
+    struct ScreenVertex
+    {
+        float X = 0;
+        float Y = 0;
+        float Depth = 0;                        // smaller is closer
+        float Shade = 0;                        // 0..1
+    };
+
+    // Rows are padded to a multiple of 4 samples, so the SSE2 loop always works on whole groups and never needs a tail
+    struct RenderTarget
+    {
+        uint32_t Width = 0;
+        uint32_t Height = 0;
+        uint32_t Stride = 0;
+        std::vector<float> Depth;               // infinity where nothing was drawn
+        std::vector<float> Shade;
+
+        RenderTarget(uint32_t width, uint32_t height)
+            : Width(width), Height(height), Stride((width + 3) & ~3u)
+        {
+            Depth.assign((size_t)Stride * height, std::numeric_limits<float>::infinity());
+            Shade.assign((size_t)Stride * height, 0.0f);
+        }
+    };
+
+    // Edge function of p -> q as a plane over the screen: A * x + B * y + C, positive on the left of the edge
+    struct EdgeFunction
+    {
+        float A = 0;
+        float B = 0;
+        float C = 0;
+
+        EdgeFunction(const ScreenVertex& p, const ScreenVertex& q)
+            : A(p.Y - q.Y), B(q.X - p.X), C(p.X * q.Y - p.Y * q.X) {}
+
+        float At(float x, float y) const { return A * x + B * y + C; }
+    };
+
+    // Fills every sample whose center is inside the triangle and closer than what's there. Both windings are drawn.
+    static void rasterizeTriangle(RenderTarget& target, const ScreenVertex& v0, const ScreenVertex& v1, const ScreenVertex& v2)
+    {
+        const ScreenVertex* a = &v0;
+        const ScreenVertex* b = &v1;
+        const ScreenVertex* c = &v2;
+
+        float area = (b->X - a->X) * (c->Y - a->Y) - (b->Y - a->Y) * (c->X - a->X);
+        if (area < 0)
+        {
+            std::swap(b, c);
+            area = -area;
+        }
+
+        if (area < 1e-8f)
+            return;
+
+        float minX = std::max(std::floor(std::min({ a->X, b->X, c->X })), 0.0f);
+        float minY = std::max(std::floor(std::min({ a->Y, b->Y, c->Y })), 0.0f);
+        float maxX = std::min(std::ceil(std::max({ a->X, b->X, c->X })), (float)target.Width - 1);
+        float maxY = std::min(std::ceil(std::max({ a->Y, b->Y, c->Y })), (float)target.Height - 1);
+        if (minX > maxX || minY > maxY)
+            return;
+
+        // Each weight belongs to the vertex opposite its edge, and the three always add up to area
+        EdgeFunction e0(*b, *c), e1(*c, *a), e2(*a, *b);
+        const float invArea = 1.0f / area;
+
+        // Depth and shade are planes too, premultiplied so each is a single multiply-add per weight
+        const float z0 = a->Depth * invArea, z1 = b->Depth * invArea, z2 = c->Depth * invArea;
+        const float s0 = a->Shade * invArea, s1 = b->Shade * invArea, s2 = c->Shade * invArea;
+
+        const uint32_t startX = (uint32_t)minX & ~3u;
+        const uint32_t endX = (uint32_t)maxX;
+
+#ifdef HAYDEN_USE_SSE2
+        // Four samples of one row per iteration. Weights are evaluated directly at every group, so nothing drifts across the row.
+        const __m128 laneOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 a0 = _mm_set1_ps(e0.A), a1 = _mm_set1_ps(e1.A), a2 = _mm_set1_ps(e2.A);
+        const __m128 z0V = _mm_set1_ps(z0), z1V = _mm_set1_ps(z1), z2V = _mm_set1_ps(z2);
+        const __m128 s0V = _mm_set1_ps(s0), s1V = _mm_set1_ps(s1), s2V = _mm_set1_ps(s2);
+
+        for (uint32_t y = (uint32_t)minY; y <= (uint32_t)maxY; y++)
+        {
+            const float sampleY = y + 0.5f;
+            const __m128 row0 = _mm_set1_ps(e0.B * sampleY + e0.C);
+            const __m128 row1 = _mm_set1_ps(e1.B * sampleY + e1.C);
+            const __m128 row2 = _mm_set1_ps(e2.B * sampleY + e2.C);
+
+            float* depthRow = target.Depth.data() + (size_t)y * target.Stride;
+            float* shadeRow = target.Shade.data() + (size_t)y * target.Stride;
+
+            for (uint32_t x = startX; x <= endX; x += 4)
+            {
+                const __m128 sampleX = _mm_add_ps(_mm_set1_ps((float)x), laneOffsets);
+                const __m128 w0 = _mm_add_ps(_mm_mul_ps(a0, sampleX), row0);
+                const __m128 w1 = _mm_add_ps(_mm_mul_ps(a1, sampleX), row1);
+                const __m128 w2 = _mm_add_ps(_mm_mul_ps(a2, sampleX), row2);
+
+                __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(w0, zero), _mm_cmpge_ps(w1, zero)), _mm_cmpge_ps(w2, zero));
+                if (_mm_movemask_ps(inside) == 0)
+                    continue;
+
+                const __m128 depth = _mm_add_ps(_mm_add_ps(_mm_mul_ps(w0, z0V), _mm_mul_ps(w1, z1V)), _mm_mul_ps(w2, z2V));
+                const __m128 oldDepth = _mm_loadu_ps(depthRow + x);
+                const __m128 visible = _mm_and_ps(inside, _mm_cmplt_ps(depth, oldDepth));
+                if (_mm_movemask_ps(visible) == 0)
+                    continue;
+
+                // No blendv before SSE4.1, select with and/andnot
+                const __m128 shade = _mm_add_ps(_mm_add_ps(_mm_mul_ps(w0, s0V), _mm_mul_ps(w1, s1V)), _mm_mul_ps(w2, s2V));
+                const __m128 oldShade = _mm_loadu_ps(shadeRow + x);
+                _mm_storeu_ps(depthRow + x, _mm_or_ps(_mm_and_ps(visible, depth), _mm_andnot_ps(visible, oldDepth)));
+                _mm_storeu_ps(shadeRow + x, _mm_or_ps(_mm_and_ps(visible, shade), _mm_andnot_ps(visible, oldShade)));
+            }
+        }
+#else
+        for (uint32_t y = (uint32_t)minY; y <= (uint32_t)maxY; y++)
+        {
+            const float sampleY = y + 0.5f;
+            float* depthRow = target.Depth.data() + (size_t)y * target.Stride;
+            float* shadeRow = target.Shade.data() + (size_t)y * target.Stride;
+
+            for (uint32_t x = startX; x <= endX; x++)
+            {
+                const float sampleX = x + 0.5f;
+                const float w0 = e0.At(sampleX, sampleY);
+                const float w1 = e1.At(sampleX, sampleY);
+                const float w2 = e2.At(sampleX, sampleY);
+                if (w0 < 0 || w1 < 0 || w2 < 0)
+                    continue;
+
+                const float depth = w0 * z0 + w1 * z1 + w2 * z2;
+                if (depth >= depthRow[x])
+                    continue;
+
+                depthRow[x] = depth;
+                shadeRow[x] = w0 * s0 + w1 * s1 + w2 * s2;
+            }
+        }
+#endif
+    }
+
+    // Software rasterizer, no GPU needed. Every mesh is drawn from the same 3/4 view, above and to the front left, scaled to fit.
+    bool renderThumbnail(const std::vector<LWOMeshGeometry>& meshes, uint32_t size, Thumbnail& thumbnail)
+    {
+        thumbnail = Thumbnail();
+
+        // Bounding box of everything. The view is fitted to the farthest vertex from its center, so the model fills the picture from any angle.
+        float minBounds[3] = { std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max() };
+        float maxBounds[3] = { -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max() };
+        uint64_t numTriangles = 0;
+
+        for (const LWOMeshGeometry& mesh : meshes)
+        {
+            for (uint64_t i = 0; i < mesh.Positions.size(); i++)
+            {
+                minBounds[i % 3] = std::min(minBounds[i % 3], mesh.Positions[i]);
+                maxBounds[i % 3] = std::max(maxBounds[i % 3], mesh.Positions[i]);
+            }
+            numTriangles += mesh.NumTriangles();
+        }
+
+        if (size == 0 || numTriangles == 0)
+            return 0;
+
+        float center[3], radiusSquared = 0;
+        for (int i = 0; i < 3; i++)
+            center[i] = (minBounds[i] + maxBounds[i]) * 0.5f;
+
+        for (const LWOMeshGeometry& mesh : meshes)
+        {
+            for (uint64_t i = 0; i < mesh.NumVertices(); i++)
+            {
+                float dx = mesh.Positions[i * 3] - center[0], dy = mesh.Positions[i * 3 + 1] - center[1], dz = mesh.Positions[i * 3 + 2] - center[2];
+                radiusSquared = std::max(radiusSquared, dx * dx + dy * dy + dz * dz);
+            }
+        }
+
+        const float radius = std::max(std::sqrt(radiusSquared), 1e-6f);
+        const uint32_t renderSize = size * THUMBNAIL_SUPERSAMPLE;
+        const float halfSize = renderSize * 0.5f;
+        const float scale = halfSize * 0.95f / radius;
+
+        const float cosYaw = std::cos(THUMBNAIL_YAW), sinYaw = std::sin(THUMBNAIL_YAW);
+        const float cosPitch = std::cos(THUMBNAIL_PITCH), sinPitch = std::sin(THUMBNAIL_PITCH);
+
+        const float lightLength = std::sqrt(THUMBNAIL_LIGHT[0] * THUMBNAIL_LIGHT[0] + THUMBNAIL_LIGHT[1] * THUMBNAIL_LIGHT[1] + THUMBNAIL_LIGHT[2] * THUMBNAIL_LIGHT[2]);
+        const float light[3] = { THUMBNAIL_LIGHT[0] / lightLength, THUMBNAIL_LIGHT[1] / lightLength, THUMBNAIL_LIGHT[2] / lightLength };
+
+        // Model space to view space, the camera looks down -Z
+        auto rotate = [&](float x, float y, float z, float* rotated)
+        {
+            float turnedX = x * cosYaw + z * sinYaw;
+            float turnedZ = z * cosYaw - x * sinYaw;
+            rotated[0] = turnedX;
+            rotated[1] = y * cosPitch - turnedZ * sinPitch;
+            rotated[2] = y * sinPitch + turnedZ * cosPitch;
+        };
+
+        RenderTarget target(renderSize, renderSize);
+        std::vector<ScreenVertex> screenVertices;
+
+        for (const LWOMeshGeometry& mesh : meshes)
+        {
+            // Shade once per vertex, triangles only interpolate
+            screenVertices.resize(mesh.NumVertices());
+            for (uint64_t i = 0; i < mesh.NumVertices(); i++)
+            {
+                float position[3], normal[3];
+                rotate(mesh.Positions[i * 3] - center[0], mesh.Positions[i * 3 + 1] - center[1], mesh.Positions[i * 3 + 2] - center[2], position);
+                rotate(mesh.Normals[i * 3], mesh.Normals[i * 3 + 1], mesh.Normals[i * 3 + 2], normal);
+
+                float diffuse = std::max(normal[0] * light[0] + normal[1] * light[1] + normal[2] * light[2], 0.0f);
+
+                ScreenVertex& vertex = screenVertices[i];
+                vertex.X = halfSize + position[0] * scale;
+                vertex.Y = halfSize - position[1] * scale;
+                vertex.Depth = -position[2];
+                vertex.Shade = THUMBNAIL_AMBIENT + (1.0f - THUMBNAIL_AMBIENT) * diffuse;
+            }
+
+            for (uint64_t i = 0; i < mesh.NumTriangles(); i++)
+            {
+                uint32_t i0 = mesh.Indices[i * 3], i1 = mesh.Indices[i * 3 + 1], i2 = mesh.Indices[i * 3 + 2];
+                if (i0 >= screenVertices.size() || i1 >= screenVertices.size() || i2 >= screenVertices.size())
+                    continue;
+
+                rasterizeTriangle(target, screenVertices[i0], screenVertices[i1], screenVertices[i2]);
+            }
+        }
+
+        // Average each block of samples down to one pixel. Alpha is the covered fraction, luminance the average of what's covered.
+        const uint32_t samplesPerPixel = THUMBNAIL_SUPERSAMPLE * THUMBNAIL_SUPERSAMPLE;
+        thumbnail.Size = size;
+        thumbnail.Pixels.resize((size_t)size * size * 2);
+
+        for (uint32_t y = 0; y < size; y++)
+        {
+            for (uint32_t x = 0; x < size; x++)
+            {
+                uint32_t covered = 0;
+                float shade = 0;
+
+                for (uint32_t sy = 0; sy < THUMBNAIL_SUPERSAMPLE; sy++)
+                {
+                    size_t sample = (size_t)(y * THUMBNAIL_SUPERSAMPLE + sy) * target.Stride + x * THUMBNAIL_SUPERSAMPLE;
+                    for (uint32_t sx = 0; sx < THUMBNAIL_SUPERSAMPLE; sx++)
+                    {
+                        if (target.Depth[sample + sx] == std::numeric_limits<float>::infinity())
+                            continue;
+
+                        shade += target.Shade[sample + sx];
+                        covered++;
+                    }
+                }
+
+                uint8_t* pixel = thumbnail.Pixels.data() + ((size_t)y * size + x) * 2;
+                pixel[0] = covered > 0 ? (uint8_t)std::lround(std::min(std::max(shade / covered, 0.0f), 1.0f) * 255.0f) : 0;
+                pixel[1] = (uint8_t)((covered * 255 + samplesPerPixel / 2) / samplesPerPixel);
+            }
+        }
+
+        return 1;
+    }
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <vector>
+
+#include "LWODecoder.h"
+
+namespace HAYDEN
+{
+    // A small shaded picture of a model. Grey with coverage: 2 bytes per pixel (luminance, alpha), rows top to bottom.
+    struct Thumbnail
+    {
+        uint32_t Size = 0;                      // width and height
+        std::vector<uint8_t> Pixels;
+
+        bool Empty() const { return Pixels.empty(); }
+    };
+
+    // Software rasterizer, no GPU needed. Every mesh is drawn from the same 3/4 view, above and to the front left, scaled to fit.
+    // Meshes must be Y up (decoded with useYOrientation). Shading is per-vertex Lambert with a depth buffer, and the image is
+    // rendered at twice the size then averaged down, so edges are antialiased. Returns false if there's nothing to draw.
+    bool renderThumbnail(const std::vector<LWOMeshGeometry>& meshes, uint32_t size, Thumbnail& thumbnail);
+}
@@ -1,5 +1,14 @@
 #include "Utilities.h"
 
+#include <algorithm>
+
+#ifdef _WIN32
+#include <Windows.h>
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
 namespace HAYDEN
 {
     void endianSwap(uint64_t& value)
@@ -46,4 +55,104 @@ namespace HAYDEN
 #endif
         return file;
     }
+
+    // Positioned read with a 64-bit offset. Doesn't move the FILE* cursor, safe to call from multiple threads.
+    uint64_t readFileAt(FILE* f, void* dst, const uint64_t size, const uint64_t offset)
+    {
+        uint8_t* out = (uint8_t*)dst;
+        uint64_t totalRead = 0;
+
+#ifdef _WIN32
+        HANDLE fileHandle = (HANDLE)_get_osfhandle(_fileno(f));
+        while (totalRead < size)
+        {
+            OVERLAPPED overlapped = {};
+            uint64_t position = offset + totalRead;
+            overlapped.Offset = (DWORD)(position & 0xFFFFFFFF);
+            overlapped.OffsetHigh = (DWORD)(position >> 32);
+
+            DWORD chunkSize = (DWORD)std::min<uint64_t>(size - totalRead, 0x40000000);
+            DWORD bytesRead = 0;
+            if (!ReadFile(fileHandle, out + totalRead, chunkSize, &bytesRead, &overlapped) || bytesRead == 0)
+                break;
+
+            totalRead += bytesRead;
+        }
+#else
+        int fd = fileno(f);
+        while (totalRead < size)
+        {
+            ssize_t bytesRead = pread(fd, out + totalRead, size - totalRead, (off_t)(offset + totalRead));
+            if (bytesRead <= 0)
+                break;
+
+            totalRead += bytesRead;
+        }
+#endif
+        return totalRead;
+    }
+
+    // Positioned write with a 64-bit offset. Bypasses the FILE* buffer, so don't mix with fwrite on the same FILE*.
+    uint64_t writeFileAt(FILE* f, const void* src, const uint64_t size, const uint64_t offset)
+    {
+        const uint8_t* in = (const uint8_t*)src;
+        uint64_t totalWritten = 0;
+
+#ifdef _WIN32
+        HANDLE fileHandle = (HANDLE)_get_osfhandle(_fileno(f));
+        while (totalWritten < size)
+        {
+            OVERLAPPED overlapped = {};
+            uint64_t position = offset + totalWritten;
+            overlapped.Offset = (DWORD)(position & 0xFFFFFFFF);
+            overlapped.OffsetHigh = (DWORD)(position >> 32);
+
+            DWORD chunkSize = (DWORD)std::min<uint64_t>(size - totalWritten, 0x40000000);
+            DWORD bytesWritten = 0;
+            if (!WriteFile(fileHandle, in + totalWritten, chunkSize, &bytesWritten, &overlapped) || bytesWritten == 0)
+                break;
+
+            totalWritten += bytesWritten;
+        }
+#else
+        int fd = fileno(f);
+        while (totalWritten < size)
+        {
+            ssize_t bytesWritten = pwrite(fd, in + totalWritten, size - totalWritten, (off_t)(offset + totalWritten));
+            if (bytesWritten <= 0)
+                break;
+
+            totalWritten += bytesWritten;
+        }
+#endif
+        return totalWritten;
+    }
+
+    // Flushes everything written to f through to disk
+    bool syncFile(FILE* f)
+    {
+        if (fflush(f) != 0)
+            return false;
+
+#ifdef _WIN32
+        return FlushFileBuffers((HANDLE)_get_osfhandle(_fileno(f))) != 0;
+#else
+        return fsync(fileno(f)) == 0;
+#endif
+    }
+
+    // Where an archive entry named entryName goes under outputPath. False if the name would land outside outputPath ("..", etc).
+    bool getEntryOutputPath(const fs::path& outputPath, const std::string& entryName, fs::path& filePath)
+    {
+        fs::path basePath = outputPath.lexically_normal();
+        filePath = (basePath / fs::path(entryName).relative_path()).lexically_normal();
+
+        // Entry names come from the archive, a crafted one can't be trusted to stay inside the output directory
+        fs::path relativePath = filePath.lexically_relative(basePath);
+        if (relativePath.empty() || relativePath == "." || *relativePath.begin() == "..")
+            return false;
+
+        filePath.make_preferred();
+        return true;
+    }
 }
@@ -19,9 +19,21 @@ namespace HAYDEN
     uint64_t hexToInt64(const std::string hex);
     void endianSwap(uint64_t& value);
 
+    // Where an archive entry named entryName goes under outputPath. False if the name would land outside outputPath ("..", etc).
+    bool getEntryOutputPath(const fs::path& outputPath, const std::string& entryName, fs::path& filePath);
+
     // Recursive mkdir, bypassing PATH_MAX limitations on Windows
     bool mkpath(const fs::path& path);
 
     // Opens FILE* with long filepath, bypasses PATH_MAX limitations in Windows
     FILE* openLongFilePath(const fs::path& path);
+
+    // Positioned read with a 64-bit offset. Doesn't move the FILE* cursor, safe to call from multiple threads.
+    uint64_t readFileAt(FILE* f, void* dst, const uint64_t size, const uint64_t offset);
+
+    // Positioned write with a 64-bit offset. Bypasses the FILE* buffer, so don't mix with fwrite on the same FILE*.
+    uint64_t writeFileAt(FILE* f, const void* src, const uint64_t size, const uint64_t offset);
+
+    // Flushes everything written to f through to disk
+    bool syncFile(FILE* f);
 }
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+
+namespace HAYDEN
+{
+    // Fixed-capacity blocking queue for passing work between pipeline stages.
+    // Push blocks while the queue is full, Pop blocks while it's empty. Once closed, Pop drains what's left and then returns false.
+    template <typename T>
+    class BoundedQueue
+    {
+        public:
+
+            // Returns false if the queue was closed
+            bool Push(T item)
+            {
+                std::unique_lock<std::mutex> lock(_Mutex);
+                _NotFull.wait(lock, [this]() { return _Items.size() < _Capacity || _IsClosed; });
+                if (_IsClosed)
+                    return false;
+
+                _Items.push_back(std::move(item));
+                _NotEmpty.notify_one();
+                return true;
+            }
+
+            // Returns false once the queue is closed and empty
+            bool Pop(T& item)
+            {
+                std::unique_lock<std::mutex> lock(_Mutex);
+                _NotEmpty.wait(lock, [this]() { return !_Items.empty() || _IsClosed; });
+                if (_Items.empty())
+                    return false;
+
+                item = std::move(_Items.front());
+                _Items.pop_front();
+                _NotFull.notify_one();
+                return true;
+            }
+
+            // Wakes up all waiting threads, no more items can be pushed after this
+            void Close()
+            {
+                std::lock_guard<std::mutex> lock(_Mutex);
+                _IsClosed = 1;
+                _NotEmpty.notify_all();
+                _NotFull.notify_all();
+            }
+
+            BoundedQueue(size_t capacity) : _Capacity(capacity) {}
+            BoundedQueue(const BoundedQueue&) = delete;
+            BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+        private:
+            std::mutex _Mutex;
+            std::condition_variable _NotEmpty;
+            std::condition_variable _NotFull;
+            std::deque<T> _Items;
+            size_t _Capacity = 0;
+            bool _IsClosed = 0;
+    };
+}
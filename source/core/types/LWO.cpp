@@ -1,171 +1,91 @@
 #include "LWO.h"
 
+#include <algorithm>
+#include <cstring>
+
 namespace HAYDEN
 {
     // Get unpacked geometry from OBJ file
-    LWO_GEO_UNPACKED::LWO_GEO_UNPACKED(OBJFile objFile, bool useYOrientation)
+    LWO_GEO_UNPACKED::LWO_GEO_UNPACKED(const OBJFile& objFile, bool useYOrientation)
     {
-        // read verts for each object - store sequentially
-        for (int i = 0; i < objFile.Objects.size(); i++)
+        // read verts for all objects - already stored sequentially
+        Vertices.resize(objFile.NumVertices());
+        for (uint64_t i = 0; i < Vertices.size(); i++)
         {
-            for (int j = 0; j < objFile.Objects[i].Vertices.size(); j++)
-            {
-                LWO_VERTEX vertex;
-                std::string thisLine = objFile.Objects[i].Vertices[j];
-                size_t sep;
-
-                // get z
-                sep = thisLine.rfind(" ");
-                std::string zString = thisLine.substr(sep + 1, thisLine.length() - (sep + 1));
-
-                // get y
-                thisLine = thisLine.substr(0, sep);
-                sep = thisLine.rfind(" ");
-                std::string yString = thisLine.substr(sep + 1, thisLine.length() - (sep + 1));
-
-                // get x
-                thisLine = thisLine.substr(0, sep);
-                sep = thisLine.rfind(" ");
-                std::string xString = thisLine.substr(sep + 1, thisLine.length() - (sep + 1));
-
-                // populate vert
-                if (!useYOrientation)
-                {
-                    vertex.x = std::stof(xString);
-                    vertex.y = std::stof(yString);
-                    vertex.z = std::stof(zString);
-                }
-                else
-                {
-                    vertex.x = std::stof(xString);
-                    vertex.z = std::stof(yString);
-                    vertex.y = -(std::stof(zString));
-                }
+            const float_t* position = &objFile.Positions[i * 3];
+            LWO_VERTEX& vertex = Vertices[i];
 
-                Vertices.push_back(vertex);
+            // populate vert
+            if (!useYOrientation)
+            {
+                vertex.x = position[0];
+                vertex.y = position[1];
+                vertex.z = position[2];
             }
-        }
-
-        // read UVs for each object - store sequentially
-        for (int i = 0; i < objFile.Objects.size(); i++)
-        {
-            for (int j = 0; j < objFile.Objects[i].UVs.size(); j++)
+            else
             {
-                LWO_UV uv;
-                std::string thisLine = objFile.Objects[i].UVs[j];
-                size_t sep;
-
-                // get v
-                sep = thisLine.rfind(" ");
-                std::string vString = thisLine.substr(sep + 1, thisLine.length() - (sep + 1));
-
-                // get u
-                thisLine = thisLine.substr(0, sep);
-                sep = thisLine.rfind(" ");
-                std::string uString = thisLine.substr(sep + 1, thisLine.length() - (sep + 1));
-
-                // populate UV
-                uv.u = std::stof(uString);
-                uv.v = std::stof(vString);
-
-                UVs.push_back(uv);
+                vertex.x = position[0];
+                vertex.z = position[1];
+                vertex.y = -position[2];
             }
         }
 
-        // read Normals for each object - store sequentially
-        for (int i = 0; i < objFile.Objects.size(); i++)
+        // read UVs
+        UVs.resize(objFile.NumUVs());
+        for (uint64_t i = 0; i < UVs.size(); i++)
         {
-            for (int j = 0; j < objFile.Objects[i].Normals.size(); j++)
-            {
-                LWO_NORMAL normal;
-                std::string thisLine = objFile.Objects[i].Normals[j];
-                size_t sep;
-
-                // get z
-                sep = thisLine.rfind(" ");
-                std::string zString = thisLine.substr(sep + 1, thisLine.length() - (sep + 1));
-
-                // get y
-                thisLine = thisLine.substr(0, sep);
-                sep = thisLine.rfind(" ");
-                std::string yString = thisLine.substr(sep + 1, thisLine.length() - (sep + 1));
-
-                // get x
-                thisLine = thisLine.substr(0, sep);
-                sep = thisLine.rfind(" ");
-                std::string xString = thisLine.substr(sep + 1, thisLine.length() - (sep + 1));
-
-                // populate normal
-                if (!useYOrientation)
-                {
-                    normal.xn = std::stof(xString);
-                    normal.yn = std::stof(yString);
-                    normal.zn = std::stof(zString);
-                }
-                else
-                {
-                    normal.xn = std::stof(xString);
-                    normal.zn = std::stof(yString);
-                    normal.yn = -(std::stof(zString));
-                }
-
-                Normals.push_back(normal);
-            }
+            UVs[i].u = objFile.UVs[i * 2];
+            UVs[i].v = objFile.UVs[i * 2 + 1];
         }
 
-        // read Faces for each object / store sequentially
-        for (int i = 0; i < objFile.Objects.size(); i++)
+        // read Normals
+        Normals.resize(objFile.NumNormals());
+        for (uint64_t i = 0; i < Normals.size(); i++)
         {
-            for (int j = 0; j < objFile.Objects[i].Faces.size(); j++)
+            const float_t* objNormal = &objFile.Normals[i * 3];
+            LWO_NORMAL& normal = Normals[i];
+
+            // populate normal
+            if (!useYOrientation)
+            {
+                normal.xn = objNormal[0];
+                normal.yn = objNormal[1];
+                normal.zn = objNormal[2];
+            }
+            else
             {
-                LWO_FACE_GROUP face;
-                std::string thisLine = objFile.Objects[i].Faces[j];
-                size_t sep;
-                size_t sep2;
-
-                // get f3
-                sep = thisLine.rfind(" ");
-                std::string f3String = thisLine.substr(sep + 1, thisLine.length() - (sep + 1));
-                sep2 = f3String.rfind("/");
-                f3String = f3String.substr(sep2 + 1, f3String.length() - (sep2 + 1));
-
-                // get f1
-                thisLine = thisLine.substr(0, sep);
-                sep = thisLine.rfind(" ");
-                std::string f1String = thisLine.substr(sep + 1, thisLine.length() - (sep + 1));
-                sep2 = f1String.rfind("/");
-                f1String = f1String.substr(sep2 + 1, f1String.length() - (sep2 + 1));
-
-                // get f2
-                thisLine = thisLine.substr(0, sep);
-                sep = thisLine.rfind(" ");
-                std::string f2String = thisLine.substr(sep + 1, thisLine.length() - (sep + 1));
-                sep2 = f2String.rfind("/");
-                f2String = f2String.substr(sep2 + 1, f2String.length() - (sep2 + 1));
-
-                // populate normal
-                face.f3 = std::stoi(f1String) - 1; // 0 indexed
-                face.f1 = std::stoi(f2String) - 1;
-                face.f2 = std::stoi(f3String) - 1;
-
-                Faces.push_back(face);
+                normal.xn = objNormal[0];
+                normal.zn = objNormal[1];
+                normal.yn = -objNormal[2];
             }
         }
 
-        // colors
-        for (int i = 0; i < objFile.Objects.size(); i++)
+        // read Faces. vendor/obj writes the same index for position, UV and normal, the last one given is used.
+        auto cornerIndex = [](const OBJFaceCorner& corner) -> uint16_t
         {
-            for (int j = 0; j < objFile.Objects[i].Vertices.size(); j++)
-            {
-                LWO_COLORS colorsTmp;
-                Colors.push_back(colorsTmp);
-            }
+            if (corner.Normal != -1)
+                return corner.Normal;
+            if (corner.UV != -1)
+                return corner.UV;
+            return corner.Position;
+        };
+
+        Faces.resize(objFile.Faces.size());
+        for (uint64_t i = 0; i < Faces.size(); i++)
+        {
+            const OBJFace& objFace = objFile.Faces[i];
+
+            // The game winds faces the other way
+            Faces[i].f1 = cornerIndex(objFace.Corners[0]);
+            Faces[i].f2 = cornerIndex(objFace.Corners[2]);
+            Faces[i].f3 = cornerIndex(objFace.Corners[1]);
         }
 
-        return;
+        // colors
+        Colors.resize(Vertices.size());
     }
 
-    void LWO_GEO_PACKED::PackGeometry(LWO_GEO_UNPACKED geo, float_t minX, float_t minY, float_t minZ, float_t minU, float_t minV, float_t scale)
+    void LWO_GEO_PACKED::PackGeometry(const LWO_GEO_UNPACKED& geo, float_t minX, float_t minY, float_t minZ, float_t minU, float_t minV, float_t scale)
     {
         for (int i = 0; i < geo.Vertices.size(); i++)
         {
@@ -210,81 +130,177 @@ namespace HAYDEN
         return;
     };
 
+    // fread for a memory buffer. Anything past the end of the buffer reads as zero.
+    static void readData(const std::vector<uint8_t>& data, uint64_t& offset, void* dst, const uint64_t size)
+    {
+        uint64_t available = offset < data.size() ? std::min<uint64_t>(size, data.size() - offset) : 0;
+        if (available > 0)
+            memcpy(dst, data.data() + offset, available);
+
+        if (available < size)
+            memset((uint8_t*)dst + available, 0, size - available);
+
+        offset += available;
+    }
+
     void LWO::Serialize(fs::path modelPath)
     {
         std::string modelPathStr = modelPath.string();
 
         FILE* f = fopen(modelPathStr.c_str(), "rb");
-        if (f != NULL)
+        if (f == NULL)
+            return;
+
+        std::vector<uint8_t> data;
+        fseek(f, 0, SEEK_END);
+        data.resize(ftell(f));
+        fseek(f, 0, SEEK_SET);
+
+        data.resize(fread(data.data(), 1, data.size(), f));
+        fclose(f);
+
+        Serialize(data);
+    }
+
+    void LWO::Serialize(const std::vector<uint8_t>& data)
+    {
+        uint64_t offset = 0;
+        StreamInfoOffset = 0;
+
+        // Read number of meshes
+        readData(data, offset, &Header, sizeof(LWO_HEADER));
+        MeshData.resize(Header.NumMeshes);
+
+        // Determine BMLr type & count
+        if (Header.UnkHash == 0)
         {
-            // Read number of meshes
-            fread(&Header, sizeof(LWO_HEADER), 1, f);
-            MeshData.resize(Header.NumMeshes);
+            this->bmlCount = 1;
+            this->useExtendedBML = 1;
+        }
+        else
+        {
+            this->bmlCount = 3;
+            this->useExtendedBML = 0;
+        }
 
-            // Determine BMLr type & count
-            if (Header.UnkHash == 0)
-            {
-                this->bmlCount = 1;
-                this->useExtendedBML = 1;
-            }
-            else
-            {
-                this->bmlCount = 3;
-                this->useExtendedBML = 0;
-            }
+        if (Header.NullPad32_2 != 0)
+        {
+            return;
+        }
+
+        // Read mesh and material info
+        for (int i = 0; i < Header.NumMeshes; i++)
+        {
+            readData(data, offset, &MeshData[i].MeshHeader, sizeof(LWO_MESH_HEADER));
+
+            int strLen = MeshData[i].MeshHeader.DeclStrlen;
 
-            if (Header.NullPad32_2 != 0)
+            if (strLen < 0 || strLen > 1024)
             {
                 return;
             }
 
-            // Read mesh and material info
-            for (int i = 0; i < Header.NumMeshes; i++)
-            {
-                fread(&MeshData[i].MeshHeader, sizeof(LWO_MESH_HEADER), 1, f);
+            MeshData[i].MaterialDeclName.resize(strLen);
+
+            readData(data, offset, &MeshData[i].MaterialDeclName[0], strLen);
+            readData(data, offset, &MeshData[i].MeshFooter, sizeof(LWO_MESH_FOOTER));
 
-                int strLen = MeshData[i].MeshHeader.DeclStrlen;
+            // Read BMLr data (level-of-detail info for each mesh)
+            MeshData[i].BMLHeaders.resize(bmlCount);
 
-                if (strLen < 0 || strLen > 1024)
+            for (int j = 0; j < bmlCount; j++)
+            {
+                readData(data, offset, &MeshData[i].BMLHeaders[j], sizeof(LWO_BML_HEADER));
+
+                // No idea what these are for
+                if (this->useExtendedBML)
                 {
-                    return;
+                    readData(data, offset, &MeshData[i].unkTuple[0], sizeof(uint32_t));
+                    readData(data, offset, &MeshData[i].unkTuple[1], sizeof(uint32_t));
                 }
+            }
+        }
 
-                MeshData[i].MaterialDeclName.resize(strLen);
+        // Read LWO Settings
+        readData(data, offset, &LWOSettings, sizeof(LWO_SETTINGS));
+        StreamInfoOffset = offset;
 
-                fread(&MeshData[i].MaterialDeclName[0], strLen, 1, f);
-                fread(&MeshData[i].MeshFooter, sizeof(LWO_MESH_FOOTER), 1, f);
+        // Fill in defaults, our custom LWO models won't use these, but some native models in the game do.
+        MeshStrlen = 0;
+        Num32ByteChunks = 0;
 
-                // Read BMLr data (level-of-detail info for each mesh)
-                MeshData[i].BMLHeaders.resize(bmlCount);
+        // There will always be 5 of these.
+        LWOStreamDBHeaders.resize(5);
+        LWOStreamDBData.resize(5);
+        LWOGeoStreamDiskLayout.resize(5);
+    }
 
-                for (int j = 0; j < bmlCount; j++)
-                {
-                    fread(&MeshData[i].BMLHeaders[j], sizeof(LWO_BML_HEADER), 1, f);
-
-                    // No idea what these are for
-                    if (this->useExtendedBML)
-                    {
-                        fread(&MeshData[i].unkTuple[0], sizeof(uint32_t), 1, f);
-                        fread(&MeshData[i].unkTuple[1], sizeof(uint32_t), 1, f);
-                    }
-                }
-            }
+    bool LWO::SerializeStreamInfo(const std::vector<uint8_t>& data)
+    {
+        uint64_t offset = StreamInfoOffset;
 
-            // Read LWO Settings
-            fread(&LWOSettings, sizeof(LWO_SETTINGS), 1, f);
+        // Serialize gave up early, or there's a section after LWO Settings that we don't know the layout of
+        if (StreamInfoOffset == 0 || LWOSettings.unkFileID != 0)
+            return 0;
 
-            // Fill in defaults, our custom LWO models won't use these, but some native models in the game do.
-            MeshStrlen = 0;
-            Num32ByteChunks = 0;
+        // Unknown 32 byte chunks, kept so the offsets below line up
+        readData(data, offset, &Num32ByteChunks, sizeof(uint32_t));
+        if (Num32ByteChunks > (data.size() - std::min<uint64_t>(offset, data.size())) / sizeof(UNK_32_CHUNK))
+            return 0;
 
-            // There will always be 5 of these.
-            LWOStreamDBHeaders.resize(5);
-            LWOStreamDBData.resize(5);
-            LWOGeoStreamDiskLayout.resize(5);
+        UnkChunkData.resize(Num32ByteChunks);
+        for (uint32_t i = 0; i < Num32ByteChunks; i++)
+            readData(data, offset, &UnkChunkData[i], sizeof(UNK_32_CHUNK));
 
-            fclose(f);
-        }       
-        return;
+        readData(data, offset, &MeshStrlen, sizeof(uint32_t));
+        if (MeshStrlen > 1024)
+            return 0;
+
+        MeshName.resize(MeshStrlen);
+        readData(data, offset, &MeshName[0], MeshStrlen);
+        readData(data, offset, &LWOSettings2, sizeof(LWO_SETTINGS_2));
+
+        // 5 streamdb headers. NumOffsets == 5 means a UV lightmap and the alternate format, copied to the standard format here.
+        LWOStreamDBHeaders.resize(5);
+        LWOStreamDBData.resize(5);
+        LWOStreamDBData_124.resize(5);
+        LWOGeoStreamDiskLayout.resize(5);
+
+        for (int i = 0; i < 5; i++)
+        {
+            readData(data, offset, &LWOStreamDBHeaders[i], sizeof(LWO_STREAMDB_HEADER));
+
+            if (LWOStreamDBHeaders[i].NumOffsets == 5)
+            {
+                LWO_STREAMDB_DATA_VARIANT& variant = LWOStreamDBData_124[i];
+                readData(data, offset, &variant, sizeof(LWO_STREAMDB_DATA_VARIANT));
+
+                LWOStreamDBData[i].unkNormalInt = variant.unkNormalInt;
+                LWOStreamDBData[i].unkUVInt = variant.unkUVInt;
+                LWOStreamDBData[i].unkColorInt = variant.unkColorInt;
+                LWOStreamDBData[i].unkFacesInt = variant.unkFacesInt;
+                LWOStreamDBData[i].unkInt99 = variant.unkInt99;
+                LWOStreamDBData[i].LOD_NormalStartOffset = variant.LOD_NormalStartOffset;
+                LWOStreamDBData[i].LOD_UVStartOffset = variant.LOD_UVStartOffset;
+                LWOStreamDBData[i].LOD_ColorStartOffset = variant.LOD_ColorStartOffset;
+                LWOStreamDBData[i].LOD_FacesStartOffset = variant.LOD_FacesStartOffset;
+
+                LWOGeoStreamDiskLayout[i].StreamCompressionType = variant.StreamCompressionType;
+                LWOGeoStreamDiskLayout[i].decompressedSize = variant.decompressedSize;
+                LWOGeoStreamDiskLayout[i].compressedSize = variant.compressedSize;
+                LWOGeoStreamDiskLayout[i].cumulativeStreamDBCompSize = variant.cumulativeStreamDBCompSize;
+            }
+            else if (LWOStreamDBHeaders[i].NumOffsets == 4)
+            {
+                readData(data, offset, &LWOStreamDBData[i], sizeof(LWO_STREAMDB_DATA));
+                readData(data, offset, &LWOGeoStreamDiskLayout[i], sizeof(LWO_GEOMETRY_STREAMDISK_LAYOUT));
+            }
+            else
+            {
+                return 0;
+            }
+        }
+
+        return offset <= data.size();
     }
 }
@@ -191,6 +191,10 @@ namespace HAYDEN
         uint32_t LOD_FacesStartOffset = 0;
     };
 
+    // LWO_GEOMETRY_STREAMDISK_LAYOUT::StreamCompressionType
+    const uint32_t STREAM_COMPRESSION_NONE_MODEL = 3;
+    const uint32_t STREAM_COMPRESSION_KRAKEN_MODEL = 4;
+
     struct LWO_GEOMETRY_STREAMDISK_LAYOUT
     {
         uint32_t StreamCompressionType = 3;        // 3 = NONE_MODEL, 4 = KRAKEN_MODEL
@@ -226,7 +230,7 @@ namespace HAYDEN
             std::vector<LWO_UV> UVs;
             std::vector<LWO_COLORS> Colors;
             std::vector<LWO_FACE_GROUP> Faces;
-            LWO_GEO_UNPACKED (OBJFile objFile, bool useYOrientation);
+            LWO_GEO_UNPACKED(const OBJFile& objFile, bool useYOrientation);
     };
 
     class LWO_GEO_PACKED
@@ -237,7 +241,7 @@ namespace HAYDEN
             std::vector<LWO_UV_PACKED> UVs;
             std::vector<LWO_COLORS> Colors;
             std::vector<LWO_FACE_GROUP> Faces;
-            void PackGeometry(LWO_GEO_UNPACKED geometry, float_t minX, float_t minY, float_t minZ, float_t minU, float_t minV, float_t scale);
+            void PackGeometry(const LWO_GEO_UNPACKED& geometry, float_t minX, float_t minY, float_t minZ, float_t minU, float_t minV, float_t scale);
     };
 
     class LWO
@@ -271,8 +275,16 @@ namespace HAYDEN
             bool useExtendedBML = 0;
             uint32_t Num32ByteChunks = 0;
 
+            // Where Serialize stopped reading, the stream info starts here
+            uint64_t StreamInfoOffset = 0;
+
             // Constructor
             void Serialize(fs::path modelPath);
+            void Serialize(const std::vector<uint8_t>& data);
+
+            // Reads the real stream info (LWOSettings2 and the streamdb headers) instead of the defaults Serialize fills in.
+            // Call after Serialize, with the same data. Returns false for layouts we don't know how to read.
+            bool SerializeStreamInfo(const std::vector<uint8_t>& data);
     };
 }
 
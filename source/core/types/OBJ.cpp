@@ -1,147 +1,275 @@
 #include "OBJ.h"
 
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <string_view>
+
+#include "../MappedFile.h"
+
 namespace HAYDEN
 {
-    OBJFile::OBJFile(fs::path modelPath)
+    // One line of the file, without its line ending, and a cursor into it
+    struct OBJLine
     {
-        std::ifstream modelFile(modelPath);
-        if (modelFile.is_open())
+        const char* Position = NULL;
+        const char* End = NULL;
+
+        void SkipSpaces()
         {
-            std::stringstream inputStream;
-            inputStream << modelFile.rdbuf();
+            while (Position < End && (*Position == ' ' || *Position == '\t'))
+                Position++;
+        }
 
-            std::string line;
-            std::vector<std::string> lines;
-            size_t splitPos = 0;
+        // Up to the next space, without copying
+        std::string_view NextToken()
+        {
+            SkipSpaces();
+            const char* tokenStart = Position;
+            while (Position < End && *Position != ' ' && *Position != '\t')
+                Position++;
 
-            while (std::getline(inputStream, line))
-            {
-                // find the first empty space
-                if (line.length() <= 1)
-                    continue;
+            return std::string_view(tokenStart, Position - tokenStart);
+        }
 
-                OBJSingleLine thisLine;
-                splitPos = line.find(" ");
+        // Decimal or exponent notation. from_chars doesn't take a leading '+', exporters sometimes write one.
+        bool NextFloat(float_t& value)
+        {
+            SkipSpaces();
+            if (Position < End && *Position == '+')
+                Position++;
 
-                // skip empty lines
-                if (splitPos == -1)
-                    continue;
+            auto result = std::from_chars(Position, End, value);
+            if (result.ec != std::errc())
+                return false;
 
-                std::string lineStart = line.substr(0, splitPos);
-                thisLine.lineType = OBJLineType::DEFAULT;
+            Position = result.ptr;
+            return Position == End || *Position == ' ' || *Position == '\t';
+        }
+    };
 
-                if (lineStart == "#")
-                    thisLine.lineType = OBJLineType::COMMENT;
+    // Splits data into lines. Returns false once there are none left.
+    static bool nextLine(const char*& data, const char* dataEnd, OBJLine& line)
+    {
+        if (data >= dataEnd)
+            return false;
 
-                if (lineStart == "mtllib")
-                    thisLine.lineType = OBJLineType::MTLLIB;
+        const char* lineEnd = (const char*)memchr(data, '\n', dataEnd - data);
+        if (lineEnd == NULL)
+            lineEnd = dataEnd;
 
-                if (lineStart == "o")
-                    thisLine.lineType = OBJLineType::OBJECT;
+        line.Position = data;
+        line.End = lineEnd;
+        data = lineEnd < dataEnd ? lineEnd + 1 : dataEnd;
 
-                if (lineStart == "v")
-                    thisLine.lineType = OBJLineType::VERTEX;
+        // CRLF files
+        if (line.End > line.Position && line.End[-1] == '\r')
+            line.End--;
 
-                if (lineStart == "vt")
-                    thisLine.lineType = OBJLineType::UV;
+        return true;
+    }
 
-                if (lineStart == "vn")
-                    thisLine.lineType = OBJLineType::NORMAL;
+    // "v", "v/vt", "v//vn" or "v/vt/vn". Negative indexes count back from the last element read so far.
+    static bool parseFaceIndex(std::string_view& token, uint64_t count, int32_t& index)
+    {
+        int64_t value = 0;
+        auto result = std::from_chars(token.data(), token.data() + token.size(), value);
+        if (result.ec != std::errc() || value == 0)
+            return false;
 
-                if (lineStart == "f")
-                    thisLine.lineType = OBJLineType::FACE;
+        value = value > 0 ? value - 1 : (int64_t)count + value;
+        if (value < 0 || value > INT32_MAX)
+            return false;
 
-                if (lineStart == "g")
-                    thisLine.lineType = OBJLineType::G;
+        index = (int32_t)value;
+        token.remove_prefix(result.ptr - token.data());
+        return true;
+    }
 
-                if (lineStart == "usemtl")
-                    thisLine.lineType = OBJLineType::USEMTL;
+    static bool parseFaceCorner(std::string_view token, const OBJFile& objFile, OBJFaceCorner& corner)
+    {
+        if (!parseFaceIndex(token, objFile.NumVertices(), corner.Position))
+            return false;
 
-                // skip smooth groups - causes assertion error in vendor/obj
-                if (lineStart == "s")
-                    continue;
+        if (token.empty())
+            return true;
 
-                // skip anything else we don't recognize
-                if (thisLine.lineType == OBJLineType::DEFAULT)
-                    continue;
+        if (token[0] != '/')
+            return false;
+        token.remove_prefix(1);
 
-                thisLine.lineData = std::string(line);
-                Lines.push_back(thisLine);
-            }
+        if (!token.empty() && token[0] != '/' && !parseFaceIndex(token, objFile.NumUVs(), corner.UV))
+            return false;
+
+        if (token.empty())
+            return true;
+
+        if (token[0] != '/')
+            return false;
+        token.remove_prefix(1);
+
+        return parseFaceIndex(token, objFile.NumNormals(), corner.Normal) && token.empty();
+    }
+
+    OBJFile::OBJFile(fs::path modelPath)
+    {
+        MappedFile modelFile;
+        if (modelFile.Open(modelPath))
+        {
+            _IsLoaded = Parse((const char*)modelFile.Data(), modelFile.Size());
+            return;
         }
-        modelFile.close();
 
-        // Find all objects
-        for (int i = 0; i < Lines.size(); i++)
+        // An empty file doesn't map, but it's a valid (empty) OBJ
+        std::error_code ec;
+        if (fs::is_regular_file(modelPath, ec) && fs::file_size(modelPath, ec) == 0 && !ec)
+            _IsLoaded = Parse(NULL, 0);
+    }
+
+    OBJFile::OBJFile(const char* data, uint64_t size)
+    {
+        _IsLoaded = Parse(data, size);
+    }
+
+    bool OBJFile::Parse(const char* data, uint64_t size)
+    {
+        const char* dataEnd = data + size;
+        uint64_t lineNumber = 0;
+        OBJLine line;
+
+        auto endObject = [this]()
         {
-            if (Lines[i].lineType == OBJLineType::OBJECT)
+            if (Objects.empty())
+                return;
+
+            OBJFile_Object& object = Objects.back();
+            object.NumVertices = NumVertices() - object.FirstVertex;
+            object.NumFaces = Faces.size() - object.FirstFace;
+        };
+
+        while (nextLine(data, dataEnd, line))
+        {
+            lineNumber++;
+            std::string_view lineType = line.NextToken();
+            bool isParsed = 1;
+
+            if (lineType == "v")
             {
-                OBJFile_Object newObject;
-                newObject.StartLine = i + 1;
-                newObject.ObjectName = Lines[i].lineData.substr(2, Lines[i].lineData.length());
-                Objects.push_back(newObject);
+                // Anything after z (w, or vertex colors) isn't used
+                float_t x = 0, y = 0, z = 0;
+                isParsed = line.NextFloat(x) && line.NextFloat(y) && line.NextFloat(z);
+                Positions.insert(Positions.end(), { x, y, z });
+            }
+            else if (lineType == "vt")
+            {
+                // v is optional, and w is never used
+                float_t u = 0, v = 0;
+                isParsed = line.NextFloat(u);
+                line.SkipSpaces();
+                if (isParsed && line.Position < line.End)
+                    isParsed = line.NextFloat(v);
 
-                // Set previous object end line
-                if (Objects.size() >= 2)
+                UVs.insert(UVs.end(), { u, v });
+            }
+            else if (lineType == "vn")
+            {
+                float_t x = 0, y = 0, z = 0;
+                isParsed = line.NextFloat(x) && line.NextFloat(y) && line.NextFloat(z);
+                Normals.insert(Normals.end(), { x, y, z });
+            }
+            else if (lineType == "f")
+            {
+                OBJFace face;
+                uint32_t numCorners = 0;
+
+                for (std::string_view token = line.NextToken(); isParsed && !token.empty(); token = line.NextToken())
                 {
-                    int64_t numObjects = Objects.size();
-                    Objects[numObjects - 2].EndLine = i;
+                    OBJFaceCorner corner;
+                    isParsed = parseFaceCorner(token, *this, corner);
+
+                    // Fan out from the first corner
+                    if (numCorners >= 3)
+                    {
+                        face.Corners[1] = face.Corners[2];
+                        face.Corners[2] = corner;
+                    }
+                    else
+                    {
+                        face.Corners[numCorners] = corner;
+                    }
+
+                    if (++numCorners >= 3)
+                        Faces.push_back(face);
                 }
+
+                isParsed = isParsed && numCorners >= 3;
+            }
+            else if (lineType == "o")
+            {
+                endObject();
+
+                // Geometry before the first "o" line goes with the first object
+                OBJFile_Object object;
+                line.SkipSpaces();
+                object.ObjectName = std::string(line.Position, line.End - line.Position);
+                object.FirstVertex = Objects.empty() ? 0 : NumVertices();
+                object.FirstFace = Objects.empty() ? 0 : Faces.size();
+                Objects.push_back(object);
+            }
+
+            if (!isParsed)
+            {
+                _ErrorLine = lineNumber;
+                return false;
             }
         }
 
         // If no objects are defined, create one called "Default"
-        if (Objects.size() == 0)
+        if (Objects.empty())
         {
-            OBJFile_Object newObject;
-            newObject.StartLine = 1;
-            newObject.ObjectName = "Default";
-            Objects.push_back(newObject);
+            OBJFile_Object object;
+            object.ObjectName = "Default";
+            Objects.push_back(object);
         }
 
-        // Set last object endline
-        int64_t numObjects = Objects.size();
-        Objects[numObjects - 1].EndLine = Lines.size();
+        endObject();
+        return true;
+    }
+
+    bool OBJFile::ReadSanitized(const fs::path& modelPath, std::vector<uint8_t>& sanitizedOBJ)
+    {
+        static const std::string_view keptLineTypes[] = { "#", "mtllib", "o", "v", "vt", "vn", "f", "g", "usemtl" };
 
-        // Split all lines into their respective objects
-        for (int i = 0; i < numObjects; i++)
+        sanitizedOBJ.clear();
+
+        MappedFile modelFile;
+        if (!modelFile.Open(modelPath))
         {
-            for (int j = Objects[i].StartLine; j < Objects[i].EndLine; j++)
-                Objects[i].OBJLineData.push_back(Lines[j]);
+            std::error_code ec;
+            return fs::is_regular_file(modelPath, ec) && fs::file_size(modelPath, ec) == 0 && !ec;
         }
 
-        // Read line data into each object
-        for (int i = 0; i < numObjects; i++)
+        const char* data = (const char*)modelFile.Data();
+        const char* dataEnd = data + modelFile.Size();
+        sanitizedOBJ.reserve(modelFile.Size());
+        OBJLine line;
+
+        while (nextLine(data, dataEnd, line))
         {
-            for (int j = 0; j < Objects[i].OBJLineData.size(); j++)
-            {
-                OBJLineType thisType = Objects[i].OBJLineData[j].lineType;
-                std::string thisLine = Objects[i].OBJLineData[j].lineData;
+            // The line type is everything before the first space, lines without one are dropped
+            const char* lineStart = line.Position;
+            const char* space = (const char*)memchr(lineStart, ' ', line.End - lineStart);
+            if (line.End - lineStart <= 1 || space == NULL)
+                continue;
 
-                switch (thisType)
-                {
-                    case OBJLineType::VERTEX:
-                        Objects[i].Vertices.push_back(thisLine);
-                        break;
-                    case OBJLineType::UV:
-                        Objects[i].UVs.push_back(thisLine);
-                        break;
-                    case OBJLineType::NORMAL:
-                        Objects[i].Normals.push_back(thisLine);
-                        break;
-                    case OBJLineType::FACE:
-                        Objects[i].Faces.push_back(thisLine);
-                        break;
-                    case OBJLineType::USEMTL:
-                        Objects[i].UseMaterialLine = thisLine;
-                        break;
-                    case OBJLineType::G:
-                        Objects[i].GLine = thisLine;
-                        break;
-                    default:
-                        break;
-                }
-            }    
+            std::string_view lineType(lineStart, space - lineStart);
+            if (std::find(std::begin(keptLineTypes), std::end(keptLineTypes), lineType) == std::end(keptLineTypes))
+                continue;
+
+            sanitizedOBJ.insert(sanitizedOBJ.end(), lineStart, line.End);
+            sanitizedOBJ.push_back('\n');
         }
+
+        return true;
     }
 }
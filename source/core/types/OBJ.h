@@ -2,58 +2,67 @@
 
 #include <string>
 #include <vector>
-#include <iomanip>
 #include <filesystem>
-#include <fstream>
-#include <sstream>
-#include <locale> // std::isalpha
+#include <cmath>
 
 namespace fs = std::filesystem;
 
 namespace HAYDEN
 {
-    enum class OBJLineType
+    // One corner of a face, 0 indexed. -1 if the face line didn't give it.
+    struct OBJFaceCorner
     {
-        DEFAULT = 0,
-        MTLLIB = 1,
-        OBJECT = 2,
-        VERTEX = 3,
-        UV = 4,
-        NORMAL = 5,
-        FACE = 6,
-        G = 7,
-        USEMTL = 8,
-        COMMENT = 9
+        int32_t Position = -1;
+        int32_t UV = -1;
+        int32_t Normal = -1;
     };
 
-    struct OBJSingleLine
+    // Faces with more than 3 corners are split into a fan of triangles
+    struct OBJFace
     {
-        OBJLineType lineType = OBJLineType::DEFAULT;
-        std::string lineData;
+        OBJFaceCorner Corners[3];
     };
 
+    // An "o" line, and everything up to the next one
     struct OBJFile_Object
     {
-        int StartLine = 0;
-        int EndLine = 0;
-
         std::string ObjectName;
-        std::vector<std::string> Vertices;
-        std::vector<std::string> Normals;
-        std::vector<std::string> UVs;
-        std::string GLine;
-        std::string UseMaterialLine;
-        std::vector<std::string> Faces;
-        std::vector<OBJSingleLine> OBJLineData;
+        uint64_t FirstVertex = 0;
+        uint64_t NumVertices = 0;
+        uint64_t FirstFace = 0;
+        uint64_t NumFaces = 0;
     };
 
+    // Geometry of an OBJ, parsed in one pass over the mapped file straight into numbers.
+    // Arrays hold every object back to back, in file order. Lines other than v, vt, vn, f and o are skipped.
     class OBJFile
     {
         public:
-            std::string SignatureLine;
-            std::string MaterialLine;
-            std::vector<OBJFile_Object> Objects;
-            std::vector<OBJSingleLine> Lines;
+            std::vector<OBJFile_Object> Objects;        // "Default" if the file has no "o" lines
+            std::vector<float_t> Positions;             // x, y, z per vertex
+            std::vector<float_t> UVs;                   // u, v per UV
+            std::vector<float_t> Normals;               // x, y, z per normal
+            std::vector<OBJFace> Faces;
+
             OBJFile(fs::path modelPath);
+            OBJFile(const char* data, uint64_t size);
+
+            // False if the file couldn't be read, or a line didn't parse. ErrorLine is the first line that didn't (1 based).
+            bool IsLoaded() const { return _IsLoaded; }
+            uint64_t ErrorLine() const { return _ErrorLine; }
+
+            uint64_t NumVertices() const { return Positions.size() / 3; }
+            uint64_t NumUVs() const { return UVs.size() / 2; }
+            uint64_t NumNormals() const { return Normals.size() / 3; }
+
+            // The lines vendor/obj can handle, as text: comments, mtllib, o, v, vt, vn, f, g and usemtl.
+            // Smoothing groups and anything unrecognized are dropped, they cause assertion errors in vendor/obj.
+            static bool ReadSanitized(const fs::path& modelPath, std::vector<uint8_t>& sanitizedOBJ);
+
+        private:
+            bool _IsLoaded = 0;
+            uint64_t _ErrorLine = 0;
+
+            bool Parse(const char* data, uint64_t size);
     };
 }
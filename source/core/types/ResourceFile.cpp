@@ -1,59 +1,130 @@
 #include "ResourceFile.h"
 
+#include <algorithm>
+
+#include "../Utilities.h"
+
 namespace HAYDEN
 {
     // Reads binary .resources file from local filesystem
     ResourceFile::ResourceFile(const fs::path& filePath)
     {
         FilePath = filePath.string();
-        FILE* f = fopen(FilePath.c_str(), "rb");
-        if (f == NULL)
+
+        // Map the whole file - the index is then used in place, with no per-entry reads or copies
+        if (_MappedFile.Open(filePath))
+        {
+            _Data = _MappedFile.Data();
+            _DataSize = _MappedFile.Size();
+        }
+        else if (ReadTOCBuffer(filePath))
+        {
+            _Data = _TOCBuffer.data();
+            _DataSize = _TOCBuffer.size();
+        }
+        else
         {
             fprintf(stderr, "ERROR : ResourceFile : Failed to open %s for reading.\n", FilePath.c_str());
             return;
         }
 
-        if (f != NULL)
+        _IsLoaded = CreateViews();
+        if (!_IsLoaded)
+            fprintf(stderr, "ERROR : ResourceFile : %s is truncated or not a valid .resources file.\n", FilePath.c_str());
+    }
+
+    // Fallback for when the file can't be mapped: read everything up to the end of the path string indexes in one go
+    bool ResourceFile::ReadTOCBuffer(const fs::path& filePath)
+    {
+        FILE* f = fopen(filePath.string().c_str(), "rb");
+        if (f == NULL)
+            return false;
+
+        ResourceFileHeader header;
+        if (readFileAt(f, &header, sizeof(ResourceFileHeader), 0) != sizeof(ResourceFileHeader))
         {
-            // Read .resources file header
-            fseek(f, 0, SEEK_SET);
-            fread(&_Header, sizeof(ResourceFileHeader), 1, f);
-            _FileEntries.resize(_Header.NumFileEntries);
-
-            // Read .resources file entries
-            for (int i = 0; i < _FileEntries.size(); i++)
-                fread(&_FileEntries[i], sizeof(ResourceFileEntry), 1, f);
-
-            // Read total # of strings in resource file
-            fread(&_NumStrings, sizeof(uint64_t), 1, f);
-
-            // Allocate vectors
-            _PathStringIndexes.resize(_Header.NumPathStringIndexes);
-            _StringEntries.resize(_NumStrings);
-            _StringOffsets.resize(_NumStrings + 1);
-            _StringOffsets[_NumStrings] = _Header.AddrDependencyEntries; // to find last entry string length
-
-            // Read string offsets into vector
-            for (int i = 0; i < _NumStrings; i++)
-                fread(&_StringOffsets[i], 8, 1, f);
-
-            // Read strings into vector
-            for (int i = 0; i < _NumStrings; i++)
-            {
-                int stringLength = _StringOffsets[i + 1] - _StringOffsets[i];
-                char* stringBuffer = new char[stringLength];
-                fread(stringBuffer, stringLength, 1, f);
-                _StringEntries[i] = stringBuffer;
-            }
-
-            // Skip ahead to string indexes
-            uint64_t addrPathStringIndexes = _Header.AddrDependencyIndexes + (_Header.NumDependencyIndexes * sizeof(int));
-            fseek(f, addrPathStringIndexes, SEEK_SET);
-
-            // Read string indexes into vector
-            for (int i = 0; i < _Header.NumPathStringIndexes; i++)
-                fread(&_PathStringIndexes[i], sizeof(uint64_t), 1, f);
+            fclose(f);
+            return false;
         }
+
+        uint64_t addrPathStringIndexes = header.AddrDependencyIndexes + ((uint64_t)header.NumDependencyIndexes * sizeof(uint32_t));
+        uint64_t tocSize = addrPathStringIndexes + ((uint64_t)header.NumPathStringIndexes * sizeof(uint64_t));
+
+        _TOCBuffer.resize(tocSize);
+        _TOCBuffer.resize(readFileAt(f, _TOCBuffer.data(), tocSize, 0));
         fclose(f);
+        return true;
+    }
+
+    // Points the typed views at their sections in the file data. Returns false if any section is out of bounds.
+    bool ResourceFile::CreateViews()
+    {
+        // Read .resources file header
+        if (_DataSize < sizeof(ResourceFileHeader))
+            return false;
+
+        std::memcpy(&_Header, _Data, sizeof(ResourceFileHeader));
+
+        // .resources file entries
+        uint64_t addrEntries = sizeof(ResourceFileHeader);
+        uint64_t sizeEntries = (uint64_t)_Header.NumFileEntries * sizeof(ResourceFileEntry);
+        if (addrEntries + sizeEntries + sizeof(uint64_t) > _DataSize)
+            return false;
+
+        _FileEntries = ArrayView<ResourceFileEntry>(_Data + addrEntries, _Header.NumFileEntries);
+
+        // Total # of strings in resource file, then string offsets
+        uint64_t addrNumStrings = addrEntries + sizeEntries;
+        std::memcpy(&_NumStrings, _Data + addrNumStrings, sizeof(uint64_t));
+
+        uint64_t addrStringOffsets = addrNumStrings + sizeof(uint64_t);
+        if (_NumStrings > (_DataSize - addrStringOffsets) / sizeof(uint64_t))
+            return false;
+
+        _StringOffsets = ArrayView<uint64_t>(_Data + addrStringOffsets, _NumStrings);
+
+        // Strings run from the end of the offsets until the dependency entries
+        _AddrStrings = addrStringOffsets + (_NumStrings * sizeof(uint64_t));
+        _AddrStringsEnd = std::min<uint64_t>(_Header.AddrDependencyEntries, _DataSize);
+        if (_AddrStringsEnd < _AddrStrings)
+            return false;
+
+        // Dependency entries, then the dependency indexes that ResourceFileEntry::DependencyIndexNumber points into
+        uint64_t sizeFileDependencies = (uint64_t)_Header.NumDependencyEntries * sizeof(ResourceFileDependency);
+        if (_Header.AddrDependencyEntries > _DataSize || sizeFileDependencies > _DataSize - _Header.AddrDependencyEntries)
+            return false;
+
+        _FileDependencies = ArrayView<ResourceFileDependency>(_Data + _Header.AddrDependencyEntries, _Header.NumDependencyEntries);
+
+        uint64_t sizeDependencyIndexes = (uint64_t)_Header.NumDependencyIndexes * sizeof(uint32_t);
+        if (_Header.AddrDependencyIndexes > _DataSize || sizeDependencyIndexes > _DataSize - _Header.AddrDependencyIndexes)
+            return false;
+
+        _DependencyIndexes = ArrayView<uint32_t>(_Data + _Header.AddrDependencyIndexes, _Header.NumDependencyIndexes);
+
+        // Path string indexes come right after
+        uint64_t addrPathStringIndexes = _Header.AddrDependencyIndexes + ((uint64_t)_Header.NumDependencyIndexes * sizeof(uint32_t));
+        uint64_t sizePathStringIndexes = (uint64_t)_Header.NumPathStringIndexes * sizeof(uint64_t);
+        if (addrPathStringIndexes > _DataSize || sizePathStringIndexes > _DataSize - addrPathStringIndexes)
+            return false;
+
+        _PathStringIndexes = ArrayView<uint64_t>(_Data + addrPathStringIndexes, _Header.NumPathStringIndexes);
+        return true;
+    }
+
+    // Returns a view of string i, valid for the lifetime of this ResourceFile
+    std::string_view ResourceFile::GetResourceStringEntry(uint64_t i) const
+    {
+        if (i >= _NumStrings)
+            return std::string_view();
+
+        uint64_t stringStart = _AddrStrings + _StringOffsets[i];
+        if (stringStart >= _AddrStringsEnd)
+            return std::string_view();
+
+        const char* str = (const char*)_Data + stringStart;
+        const void* terminator = std::memchr(str, 0, _AddrStringsEnd - stringStart);
+        uint64_t length = (terminator != NULL) ? (const char*)terminator - str : _AddrStringsEnd - stringStart;
+        return std::string_view(str, length);
     }
 }
@@ -1,13 +1,14 @@
 #pragma once
 
-#pragma pack(push)  // Not portable, sorry.
-#pragma pack(1)     // Works on my machine (TM).
-
 #include <string>
+#include <string_view>
 #include <vector>
 #include <filesystem>
 
-#include "ResourceFile.h"
+#include "../MappedFile.h"
+
+#pragma pack(push)  // Not portable, sorry.
+#pragma pack(1)     // Works on my machine (TM).
 
 namespace HAYDEN
 {
@@ -118,27 +119,45 @@ namespace HAYDEN
             std::string FilePath;
 
             // Getters
-            uint32_t GetNumFileEntries() const { return _Header.NumFileEntries; }
-            ResourceFileEntry& GetResourceFileEntry(int i) { return _FileEntries[i]; }
-            std::string GetResourceStringEntry(int i) const { return _StringEntries[i]; }
-            std::vector<uint64_t> GetAllPathStringIndexes() const { return _PathStringIndexes; }
+            bool IsLoaded() const { return _IsLoaded; }
+            bool IsMapped() const { return _MappedFile.IsOpen(); }
+            const ResourceFileHeader& GetHeader() const { return _Header; }
+            uint32_t GetNumFileEntries() const { return (uint32_t)_FileEntries.Size(); }
+            const ResourceFileEntry& GetResourceFileEntry(int i) const { return _FileEntries.Data()[i]; }
+            std::string_view GetResourceStringEntry(uint64_t i) const;
+            uint64_t GetPathStringIndex(uint64_t i) const { return _PathStringIndexes[i]; }
+            ArrayView<uint64_t> GetAllPathStringIndexes() const { return _PathStringIndexes; }
+            ArrayView<ResourceFileDependency> GetAllFileDependencies() const { return _FileDependencies; }
+            ArrayView<uint32_t> GetAllDependencyIndexes() const { return _DependencyIndexes; }
 
             // Reads a binary .resources file from local filesystem
             ResourceFile(const fs::path& filePath);
 
         private:
 
+            // Backing storage for the views below. Normally a read-only mapping of the whole file;
+            // if mapping fails, the metadata section is read into _TOCBuffer with a single read instead.
+            MappedFile _MappedFile;
+            std::vector<uint8_t> _TOCBuffer;
+            const uint8_t* _Data = NULL;
+            uint64_t _DataSize = 0;
+            bool _IsLoaded = 0;
+
             // Binary data within the .resources file
             ResourceFileHeader _Header;                             // first 0x7C bytes in file
-            std::vector<ResourceFileEntry> _FileEntries;            // immediately after ResourceFileHeader,  repeating 0x90 byte sequence
+            ArrayView<ResourceFileEntry> _FileEntries;              // immediately after ResourceFileHeader,  repeating 0x90 byte sequence
 
             uint64_t _NumStrings = 0;                               // immediately after last ResourceFileEntry
-            std::vector<uint64_t> _StringOffsets;                   // immediately after _numStrings
-            std::vector<std::string> _StringEntries;                // immediately atter _stringOffsets
+            ArrayView<uint64_t> _StringOffsets;                     // immediately after _numStrings,  relative to start of string data
+            uint64_t _AddrStrings = 0;                              // immediately after _stringOffsets,  null-terminated strings
+            uint64_t _AddrStringsEnd = 0;
+
+            ArrayView<ResourceFileDependency> _FileDependencies;    // immediately after _stringEntries,  repeating 0x20 byte sequence
+            ArrayView<uint32_t> _DependencyIndexes;                 // immediately after _DependencyEntries,  index into _DependencyEntries
+            ArrayView<uint64_t> _PathStringIndexes;                 // immediately after _dependencyIndexes,  index into _stringEntries
 
-            std::vector<ResourceFileDependency> _FileDependencies;  // (not implemented)  immediately after _stringEntries,  repeating 0x20 byte sequence
-            std::vector<uint32_t> _DependencyIndexes;               // (not implemented)  immediately after _DependencyEntries,  index into _DependencyEntries
-            std::vector<uint64_t> _PathStringIndexes;               // immediately after _dependencyIndexes,  index into _stringEntries
+            bool ReadTOCBuffer(const fs::path& filePath);
+            bool CreateViews();
     };
 }
 
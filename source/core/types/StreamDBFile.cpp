@@ -0,0 +1,124 @@
+#include "StreamDBFile.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace HAYDEN
+{
+    // Maps binary .streamdb file from local filesystem
+    StreamDBFile::StreamDBFile(const fs::path& filePath)
+    {
+        FilePath = filePath.string();
+
+        if (!_MappedFile.Open(filePath))
+        {
+            fprintf(stderr, "ERROR : StreamDBFile : Failed to open %s for reading.\n", FilePath.c_str());
+            return;
+        }
+
+        if (!_MappedFile.Contains(0, sizeof(StreamDBHeader)))
+        {
+            fprintf(stderr, "ERROR : StreamDBFile : %s is truncated or not a valid .streamdb file.\n", FilePath.c_str());
+            return;
+        }
+
+        std::memcpy(&_Header, _MappedFile.Data(), sizeof(StreamDBHeader));
+        if (_Header.Magic != STREAMDB_MAGIC || !_MappedFile.Contains(sizeof(StreamDBHeader), (uint64_t)_Header.NumEntries * sizeof(StreamDBEntry)))
+        {
+            fprintf(stderr, "ERROR : StreamDBFile : %s is truncated or not a valid .streamdb file.\n", FilePath.c_str());
+            return;
+        }
+
+        _Entries = ArrayView<StreamDBEntry>(_MappedFile.Data() + sizeof(StreamDBHeader), _Header.NumEntries);
+
+        // Sorted index over the identifiers. If the file is sorted already, this is just a copy.
+        std::vector<uint64_t> identifiers(_Entries.Size());
+        for (uint32_t i = 0; i < identifiers.size(); i++)
+            identifiers[i] = _Entries[i].Identifier;
+
+        _SortedEntries.resize(identifiers.size());
+        std::iota(_SortedEntries.begin(), _SortedEntries.end(), 0);
+
+        if (!std::is_sorted(identifiers.begin(), identifiers.end()))
+        {
+            std::stable_sort(_SortedEntries.begin(), _SortedEntries.end(), [&identifiers](uint32_t a, uint32_t b) {
+                return identifiers[a] < identifiers[b];
+            });
+        }
+
+        _SortedIdentifiers.resize(identifiers.size());
+        for (uint32_t i = 0; i < _SortedEntries.size(); i++)
+            _SortedIdentifiers[i] = identifiers[_SortedEntries[i]];
+
+        _IsLoaded = 1;
+    }
+
+    int64_t StreamDBFile::FindEntry(uint64_t identifier) const
+    {
+        auto sortedIdentifier = std::lower_bound(_SortedIdentifiers.begin(), _SortedIdentifiers.end(), identifier);
+        if (sortedIdentifier == _SortedIdentifiers.end() || *sortedIdentifier != identifier)
+            return -1;
+
+        return _SortedEntries[sortedIdentifier - _SortedIdentifiers.begin()];
+    }
+
+    // Sorts the query, then walks it and the index together
+    std::vector<int64_t> StreamDBFile::FindEntries(const std::vector<uint64_t>& identifiers) const
+    {
+        std::vector<int64_t> entries(identifiers.size(), -1);
+
+        std::vector<uint32_t> queryOrder(identifiers.size());
+        std::iota(queryOrder.begin(), queryOrder.end(), 0);
+        std::sort(queryOrder.begin(), queryOrder.end(), [&identifiers](uint32_t a, uint32_t b) {
+            return identifiers[a] < identifiers[b];
+        });
+
+        uint64_t j = 0;
+        for (uint32_t i : queryOrder)
+        {
+            while (j < _SortedIdentifiers.size() && _SortedIdentifiers[j] < identifiers[i])
+                j++;
+
+            if (j < _SortedIdentifiers.size() && _SortedIdentifiers[j] == identifiers[i])
+                entries[i] = _SortedEntries[j];
+        }
+
+        return entries;
+    }
+
+    ArrayView<uint8_t> StreamDBFile::GetEntryData(uint32_t i) const
+    {
+        StreamDBEntry entry = _Entries[i];
+        uint64_t dataOffset = (uint64_t)entry.DataOffset16 * 16;
+
+        if (!_MappedFile.Contains(dataOffset, entry.DataLength))
+            return ArrayView<uint8_t>();
+
+        return ArrayView<uint8_t>(_MappedFile.Data() + dataOffset, entry.DataLength);
+    }
+
+    ArrayView<uint8_t> StreamDBFile::GetData(uint64_t identifier) const
+    {
+        int64_t i = FindEntry(identifier);
+        return (i == -1) ? ArrayView<uint8_t>() : GetEntryData((uint32_t)i);
+    }
+
+    // Every .streamdb file under basePath, newest patch first - "x_patch2" sorts after "x_patch1", which sorts after "x"
+    std::vector<fs::path> StreamDBFile::FindStreamDBs(const fs::path& basePath)
+    {
+        std::vector<fs::path> streamDBs;
+        std::error_code ec;
+
+        for (fs::recursive_directory_iterator it(basePath, fs::directory_options::skip_permission_denied, ec), end; it != end; it.increment(ec))
+        {
+            if (ec)
+                break;
+
+            if (it->is_regular_file(ec) && it->path().extension() == ".streamdb")
+                streamDBs.push_back(it->path());
+        }
+
+        std::sort(streamDBs.rbegin(), streamDBs.rend());
+        return streamDBs;
+    }
+}
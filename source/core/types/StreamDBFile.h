@@ -0,0 +1,94 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <filesystem>
+
+#include "../MappedFile.h"
+
+#pragma pack(push)  // Not portable, sorry.
+#pragma pack(1)     // Works on my machine (TM).
+
+namespace HAYDEN
+{
+    /**
+    *   Notes on .streamdb file format:
+    *
+    *   The .streamdb file is a container for streamed data - mesh LODs (.lwo geometry), image mips, etc.
+    *   Entries have no names, only a 64-bit identifier. For embedded files in a .resources file,
+    *   the identifier is derived from the entry's StreamResourceHash (see ResourceFileReader::CalculateStreamDBIndex).
+    *
+    *   The basic format of a .streamdb file is:
+    *     (a) a StreamDBHeader, followed by
+    *     (b) one StreamDBEntry per entry, followed by
+    *     (c) the entries' data, each aligned to 16 bytes. Data is stored as-is, usually Oodle compressed.
+    */
+
+    namespace fs = std::filesystem;
+
+    const uint64_t STREAMDB_MAGIC = 0x61C7F32E29C2A550;
+
+    // Built-in struct in .streamdb binary file
+    struct StreamDBHeader // 0x20 bytes
+    {
+        /* 0x00 */ uint64_t Magic = 0;
+        /* 0x08 */ uint32_t HeaderLength = 0;           // size of everything before the entries' data
+        /* 0x0C */ uint32_t Unk0C = 0;
+        /* 0x10 */ uint32_t Unk10 = 0;
+        /* 0x14 */ uint32_t Unk14 = 0;
+        /* 0x18 */ uint32_t NumEntries = 0;
+        /* 0x1C */ uint32_t Flags = 0;
+    };
+
+    // Built-in struct in .streamdb binary file
+    struct StreamDBEntry // 0x10 bytes
+    {
+        /* 0x00 */ uint64_t Identifier = 0;
+        /* 0x08 */ uint32_t DataOffset16 = 0;           // offset of the data in 16 byte units
+        /* 0x0C */ uint32_t DataLength = 0;
+    };
+
+    class StreamDBFile
+    {
+        public:
+
+            // External, passed into constructor
+            std::string FilePath;
+
+            // Getters
+            bool IsLoaded() const { return _IsLoaded; }
+            const StreamDBHeader& GetHeader() const { return _Header; }
+            uint32_t GetNumEntries() const { return (uint32_t)_Entries.Size(); }
+            StreamDBEntry GetEntry(uint32_t i) const { return _Entries[i]; }
+
+            // Entry index for an identifier, -1 if not found. Binary search over the sorted identifiers.
+            int64_t FindEntry(uint64_t identifier) const;
+
+            // Entry indexes for many identifiers at once, -1 for those not found. One pass over the index after sorting the query.
+            std::vector<int64_t> FindEntries(const std::vector<uint64_t>& identifiers) const;
+
+            // The entry's data, straight from the mapped file. Empty if the entry points outside the file.
+            ArrayView<uint8_t> GetEntryData(uint32_t i) const;
+            ArrayView<uint8_t> GetData(uint64_t identifier) const;
+
+            // Maps a binary .streamdb file from local filesystem
+            StreamDBFile(const fs::path& filePath);
+
+            // Every .streamdb file under basePath, newest patch first
+            static std::vector<fs::path> FindStreamDBs(const fs::path& basePath);
+
+        private:
+            MappedFile _MappedFile;
+            bool _IsLoaded = 0;
+
+            // Binary data within the .streamdb file
+            StreamDBHeader _Header;                                 // first 0x20 bytes in file
+            ArrayView<StreamDBEntry> _Entries;                      // immediately after StreamDBHeader, repeating 0x10 byte sequence
+
+            // Identifiers sorted, with the entry index for each. Entries are usually sorted in the file already.
+            std::vector<uint64_t> _SortedIdentifiers;
+            std::vector<uint32_t> _SortedEntries;
+    };
+}
+
+#pragma pack(pop)
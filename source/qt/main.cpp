@@ -1,12 +1,341 @@
 #include <QApplication>
 #include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QFile>
 
 #include "mainwindow.h"
 #include "resourceform.h"
 
+// Entry filter shared by the command line modes
+HAYDEN::ResourceFilter getResourceFilter(const QCommandLineParser& parser)
+{
+    HAYDEN::ResourceFilter filter;
+    filter.Type = parser.value("type").toStdString();
+    filter.NameContains = parser.value("name").toStdString();
+    if (parser.isSet("version"))
+        filter.Version = parser.value("version").toLongLong();
+
+    return filter;
+}
+
+// Command line mode: extract embedded files from a .resources file without opening the GUI
+int runExtract(const QCommandLineParser& parser)
+{
+    HAYDEN::ModelConverter converter;
+    if (!converter.LoadResource(parser.value("extract").toStdString()))
+        return 1;
+
+    fs::path outputPath = parser.value("output").toStdString();
+    HAYDEN::ExtractionStats stats = converter.ExtractResources(outputPath, getResourceFilter(parser), parser.value("threads").toUInt());
+
+    printf("Extracted %llu files (%llu failed), %.1f MB in %.2f s\n",
+        (unsigned long long)stats.NumEntries,
+        (unsigned long long)stats.NumFailed,
+        stats.BytesWritten / (1024.0 * 1024.0),
+        stats.Seconds);
+    printf("%.1f MB/s, %.1f entries/s\n", stats.MegabytesPerSecond(), stats.EntriesPerSecond());
+
+    return stats.NumFailed == 0 ? 0 : 1;
+}
+
+// Command line mode: check the stored checksums of embedded files in a .resources file
+int runVerify(const QCommandLineParser& parser)
+{
+    HAYDEN::ModelConverter converter;
+    if (!converter.LoadResource(parser.value("verify").toStdString()))
+        return 1;
+
+    HAYDEN::VerificationStats stats = converter.VerifyResources(getResourceFilter(parser), parser.value("threads").toUInt());
+
+    for (const auto& mismatch : stats.Mismatches)
+    {
+        printf("MISMATCH : %s (expected %016llx, got %016llx)\n", mismatch.Name.c_str(),
+            (unsigned long long)mismatch.Expected,
+            (unsigned long long)mismatch.Actual);
+    }
+
+    printf("Verified %llu files: %llu mismatched, %llu failed, %llu without checksum\n",
+        (unsigned long long)stats.NumEntries,
+        (unsigned long long)stats.Mismatches.size(),
+        (unsigned long long)stats.NumFailed,
+        (unsigned long long)stats.NumSkipped);
+    printf("Hashed %.1f MB in %.2f s, %.1f MB/s, %.1f entries/s\n",
+        stats.BytesHashed / (1024.0 * 1024.0),
+        stats.Seconds,
+        stats.MegabytesPerSecond(),
+        stats.EntriesPerSecond());
+
+    return stats.Mismatches.empty() && stats.NumFailed == 0 ? 0 : 1;
+}
+
+// Command line mode: list what changed between a .resources file and its backup
+int runDiff(const QCommandLineParser& parser)
+{
+    HAYDEN::ModelConverter converter;
+    if (!converter.LoadResource(parser.value("diff").toStdString()))
+        return 1;
+
+    QString originalPath = parser.isSet("against") ? parser.value("against") : parser.value("diff") + ".backup";
+    HAYDEN::DiffStats stats = converter.DiffResources(originalPath.toStdString(), getResourceFilter(parser), parser.value("threads").toUInt());
+
+    for (const auto& difference : stats.Differences)
+    {
+        switch (difference.Change)
+        {
+            case HAYDEN::ResourceChange::Added:
+                printf("ADDED    : %s (%s, %llu bytes)\n", difference.Name.c_str(), difference.Type.c_str(), (unsigned long long)difference.ModifiedSize);
+                break;
+            case HAYDEN::ResourceChange::Removed:
+                printf("REMOVED  : %s (%s, %llu bytes)\n", difference.Name.c_str(), difference.Type.c_str(), (unsigned long long)difference.OriginalSize);
+                break;
+            case HAYDEN::ResourceChange::Modified:
+                printf("MODIFIED : %s (%s, %llu -> %llu bytes, first difference at %lld)\n", difference.Name.c_str(), difference.Type.c_str(),
+                    (unsigned long long)difference.OriginalSize,
+                    (unsigned long long)difference.ModifiedSize,
+                    (long long)difference.FirstDifference);
+                break;
+            case HAYDEN::ResourceChange::MetadataOnly:
+                printf("METADATA : %s (%s, data unchanged)\n", difference.Name.c_str(), difference.Type.c_str());
+                break;
+        }
+    }
+
+    printf("%llu entries in original, %llu in modified: %llu unchanged, %llu compared, %llu failed, %llu differences\n",
+        (unsigned long long)stats.NumOriginalEntries,
+        (unsigned long long)stats.NumModifiedEntries,
+        (unsigned long long)stats.NumUnchanged,
+        (unsigned long long)stats.NumCompared,
+        (unsigned long long)stats.NumFailed,
+        (unsigned long long)stats.Differences.size());
+    printf("Compared %.1f MB in %.2f s, %.1f MB/s\n",
+        stats.BytesCompared / (1024.0 * 1024.0),
+        stats.Seconds,
+        stats.MegabytesPerSecond());
+
+    return stats.NumFailed == 0 ? 0 : 1;
+}
+
+// Command line mode: convert the .lwo models in a .resources file to OBJ or binary glTF
+int runExportModels(const QCommandLineParser& parser)
+{
+    HAYDEN::ModelConverter converter;
+    if (!converter.LoadResource(parser.value("export-models").toStdString()))
+        return 1;
+
+    HAYDEN::ModelExportFormat format = parser.value("format").toLower() == "glb" ? HAYDEN::ModelExportFormat::GLB : HAYDEN::ModelExportFormat::OBJ;
+
+    std::vector<fs::path> streamDBPaths;
+    for (const QString& streamDBPath : parser.values("streamdb"))
+        streamDBPaths.push_back(streamDBPath.toStdString());
+
+    fs::path outputPath = parser.value("output").toStdString();
+    HAYDEN::ModelExportStats stats = converter.ExportModels(outputPath, format, getResourceFilter(parser), parser.value("lod").toUInt(), parser.value("threads").toUInt(), streamDBPaths);
+
+    printf("Exported %llu models (%llu failed, %llu skipped), %llu vertices, %llu triangles, %.1f MB in %.2f s\n",
+        (unsigned long long)stats.NumModels,
+        (unsigned long long)stats.NumFailed,
+        (unsigned long long)stats.NumSkipped,
+        (unsigned long long)stats.NumVertices,
+        (unsigned long long)stats.NumTriangles,
+        stats.BytesWritten / (1024.0 * 1024.0),
+        stats.Seconds);
+    printf("%.1f models/s\n", stats.ModelsPerSecond());
+
+    return stats.NumFailed == 0 ? 0 : 1;
+}
+
+// Command line mode: import every OBJ listed in a file, packing all geometry into one .streamdb.
+// Each line of the list is "<obj path>\t<.lwo entry name>\t<material2 decl>".
+int runImportModels(const QCommandLineParser& parser)
+{
+    QString resourcePath = parser.value("into");
+    int baseIndex = resourcePath.lastIndexOf("base");
+    if (resourcePath.isEmpty() || baseIndex == -1)
+    {
+        fprintf(stderr, "ERROR : --import-models needs --into <resources>, a .resources file under the game's \"base\" directory.\n");
+        return 1;
+    }
+
+    QFile listFile(parser.value("import-models"));
+    if (!listFile.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        fprintf(stderr, "ERROR : Failed to open %s for reading.\n", parser.value("import-models").toStdString().c_str());
+        return 1;
+    }
+
+    std::vector<HAYDEN::ModelImport> imports;
+    while (!listFile.atEnd())
+    {
+        QStringList fields = QString(listFile.readLine()).trimmed().split('\t');
+        if (fields.size() != 3)
+            continue;
+
+        HAYDEN::ModelImport modelImport;
+        modelImport.OBJPath = fields[0].toStdString();
+        modelImport.LWOPath = fields[1].toStdString();
+        modelImport.ResourcePath = resourcePath.toStdString();
+        modelImport.Material2Decl = fields[2].toStdString();
+        imports.push_back(modelImport);
+    }
+
+    HAYDEN::CompressionOptions compression;
+    compression.NumThreads = parser.value("threads").toUInt();
+    compression.Settings.Level = parser.value("level").toInt();
+
+    QString codec = parser.value("codec").toLower();
+    if (codec == "auto")
+        compression.IsAuto = 1;
+    else if (!HAYDEN::parseOodleCodec(codec.toStdString(), compression.Settings.Codec))
+    {
+        fprintf(stderr, "ERROR : Unknown codec %s, expected kraken, mermaid, leviathan or auto.\n", codec.toStdString().c_str());
+        return 1;
+    }
+
+    if (compression.Settings.Level < 1 || compression.Settings.Level > 9)
+    {
+        fprintf(stderr, "ERROR : --level must be between 1 and 9.\n");
+        return 1;
+    }
+
+    fs::path gamePath = resourcePath.left(baseIndex).toStdString();
+    fs::path streamDBPath = parser.value("streamdb-output").toStdString();
+
+    HAYDEN::ModelConverter converter;
+    converter.UseImportCache = !parser.isSet("no-import-cache");
+    int numImported = converter.ConvertOBJsToLWO(gamePath, imports, streamDBPath, !parser.isSet("z-up"), parser.isSet("patch"), compression, 1);
+
+    printf("Imported %d of %llu models into %s\n", numImported, (unsigned long long)imports.size(), streamDBPath.string().c_str());
+    return numImported == (int)imports.size() ? 0 : 1;
+}
+
+// Command line mode: measure where threaded Oodle decompression starts paying off on this machine, and save it
+int runTuneDecompression(const QCommandLineParser& parser)
+{
+    std::string basePath = parser.value("tune-decompression").toStdString();
+    if (!HAYDEN::oodleInit(basePath))
+    {
+        fprintf(stderr, "ERROR : Failed to load Oodle from %s.\n", basePath.c_str());
+        return 1;
+    }
+
+    if (!HAYDEN::oodleCanDecompressThreaded())
+    {
+        fprintf(stderr, "ERROR : This Oodle library can't decompress threaded.\n");
+        return 1;
+    }
+
+    HAYDEN::OodleDecompressTuning tuning = HAYDEN::oodleTuneDecompression();
+
+    printf("%12s %16s %16s\n", "Size", "Unthreaded MB/s", "Threaded MB/s");
+    for (const auto& benchmark : tuning.Benchmarks)
+    {
+        printf("%12llu %16.1f %16.1f%s\n",
+            (unsigned long long)benchmark.Size,
+            benchmark.UnthreadedMegabytesPerSecond(),
+            benchmark.ThreadedMegabytesPerSecond(),
+            benchmark.IsThreadedValid ? "" : " (threaded failed)");
+    }
+
+    if (tuning.ThreadedCutoff == UINT64_MAX)
+        printf("Threaded decompression is off\n");
+    else
+        printf("Threaded decompression from %.1f MB\n", tuning.ThreadedCutoff / (1024.0 * 1024.0));
+
+    return 0;
+}
+
+// Every command line mode's options. Without one of them, the GUI is opened.
+void addCommandLineOptions(QCommandLineParser& parser)
+{
+    parser.addHelpOption();
+    parser.addOptions({
+        { "extract", "Extract embedded files from <resources> and exit.", "resources" },
+        { "verify", "Check the checksums of embedded files in <resources> and exit.", "resources" },
+        { "diff", "List entries that differ between <resources> and its .backup, then exit.", "resources" },
+        { "against", "Archive to compare with in diff mode (default: <resources>.backup).", "original" },
+        { "export-models", "Convert the .lwo models in <resources> to OBJ or binary glTF and exit.", "resources" },
+        { "format", "Model export format, \"obj\" or \"glb\" (default: obj).", "format", "obj" },
+        { "lod", "Level of detail to export, 0 is the most detailed (default: 0).", "lod", "0" },
+        { "streamdb", "A .streamdb file to take model geometry from. Repeatable (default: every .streamdb under base).", "streamdb" },
+        { "import-models", "Import every OBJ listed in <list> (obj, .lwo entry and material2 decl per line, tab separated) and exit.", "list" },
+        { "into", "The .resources file holding the .lwo entries to import into.", "resources" },
+        { "streamdb-output", "The .streamdb file all imported geometry is packed into (default: imports/imports.streamdb).", "file", "imports/imports.streamdb" },
+        { "patch", "Also patch the new .lwo headers into the .resources file." },
+        { "z-up", "Imported OBJ files are Z up instead of Y up." },
+        { "codec", "Codec for imported geometry: \"kraken\", \"mermaid\", \"leviathan\" or \"auto\" to pick the best ratio per model (default: kraken).", "codec", "kraken" },
+        { "level", "Compression level for imported geometry, 1 to 9 (default: 4).", "level", "4" },
+        { "no-import-cache", "Build and compress every imported OBJ from scratch, without reading or writing cache/import." },
+        { "output", "Directory to extract to (default: exports).", "directory", "exports" },
+        { "type", "Only use entries of this resource type, e.g. \"model\".", "type" },
+        { "name", "Only use entries whose name contains this text.", "text" },
+        { "version", "Only use entries with this resource version, e.g. 67 for .lwo.", "version" },
+        { "tune-decompression", "Benchmark threaded decompression with the Oodle library in <base>, save the result and exit.", "base" },
+        { "stand-in-codec", "Read Oodle compressed entries with a pass-through stand-in, for benchmarking without the game's Oodle library. Their output isn't real data, and imported models are stored uncompressed." },
+        { "threads", "Number of worker threads (default: one per core).", "count", "0" }
+    });
+}
+
+bool isCommandLineMode(const QCommandLineParser& parser)
+{
+    for (const char* mode : { "help", "extract", "verify", "diff", "export-models", "import-models", "tune-decompression" })
+    {
+        if (parser.isSet(mode))
+            return true;
+    }
+    return false;
+}
+
+int runCommandLine(const QCommandLineParser& parser)
+{
+    if (parser.isSet("stand-in-codec"))
+        HAYDEN::useStandInResourceCodec();
+
+    if (parser.isSet("extract"))
+        return runExtract(parser);
+
+    if (parser.isSet("verify"))
+        return runVerify(parser);
+
+    if (parser.isSet("diff"))
+        return runDiff(parser);
+
+    if (parser.isSet("export-models"))
+        return runExportModels(parser);
+
+    if (parser.isSet("import-models"))
+        return runImportModels(parser);
+
+    return runTuneDecompression(parser);
+}
+
 int main(int argc, char *argv[])
 {
+    // The command line modes run without a display, so QApplication is only created for the GUI
+    {
+        QCoreApplication core(argc, argv);
+
+        QCommandLineParser parser;
+        addCommandLineOptions(parser);
+
+        // GUI options like -platform aren't known here, they're only an error once a command line mode is asked for
+        parser.parse(core.arguments());
+        if (isCommandLineMode(parser))
+        {
+            parser.process(core);
+            return runCommandLine(parser);
+        }
+    }
+
     QApplication a(argc, argv);
+
+    // Parsed again now that QApplication has taken out its own arguments, so a mistyped option is still reported
+    QCommandLineParser parser;
+    addCommandLineOptions(parser);
+    parser.process(a);
+
+    if (parser.isSet("stand-in-codec"))
+        HAYDEN::useStandInResourceCodec();
+
     MainWindow w;
 
     w.show();
@@ -15,6 +15,7 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent), ui(new Ui::MainWi
 
     // page 2 ui
     ui->materialList->setSortingEnabled(false);
+    ui->inputMaterialSearch->setEnabled(false);
     ui->btnConvert->setEnabled(false);
 }
 
@@ -78,6 +79,71 @@ void MainWindow::EnableGUI()
     return;
 }
 
+// Builds the material2 index for this game install in the background, search is enabled once it's ready
+void MainWindow::LoadMaterialIndex()
+{
+    fs::path basePath = _GamePath / "base";
+    if (basePath == _MaterialIndexBasePath)
+        return;
+
+    _MaterialIndexBasePath = basePath;
+    _MaterialIndex.reset();
+    ui->inputMaterialSearch->clear();
+    ui->inputMaterialSearch->setEnabled(false);
+    ui->inputMaterialSearch->setPlaceholderText("Indexing material2 decls...");
+
+    QThread* indexThread = QThread::create([this, basePath]()
+    {
+        auto materialIndex = std::make_shared<HAYDEN::MaterialDeclIndex>();
+        materialIndex->Build(basePath);
+
+        QMetaObject::invokeMethod(this, [this, basePath, materialIndex]()
+        {
+            // A model from another game install may have been picked in the meantime
+            if (basePath != _MaterialIndexBasePath)
+                return;
+
+            _MaterialIndex = materialIndex;
+            ui->inputMaterialSearch->setEnabled(true);
+            ui->inputMaterialSearch->setPlaceholderText("Search all " + QString::number(materialIndex->Size()) + " material2 decls");
+        }, Qt::QueuedConnection);
+    });
+
+    connect(indexThread, &QThread::finished, indexThread, &QObject::deleteLater);
+    indexThread->start();
+    return;
+}
+
+// Shows the .lwo's own materials, or the matches from the material index while searching
+void MainWindow::PopulateMaterialList(const QString& searchText)
+{
+    const uint32_t maxResults = 1000;
+
+    ui->materialList->clearContents();
+    ui->materialList->setRowCount(0);
+
+    if (searchText.isEmpty() || !_MaterialIndex)
+    {
+        ui->materialList->setRowCount((int)_LWOMaterials.size());
+        for (int i = 0; i < _LWOMaterials.size(); i++)
+            ui->materialList->setItem(i, 0, new QTableWidgetItem(QString::fromStdString(_LWOMaterials[i])));
+
+        return;
+    }
+
+    // Decl names in the game are all lower case
+    std::string query = searchText.toLower().toStdString();
+    std::vector<uint32_t> rows = _MaterialIndex->Search(query, maxResults);
+
+    ui->materialList->setRowCount((int)rows.size());
+    for (int i = 0; i < rows.size(); i++)
+    {
+        std::string_view materialName = _MaterialIndex->GetName(rows[i]);
+        ui->materialList->setItem(i, 0, new QTableWidgetItem(QString::fromUtf8(materialName.data(), (int)materialName.size())));
+    }
+    return;
+}
+
 // Private Slots
 void MainWindow::on_btnBack_clicked()
 {
@@ -88,7 +154,29 @@ void MainWindow::on_btnBack_clicked()
 void MainWindow::on_btnConvert_clicked()
 {
     HAYDEN::ModelConverter Converter;
-    bool success = Converter.ConvertOBJtoLWO(_GamePath, _OBJFilePath, _LWOFileName.toStdString(), _ResourceFilePath, _Material2Decl.toStdString(), _UseYOrientation);
+    bool patchResources = ui->checkPatchResources->isChecked();
+    bool success = 0;
+    fs::path streamDBPath;
+
+    if (patchResources)
+    {
+        // The patched header points at geometry the game reads from a .streamdb, so the model gets one of its own.
+        // Named after the .lwo entry, so importing the same model again replaces it instead of another model's.
+        std::string streamDBName = _LWOFileName.toStdString();
+        std::replace(streamDBName.begin(), streamDBName.end(), '/', '_');
+        streamDBPath = fs::path("imports") / (streamDBName + ".streamdb");
+
+        HAYDEN::ModelImport modelImport;
+        modelImport.OBJPath = _OBJFilePath;
+        modelImport.LWOPath = _LWOFileName.toStdString();
+        modelImport.ResourcePath = _ResourceFilePath;
+        modelImport.Material2Decl = _Material2Decl.toStdString();
+        success = Converter.ConvertOBJsToLWO(_GamePath, { modelImport }, streamDBPath, _UseYOrientation, 1) == 1;
+    }
+    else
+    {
+        success = Converter.ConvertOBJtoLWO(_GamePath, _OBJFilePath, _LWOFileName.toStdString(), _ResourceFilePath, _Material2Decl.toStdString(), _UseYOrientation);
+    }
 
     if (!success)
     {
@@ -104,7 +192,10 @@ void MainWindow::on_btnConvert_clicked()
     }
     else
     {
-        ShowInfoBox("Model converted successfully.");
+        if (patchResources)
+            ShowInfoBox("Model converted successfully.", "The .resources file has been patched with the new model header. The geometry is in " + streamDBPath.string() + ".");
+        else
+            ShowInfoBox("Model converted successfully.");
     }
     return;
 }
@@ -184,6 +275,12 @@ void MainWindow::on_btnSelectLWO_clicked()
     return;
 }
 
+void MainWindow::on_inputMaterialSearch_textChanged(const QString& searchText)
+{
+    PopulateMaterialList(searchText);
+    return;
+}
+
 void MainWindow::on_materialList_itemSelectionChanged()
 {
     QString materialName;
@@ -253,24 +350,11 @@ void MainWindow::receiveResourceInfo(const QString& lwoFile, const QString& reso
     ui->lineLWOFile->setText(lwoFile.toStdString().c_str());
     ui->labelStatusLWO->setText(labelText);
 
-    // Clear materials list (shown on next page)
-    ui->materialList->clearContents();
-    ui->materialList->setRowCount(0);
-
-    // Populate materials list (shown on next page)
-    for (int i = 0; i < meshInfo.size(); i++)
-    {
-        // Add row
-        int row_count = ui->materialList->rowCount();
-        ui->materialList->insertRow(row_count);
-
-        // Set material name
-        QString materialName = QString::fromStdString(meshInfo[i]);
-        QTableWidgetItem* tableMaterialName = new QTableWidgetItem(materialName);
-
-        // Populate Table Row
-        ui->materialList->setItem(row_count, 0, tableMaterialName);
-    }
+    // Populate materials list (shown on next page), any other material can be searched for once the index is ready
+    _LWOMaterials = meshInfo;
+    ui->inputMaterialSearch->clear();
+    PopulateMaterialList("");
+    LoadMaterialIndex();
 
     // Change material2 selection message depending on number of meshes
     if (meshInfo.size() == 1)
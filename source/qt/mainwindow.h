@@ -8,6 +8,7 @@
 #include <QThread>
 #include <QTableWidgetItem>
 
+#include "../core/MaterialDeclIndex.h"
 #include "../core/ModelConverter.h"
 
 #include "resourceform.h"
@@ -42,8 +43,15 @@ class MainWindow : public QMainWindow
         QString _Material2Decl;
         bool _UseYOrientation = 1;
 
+        // Materials used by the selected .lwo, and every material2 decl in the game for searching
+        std::vector<std::string> _LWOMaterials;
+        std::shared_ptr<const HAYDEN::MaterialDeclIndex> _MaterialIndex;
+        fs::path _MaterialIndexBasePath;
+
         void DisableGUI();
         void EnableGUI();
+        void LoadMaterialIndex();
+        void PopulateMaterialList(const QString& searchText);
 
     private slots:
         void on_btnBack_clicked();
@@ -51,6 +59,7 @@ class MainWindow : public QMainWindow
         void on_btnLoadOBJ_clicked(); 
         void on_btnNext_clicked(); 
         void on_btnSelectLWO_clicked();
+        void on_inputMaterialSearch_textChanged(const QString& searchText);
         void on_materialList_itemSelectionChanged(); 
         void on_radioOrientY_toggled(bool checked);
         void on_radioOrientZ_toggled(bool checked);
@@ -1,5 +1,14 @@
 #include "resourceform.h"
 
+#include <QPixmap>
+#include <QScrollBar>
+
+// Extra data on the name column of each row, for thumbnails
+const int ThumbnailKeyRole = Qt::UserRole + 1;
+const int StreamResourceHashRole = Qt::UserRole + 2;
+const int ThumbnailDoneRole = Qt::UserRole + 3;
+const int ThumbnailSize = 48;
+
 // Public Functions
 ResourceForm::ResourceForm(QWidget *parent)
     : QWidget(parent)
@@ -8,6 +17,24 @@ ResourceForm::ResourceForm(QWidget *parent)
     ui.btnClear->setVisible(false);
     ui.btnSearch->setEnabled(false);
     ui.btnReplaceLWO->setEnabled(false);
+
+    ui.tableWidget->setIconSize(QSize(ThumbnailSize, ThumbnailSize));
+    ui.tableWidget->verticalHeader()->setDefaultSectionSize(ThumbnailSize + 4);
+
+    // While the view moves, visible rows are requested at most every 50ms
+    _ThumbnailTimer.setSingleShot(true);
+    _ThumbnailTimer.setInterval(50);
+    connect(&_ThumbnailTimer, &QTimer::timeout, this, &ResourceForm::RequestVisibleThumbnails);
+
+    auto scheduleThumbnails = [this]()
+    {
+        if (!_ThumbnailTimer.isActive())
+            _ThumbnailTimer.start();
+    };
+
+    connect(ui.tableWidget->verticalScrollBar(), &QScrollBar::valueChanged, this, scheduleThumbnails);
+    connect(ui.tableWidget->verticalScrollBar(), &QScrollBar::rangeChanged, this, scheduleThumbnails);
+    connect(ui.tableWidget->horizontalHeader(), &QHeaderView::sortIndicatorChanged, this, scheduleThumbnails);
 }
 
 void ResourceForm::ThrowError(std::string errorMessage, std::string errorDetail)
@@ -52,6 +79,71 @@ int ResourceForm::ShowLoadStatus()
     return result;
 }
 
+void ResourceForm::RunLoadResourceThread(QThread* loadThread)
+{
+    _LoadResourceThread = loadThread;
+
+    // Thumbnails of the last load look in the wrong place for .streamdb files
+    _Thumbnails.reset();
+
+    // Rows are parsed on the loading thread and added here as they arrive, the table fills in while loading
+    BeginGUIResourceTable(false);
+
+    _LoadProgress.Begin();
+    _LoadProgress.OnBatch = [this](const fs::path& archivePath, std::shared_ptr<const HAYDEN::ResourceTable> resourceTable, uint64_t done, uint64_t total)
+    {
+        // Runs on the loading thread, rows are added on the GUI thread
+        QString qArchivePath = QString::fromStdString(archivePath.string());
+        QMetaObject::invokeMethod(this, [this, qArchivePath, resourceTable, done, total]()
+        {
+            AddLoadedResources(qArchivePath, resourceTable, done, total);
+        }, Qt::QueuedConnection);
+    };
+
+    connect(_LoadResourceThread, &QThread::finished, this, [this]()
+    {
+        if (_LoadStatusBox.isVisible())
+            _LoadStatusBox.close();
+
+        if (_LoadProgress.IsCancelled())
+        {
+            ResetGUITable();
+            ui.labelStatus->setText("Loading cancelled.");
+            _ResourceFileIsLoaded = 0;
+        }
+        else if (ModelConverter.HasResourceLoadError() == 1)
+        {
+            ThrowError(ModelConverter.GetLastErrorMessage(), ModelConverter.GetLastErrorDetail());
+            ResetGUITable();
+            ui.labelStatus->setText("Failed to load resource.");
+        }
+        else
+        {
+            EndGUIResourceTable();
+            EnableGUI();
+            StartThumbnails();
+            _ResourceFileIsLoaded = 1;
+        }
+
+        // Must enable these even if resource loading failed
+        ui.btnLoadResource->setEnabled(true);
+        ui.btnLoadAllResources->setEnabled(true);
+
+        _LoadResourceThread->deleteLater();
+        _LoadResourceThread = NULL;
+    });
+
+    ui.labelStatus->setText("Loading resource...");
+    _LoadResourceThread->start();
+
+    // Cancelling only asks the loader to stop, it finishes its current chunk and exits on its own
+    if (ShowLoadStatus() == 0x00400000 && _LoadResourceThread != NULL && _LoadResourceThread->isRunning()) // CANCEL
+    {
+        _LoadProgress.Cancellation.Cancel();
+        ui.labelStatus->setText("Cancelling...");
+    }
+}
+
 void ResourceForm::DisableGUI()
 {
     ui.inputSearch->clear();
@@ -59,6 +151,7 @@ void ResourceForm::DisableGUI()
     ui.btnSearch->setEnabled(false);
     ui.btnReplaceLWO->setEnabled(false);
     ui.btnLoadResource->setEnabled(false);
+    ui.btnLoadAllResources->setEnabled(false);
     ui.tableWidget->setEnabled(false);
     return;
 }
@@ -69,6 +162,7 @@ void ResourceForm::EnableGUI()
     ui.btnSearch->setEnabled(true);
     ui.btnReplaceLWO->setEnabled(true);
     ui.btnLoadResource->setEnabled(true);
+    ui.btnLoadAllResources->setEnabled(true);
     ui.tableWidget->setEnabled(true);
     return;
 }
@@ -84,66 +178,100 @@ void ResourceForm::ResetGUITable()
     return;
 }
 
-void ResourceForm::PopulateGUIResourceTable(std::vector<std::string> searchWords)
+bool ResourceForm::IsListedResource(const HAYDEN::ResourceEntry& resourceEntry, const std::vector<std::string>& searchWords)
 {
-    // Must disable sorting or rows won't populate correctly
-    ui.tableWidget->setSortingEnabled(false);
+    // Filter out anything we didn't search for
+    for (int j = 0; j < searchWords.size(); j++)
+        if (resourceEntry.Name.find(searchWords[j]) == -1)
+            return 0;
 
-    // Clear any existing contents
-    ui.tableWidget->clearContents();
-    ui.tableWidget->setRowCount(0);
-    _ViewIsFiltered = 0;
+    // Filter out unsupported .lwo
+    if (resourceEntry.Name.rfind("world_") != -1 && (resourceEntry.Name.find("maps/game") != -1))
+        return 0;
+
+    if (resourceEntry.Name.rfind(".bmodel") != -1)
+        return 0;
+
+    if (resourceEntry.Name.rfind(".vpaint") != -1)
+        return 0;
+
+    return 1;
+}
+
+void ResourceForm::AddGUIResourceRows(const HAYDEN::ResourceTable& resourceTable, const QString& archivePath, const std::vector<std::string>& searchWords)
+{
+    QString archiveName = QString::fromStdString(fs::path(archivePath.toStdString()).filename().string());
 
-    // Load resource file data
-    std::vector<HAYDEN::ResourceEntry> resourceData = ModelConverter.GetResourceData();
-    for (int i = 0; i < resourceData.size(); i++)
+    // Search for .LWO files ONLY - SERAPHIM
+    std::vector<HAYDEN::ResourceEntry> listedEntries;
+    for (uint32_t i : resourceTable.FindByVersion(67))
     {
+        HAYDEN::ResourceEntry resourceEntry = resourceTable.GetEntry(i);
+        if (IsListedResource(resourceEntry, searchWords))
+            listedEntries.push_back(resourceEntry);
+    }
 
-        // Search for .LWO files ONLY - SERAPHIM
-        if (resourceData[i].Version != 67)
-            continue;
+    // Add all rows at once instead of one insertRow per entry
+    int firstRow = ui.tableWidget->rowCount();
+    ui.tableWidget->setRowCount(firstRow + (int)listedEntries.size());
 
-        // Filter out anything we didn't search for
-        if (searchWords.size() > 0)
-        {
-            _ViewIsFiltered = 1;
-            bool matched = 1;
+    for (int i = 0; i < listedEntries.size(); i++)
+    {
+        // Set Resource Name, keep the full archive path for when this row is selected
+        QString qResourceName = QString::fromUtf8(listedEntries[i].Name.data(), (int)listedEntries[i].Name.size());
+        QTableWidgetItem* tableResourceName = new QTableWidgetItem(qResourceName);
+        tableResourceName->setData(Qt::UserRole, archivePath);
+        tableResourceName->setData(ThumbnailKeyRole, QVariant::fromValue<qulonglong>(HAYDEN::getThumbnailKey(listedEntries[i])));
+        tableResourceName->setData(StreamResourceHashRole, QVariant::fromValue<qulonglong>(listedEntries[i].StreamResourceHash));
 
-            for (int j = 0; j < searchWords.size(); j++)
-                if (resourceData[i].Name.find(searchWords[j]) == -1)
-                    matched = 0;
+        // Set Archive Name
+        QTableWidgetItem* tableArchiveName = new QTableWidgetItem(archiveName);
 
-            if (matched == 0)
-                continue;
-        }
+        // Populate Table Row
+        ui.tableWidget->setItem(firstRow + i, 0, tableResourceName);
+        ui.tableWidget->setItem(firstRow + i, 1, tableArchiveName);
+    }
+    return;
+}
 
-        // Filter out unsupported .lwo
-        if (resourceData[i].Version == 67)
-        {
-            if (resourceData[i].Name.rfind("world_") != -1 && (resourceData[i].Name.find("maps/game") != -1))
-                continue;
+void ResourceForm::AddLoadedResources(const QString& archivePath, std::shared_ptr<const HAYDEN::ResourceTable> resourceTable, uint64_t done, uint64_t total)
+{
+    // Batches still queued when a load is cancelled are dropped
+    if (_LoadProgress.IsCancelled())
+        return;
 
-            if (resourceData[i].Name.rfind(".bmodel") != -1)
-                continue;
+    AddGUIResourceRows(*resourceTable, archivePath, std::vector<std::string>());
 
-            if (resourceData[i].Name.rfind(".vpaint") != -1)
-                continue;
-        }
+    QString progressText = "Loading resource... " + QString::number(done) + " / " + QString::number(total);
+    ui.labelStatus->setText(progressText);
+    _LoadStatusBox.setText(progressText);
+    return;
+}
 
-        int row_count = ui.tableWidget->rowCount();
-        ui.tableWidget->insertRow(row_count);
+void ResourceForm::BeginGUIResourceTable(bool isFiltered)
+{
+    // Must disable sorting or rows won't populate correctly
+    ui.tableWidget->setSortingEnabled(false);
 
-        // Set Resource Name
-        std::string resourceName = resourceData[i].Name;
-        QString qResourceName = QString::fromStdString(resourceName);
-        QTableWidgetItem *tableResourceName = new QTableWidgetItem(qResourceName);
+    // Clear any existing contents
+    ui.tableWidget->clearContents();
+    ui.tableWidget->setRowCount(0);
+    _ViewIsFiltered = isFiltered;
 
-        // Populate Table Row
-        ui.tableWidget->setItem(row_count, 0, tableResourceName);
+    if (_Thumbnails)
+        _Thumbnails->Cancel();
+    return;
+}
+
+void ResourceForm::EndGUIResourceTable()
+{
+    QString labelText = "Found " + QString::number(ui.tableWidget->rowCount()) + " files.";
+    if (ModelConverter.HasGlobalIndex())
+    {
+        QString archiveCount = QString::number(ModelConverter.GetGlobalIndex().GetNumArchives());
+        labelText = "Found " + QString::number(ui.tableWidget->rowCount()) + " files in " + archiveCount + " archives.";
     }
 
-    QString labelCount = QString::number(ui.tableWidget->rowCount());
-    QString labelText = "Found " + labelCount + " files.";
     ui.labelStatus->setText(labelText);
 
     // Enable sorting again
@@ -151,6 +279,33 @@ void ResourceForm::PopulateGUIResourceTable(std::vector<std::string> searchWords
 
     QHeaderView* tableHeader = ui.tableWidget->horizontalHeader();
     tableHeader->setSectionResizeMode(0, QHeaderView::Stretch);
+    tableHeader->setSectionResizeMode(1, QHeaderView::ResizeToContents);
+
+    _ThumbnailTimer.start();
+    return;
+}
+
+void ResourceForm::PopulateGUIResourceTable(std::vector<std::string> searchWords)
+{
+    BeginGUIResourceTable(searchWords.size() > 0);
+
+    if (ModelConverter.HasGlobalIndex())
+    {
+        // Load resource data from every archive
+        const HAYDEN::GlobalResourceIndex& globalIndex = ModelConverter.GetGlobalIndex();
+        for (uint32_t i = 0; i < globalIndex.GetNumArchives(); i++)
+        {
+            QString qArchivePath = QString::fromStdString(globalIndex.GetArchivePath(i).string());
+            AddGUIResourceRows(globalIndex.GetArchive(i).ParseResourceFile(), qArchivePath, searchWords);
+        }
+    }
+    else
+    {
+        // Only .lwo entries were parsed for this table
+        AddGUIResourceRows(*ModelConverter.GetModelData(), QString::fromStdString(_ResourcePath), searchWords);
+    }
+
+    EndGUIResourceTable();
     return;
 }
 
@@ -176,6 +331,102 @@ std::vector<std::string> ResourceForm::SplitSearchTerms(std::string inputString)
     return searchWords;
 }
 
+void ResourceForm::StartThumbnails()
+{
+    // Rendered on background threads, set on the GUI thread
+    _Thumbnails = std::make_unique<HAYDEN::ThumbnailCache>(ModelConverter.GetBasePath(), ThumbnailSize);
+    _Thumbnails->OnThumbnail = [this](uint64_t key, std::shared_ptr<const HAYDEN::Thumbnail> thumbnail)
+    {
+        QMetaObject::invokeMethod(this, [this, key, thumbnail]()
+        {
+            SetThumbnail(key, thumbnail);
+        }, Qt::QueuedConnection);
+    };
+
+    RequestVisibleThumbnails();
+    return;
+}
+
+void ResourceForm::GetThumbnailRows(int& firstRow, int& lastRow)
+{
+    // Rows on screen, then as many again below, so the next page is usually ready before it's scrolled to
+    int rowCount = ui.tableWidget->rowCount();
+    firstRow = std::max(ui.tableWidget->rowAt(0), 0);
+    lastRow = ui.tableWidget->rowAt(ui.tableWidget->viewport()->height() - 1);
+
+    if (lastRow < 0)
+        lastRow = rowCount - 1;
+
+    lastRow = std::min(lastRow + (lastRow - firstRow + 1), rowCount - 1);
+    return;
+}
+
+void ResourceForm::RequestVisibleThumbnails()
+{
+    if (!_Thumbnails || ui.tableWidget->rowCount() == 0)
+        return;
+
+    int firstRow = 0;
+    int lastRow = 0;
+    GetThumbnailRows(firstRow, lastRow);
+
+    // Replaces whatever was requested before, rows scrolled past are dropped
+    std::vector<HAYDEN::ThumbnailRequest> requests;
+    for (int row = firstRow; row <= lastRow; row++)
+    {
+        QTableWidgetItem* item = ui.tableWidget->item(row, 0);
+        if (item == NULL || item->data(ThumbnailDoneRole).toBool())
+            continue;
+
+        HAYDEN::ThumbnailRequest request;
+        request.Key = item->data(ThumbnailKeyRole).toULongLong();
+        request.StreamResourceHash = item->data(StreamResourceHashRole).toULongLong();
+        request.ArchivePath = item->data(Qt::UserRole).toString().toStdString();
+        request.EntryName = item->text().toStdString();
+        requests.push_back(std::move(request));
+    }
+
+    _Thumbnails->Request(std::move(requests));
+    return;
+}
+
+void ResourceForm::SetThumbnail(quint64 key, std::shared_ptr<const HAYDEN::Thumbnail> thumbnail)
+{
+    QIcon icon;
+    if (!thumbnail->Empty())
+    {
+        QImage image((int)thumbnail->Size, (int)thumbnail->Size, QImage::Format_ARGB32);
+        for (uint32_t y = 0; y < thumbnail->Size; y++)
+        {
+            QRgb* line = (QRgb*)image.scanLine((int)y);
+            const uint8_t* pixels = thumbnail->Pixels.data() + (size_t)y * thumbnail->Size * 2;
+
+            for (uint32_t x = 0; x < thumbnail->Size; x++)
+                line[x] = qRgba(pixels[x * 2], pixels[x * 2], pixels[x * 2], pixels[x * 2 + 1]);
+        }
+
+        icon = QIcon(QPixmap::fromImage(image));
+    }
+
+    // Only rows near the view are checked. Rows that scrolled away ask again when they're back, and get it from disk.
+    int firstRow = 0;
+    int lastRow = 0;
+    GetThumbnailRows(firstRow, lastRow);
+
+    for (int row = firstRow; row <= lastRow; row++)
+    {
+        QTableWidgetItem* item = ui.tableWidget->item(row, 0);
+        if (item == NULL || item->data(ThumbnailKeyRole).toULongLong() != key || item->data(ThumbnailDoneRole).toBool())
+            continue;
+
+        if (!icon.isNull())
+            item->setIcon(icon);
+
+        item->setData(ThumbnailDoneRole, true);
+    }
+    return;
+}
+
 // Private Slots
 void ResourceForm::on_btnClear_clicked()
 {
@@ -194,36 +445,22 @@ void ResourceForm::on_btnLoadResource_clicked()
         _ResourcePath = fileName.toStdString();
 
         DisableGUI();
-        _LoadResourceThread = QThread::create(&HAYDEN::ModelConverter::LoadResource, &ModelConverter, _ResourcePath);
+        RunLoadResourceThread(QThread::create([this]() { ModelConverter.LoadResource(_ResourcePath, &_LoadProgress); }));
+    }
+}
 
-        connect(_LoadResourceThread, &QThread::finished, this, [this]()
-        {
-            if (_LoadStatusBox.isVisible())
-                _LoadStatusBox.close();
-
-            if (ModelConverter.HasResourceLoadError() == 1)
-            {
-                ThrowError(ModelConverter.GetLastErrorMessage(), ModelConverter.GetLastErrorDetail());
-                ResetGUITable();
-                ui.labelStatus->setText("Failed to load resource.");
-            }
-
-            if (ModelConverter.HasResourceLoadError() == 0)
-            {
-                PopulateGUIResourceTable();
-                EnableGUI();
-                _ResourceFileIsLoaded = 1;
-            }
-
-            // Must enable this even if resource loading failed
-            ui.btnLoadResource->setEnabled(true);
-        });
+void ResourceForm::on_btnLoadAllResources_clicked()
+{
+    const QString directoryName = QFileDialog::getExistingDirectory(this, "Select your Doom Eternal directory");
+
+    if (!directoryName.isEmpty())
+    {
+        _ResourcePath.clear();
 
-        ui.labelStatus->setText("Loading resource...");
-        _LoadResourceThread->start();
+        std::string basePath = directoryName.toStdString();
 
-        if (ShowLoadStatus() == 0x00400000 && _LoadResourceThread->isRunning()) // CANCEL
-            _LoadResourceThread->terminate();
+        DisableGUI();
+        RunLoadResourceThread(QThread::create([this, basePath]() { ModelConverter.LoadAllResources(basePath, &_LoadProgress); }));
     }
 }
 
@@ -237,9 +474,10 @@ void ResourceForm::on_btnReplaceLWO_clicked()
         return;
     }
 
-    // Send our LWO name and resource path to mainwindow object
-    LWOFileName = itemExportQList[0]->text();
-    QString ResourceFilePath = QString(_ResourcePath.c_str());
+    // Send our LWO name and the archive it came from to mainwindow object
+    QTableWidgetItem* selectedItem = ui.tableWidget->item(itemExportQList[0]->row(), 0);
+    LWOFileName = selectedItem->text();
+    QString ResourceFilePath = selectedItem->data(Qt::UserRole).toString();
     EmitResourceInfo(LWOFileName, ResourceFilePath);
 
     return;
@@ -5,9 +5,11 @@
 #include <QFileDialog>
 #include <QMessageBox>
 #include <QThread>
+#include <QTimer>
 #include <QTableWidgetItem>
 
 #include "../core/ModelConverter.h"
+#include "../core/ThumbnailCache.h"
 
 #include "ui_resourceform.h"
 
@@ -27,20 +29,34 @@ class ResourceForm : public QWidget
         HAYDEN::ModelConverter ModelConverter;
         QMessageBox _LoadStatusBox;
         QThread* _LoadResourceThread = NULL;
+        HAYDEN::ResourceLoadProgress _LoadProgress;
         std::string _ResourcePath;
         bool _ResourceFileIsLoaded = 0;
         bool _ViewIsFiltered = 0;
+        std::unique_ptr<HAYDEN::ThumbnailCache> _Thumbnails;
+        QTimer _ThumbnailTimer;
 
         int  ShowLoadStatus();
         void DisableGUI();
         void EnableGUI();
         void ResetGUITable();
+        void RunLoadResourceThread(QThread* loadThread);
+        bool IsListedResource(const HAYDEN::ResourceEntry& resourceEntry, const std::vector<std::string>& searchWords);
+        void AddGUIResourceRows(const HAYDEN::ResourceTable& resourceTable, const QString& archivePath, const std::vector<std::string>& searchWords);
+        void AddLoadedResources(const QString& archivePath, std::shared_ptr<const HAYDEN::ResourceTable> resourceTable, uint64_t done, uint64_t total);
+        void BeginGUIResourceTable(bool isFiltered);
+        void EndGUIResourceTable();
         void PopulateGUIResourceTable(std::vector<std::string> searchWords = std::vector<std::string>());
         std::vector<std::string> SplitSearchTerms(std::string inputString);
+        void StartThumbnails();
+        void GetThumbnailRows(int& firstRow, int& lastRow);
+        void RequestVisibleThumbnails();
+        void SetThumbnail(quint64 key, std::shared_ptr<const HAYDEN::Thumbnail> thumbnail);
 
     private slots:
         void on_btnClear_clicked();
         void on_btnLoadResource_clicked();
+        void on_btnLoadAllResources_clicked();
         void on_btnReplaceLWO_clicked();
         void on_btnSearch_clicked();
         void on_inputSearch_returnPressed();